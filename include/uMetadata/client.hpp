@@ -1,11 +1,15 @@
 #ifndef UMETADATA_CLIENT_HPP
 #define UMETADATA_CLIENT_HPP
+#include <functional>
 #include <string>
+#include <utility>
 #include <vector>
 #include <memory>
+#include <optional>
 namespace UMetadata
 {
   class Station;
+  class Channel;
 }
 
 namespace UMetadata
@@ -13,11 +17,44 @@ namespace UMetadata
 
 class Client
 {
+public:
     /// @brief Initializes a metadata client at the given end point.
     /// @note This will be a non-secured connection.
     explicit Client(const std::string &endPoint);
 
+    /// @brief Gets the currently active stations.  The last result and its
+    ///        inventory version are kept so that, if the inventory has not
+    ///        changed, the server replies without resending it.
     [[nodiscard]] std::vector<UMetadata::Station> getAllActiveStations() const;
+    /// @brief Gets several currently active stations in one request.
+    /// @param[in] stations  The network and name of each station.
+    /// @result The stations that are active.  Stations that could not be
+    ///         found are omitted.
+    /// @throws std::runtime_error if the request fails.
+    [[nodiscard]] std::vector<UMetadata::Station> getActiveStations(const std::vector<std::pair<std::string, std::string>> &stations) const;
+    /// @brief Streams the currently active stations from the server a page
+    ///        at a time so that the full inventory is never held in memory.
+    /// @param[in] visitor  Called for each station as its page arrives.
+    /// @throws std::invalid_argument if the visitor is not callable.
+    /// @throws std::runtime_error if the request fails.  If the visitor
+    ///         throws then the request is cancelled and the exception
+    ///         propagates.
+    void forEachActiveStation(const std::function<void (const UMetadata::Station &)> &visitor) const;
+
+    /// @brief Gets the currently active channels.  Like the stations, the
+    ///        last result is kept so that an unchanged inventory is not
+    ///        resent.
+    /// @throws std::runtime_error if the request fails.
+    [[nodiscard]] std::vector<UMetadata::Channel> getAllActiveChannels() const;
+    /// @brief Gets a currently active channel.
+    /// @param[in] network       The network code, e.g., UU.
+    /// @param[in] station       The station name, e.g., CTU.
+    /// @param[in] channel       The channel name, e.g., HHZ.
+    /// @param[in] locationCode  The location code, e.g., 01.  If the channel
+    ///                          has none then this can be blank or --.
+    /// @result The channel or std::nullopt if it is not active.
+    /// @throws std::runtime_error if the request fails.
+    [[nodiscard]] std::optional<UMetadata::Channel> getActiveChannel(const std::string &network, const std::string &station, const std::string &channel, const std::string &locationCode = "--") const;
 
     ~Client();
 
@@ -1,26 +1,279 @@
 #ifndef UMETADATA_DATABASE_HPP
 #define UMETADATA_DATABASE_HPP
+#include <chrono>
+#include <coroutine>
+#include <cstdint>
+#include <exception>
 #include <filesystem>
+#include <functional>
 #include <memory>
 #include <optional>
+#include <string>
+#include <utility>
 #include <vector>
+namespace UMetadataAPI::V1
+{
+  class StationsResponse;
+  class ChannelsResponse;
+}
 namespace UMetadata
 {
 
 class Station;
+class Channel;
+class DatabaseOptions;
 
 class Database
 {
+public:
+    /// @brief The optional station columns selected by a field mask.  The
+    ///        network and name are always returned.  Combine these with a
+    ///        bitwise or.
+    enum StationColumn : uint32_t
+    {
+        Latitude = 1U << 0U,      /*!< The latitude. */
+        Longitude = 1U << 1U,     /*!< The longitude. */
+        Elevation = 1U << 2U,     /*!< The elevation. */
+        StartTime = 1U << 3U,     /*!< The epoch's start time. */
+        EndTime = 1U << 4U,       /*!< The epoch's end time. */
+        LastModified = 1U << 5U,  /*!< The last modification time. */
+        Description = 1U << 6U,   /*!< The description. */
+        AllStationColumns = (1U << 7U) - 1U /*!< Every column. */
+    };
+    /// @brief Tallies the station epochs reconciled by an upsert.
+    struct UpsertSummary
+    {
+        size_t inserted{0};  /*!< Epochs that were not in the database. */
+        size_t changed{0};   /*!< Epochs whose information was updated. */
+        size_t closed{0};    /*!< Epochs whose only change is an earlier
+                                  end time. */
+        size_t unchanged{0}; /*!< Epochs that were identical or not newer
+                                  than those in the database. */
+        size_t skipped{0};   /*!< Stations lacking a required property. */
+    };
+    /// @brief The time the calling thread has spent in each stage of its
+    ///        queries.
+    struct QueryProfile
+    {
+        std::chrono::nanoseconds step{0};   /*!< Time in sqlite3_step. */
+        std::chrono::nanoseconds unpack{0}; /*!< Time decoding rows. */
+        uint64_t rows{0};                   /*!< Rows decoded. */
+    };
+    /// @brief Awaits a query that runs on the database's asynchronous query
+    ///        threads, e.g.,
+    ///        auto stations = co_await database.getAllActiveStationsAsync();
+    ///        The query starts when it is awaited.  If it throws then the
+    ///        exception is rethrown from co_await.
+    /// @note The awaiting coroutine is resumed on the query thread so it
+    ///       should hand lengthy work elsewhere rather than hold the thread.
+    template<typename T>
+    class [[nodiscard]] Awaitable
+    {
+    public:
+        [[nodiscard]] bool await_ready() const noexcept
+        {
+            return false;
+        }
+        void await_suspend(std::coroutine_handle<> handle)
+        {
+            mDatabase->submit([this, handle]()
+            {
+                try
+                {
+                    mResult.emplace(mQuery());
+                }
+                catch (...)
+                {
+                    mException = std::current_exception();
+                }
+                handle.resume();
+            });
+        }
+        T await_resume()
+        {
+            if (mException){std::rethrow_exception(mException);}
+            return std::move(*mResult);
+        }
+    private:
+        friend class Database;
+        Awaitable(const Database *database, std::function<T ()> query) :
+            mDatabase(database),
+            mQuery(std::move(query))
+        {
+        }
+        const Database *mDatabase{nullptr};
+        std::function<T ()> mQuery;
+        std::optional<T> mResult;
+        std::exception_ptr mException{nullptr};
+    };
 public:
     Database() = delete;
     Database(const std::filesystem::path &fileName,
              bool openReadOnly);
+    /// @brief Opens the database with the given connection options.
+    /// @param[in] fileName      The SQLite3 database file.
+    /// @param[in] openReadOnly  True opens the database in read-only mode.
+    /// @param[in] options       The journaling and busy-handling options.
+    Database(const std::filesystem::path &fileName,
+             bool openReadOnly,
+             const DatabaseOptions &options);
 
     [[nodiscard]] std::vector<Station> getAllActiveStations() const;
+    /// @brief Gets the stations that were active at the given time.  This is
+    ///        resolved with an interval index on the station epochs.
+    /// @param[in] time  The UTC time in seconds since the epoch.
+    /// @result The stations whose start time <= time <= end time.
+    [[nodiscard]] std::vector<Station> getStationsActiveAt(const std::chrono::seconds &time) const;
+    /// @brief Visits the currently active stations one row at a time.
+    /// @param[in] visitor  Called for each station while the query is still
+    ///                     stepping.  The station is reused between calls so
+    ///                     the visitor must copy anything it wishes to keep.
+    /// @note A database connection is held until the visit completes.  If
+    ///       the visitor throws then the query is abandoned and the exception
+    ///       propagates.
+    void forEachActiveStation(const std::function<void (const Station &)> &visitor) const;
+    /// @brief Visits the stations that were active at the given time one row
+    ///        at a time.
+    /// @param[in] time     The UTC time in seconds since the epoch.
+    /// @param[in] visitor  Called for each station with start time <= time
+    ///                     <= end time.  The station is reused between calls.
+    /// @throws std::invalid_argument if the visitor is not callable.
+    void forEachStationActiveAt(const std::chrono::seconds &time, const std::function<void (const Station &)> &visitor) const;
+    /// @brief Appends the currently active stations to a gRPC response.
+    ///        The rows are decoded directly into the response's messages
+    ///        so, if the response lives on an arena, so will the stations.
+    /// @param[in,out] response  On exit, the active stations are appended
+    ///                          to the response's stations.
+    /// @throws std::invalid_argument if the response is NULL.
+    void appendActiveStations(UMetadataAPI::V1::StationsResponse *response) const;
+    /// @brief Appends the stations that were active at the given time to a
+    ///        gRPC response.
+    /// @param[in] time          The UTC time in seconds since the epoch.
+    /// @param[in,out] response  On exit, the stations active at the given
+    ///                          time are appended to the response's stations.
+    /// @throws std::invalid_argument if the response is NULL.
+    void appendStationsActiveAt(const std::chrono::seconds &time, UMetadataAPI::V1::StationsResponse *response) const;
+    /// @brief Gets the active stations in a latitude/longitude box.
+    /// @param[in] minimumLatitude   The southern edge of the box in degrees.
+    /// @param[in] maximumLatitude   The northern edge of the box in degrees.
+    /// @param[in] minimumLongitude  The western edge of the box in degrees.
+    /// @param[in] maximumLongitude  The eastern edge of the box in degrees.
+    ///                              If this is less than the minimum longitude
+    ///                              then the box crosses the antimeridian.
+    /// @throws std::invalid_argument if the latitudes are out of range.
+    [[nodiscard]] std::vector<Station> getActiveStationsInBoundingBox(double minimumLatitude, double maximumLatitude, double minimumLongitude, double maximumLongitude) const;
+    /// @brief Gets the active stations within a great-circle distance of
+    ///        a point - e.g., an epicenter.
+    /// @param[in] latitude   The point's latitude in degrees.
+    /// @param[in] longitude  The point's longitude in degrees.
+    /// @param[in] radius     The search radius in kilometers.
+    /// @throws std::invalid_argument if the latitude is out of range or the
+    ///         radius is negative.
+    [[nodiscard]] std::vector<Station> getActiveStationsWithinRadius(double latitude, double longitude, double radius) const;
+    /// @brief Asynchronously gets the currently active stations.
+    [[nodiscard]] Awaitable<std::vector<Station>> getAllActiveStationsAsync() const;
+    /// @brief Asynchronously gets the stations that were active at the
+    ///        given time.
+    /// @param[in] time  The UTC time in seconds since the epoch.
+    [[nodiscard]] Awaitable<std::vector<Station>> getStationsActiveAtAsync(const std::chrono::seconds &time) const;
+    /// @brief Asynchronously gets a currently active station.
+    /// @param[in] network  The network code, e.g., UU.
+    /// @param[in] name     The station name, e.g., CTU.
+    [[nodiscard]] Awaitable<std::optional<Station>> getActiveStationInformationAsync(const std::string &network, const std::string &name) const;
+    /// @brief Asynchronously gets the active stations in a latitude/longitude
+    ///        box.
+    /// @throws std::invalid_argument from co_await if the latitudes are out
+    ///         of range.
+    [[nodiscard]] Awaitable<std::vector<Station>> getActiveStationsInBoundingBoxAsync(double minimumLatitude, double maximumLatitude, double minimumLongitude, double maximumLongitude) const;
+    /// @brief Asynchronously gets the active stations within a great-circle
+    ///        distance, in kilometers, of a point.
+    /// @throws std::invalid_argument from co_await if the latitude is out of
+    ///         range or the radius is negative.
+    [[nodiscard]] Awaitable<std::vector<Station>> getActiveStationsWithinRadiusAsync(double latitude, double longitude, double radius) const;
+    /// @result A counter that changes whenever another connection, possibly
+    ///         in another process, commits a change to the database.  This
+    ///         is cheap enough to poll to detect that a cache is stale.
+    [[nodiscard]] int64_t getDataVersion() const;
+    /// @brief Enables or disables timing the steps and rows of every query.
+    ///        This is off by default since it reads the clock per row.
+    /// @note The rows decoded are counted either way.
+    static void setQueryProfiling(bool enabled) noexcept;
+    /// @result True indicates queries are being timed.
+    [[nodiscard]] static bool isQueryProfiling() noexcept;
+    /// @result The time the calling thread has spent stepping queries and
+    ///         decoding rows since its last call.  The thread's profile is
+    ///         then reset.  Each thread keeps its own profile so this never
+    ///         contends with other threads.  The times are zero unless
+    ///         query profiling is enabled.
+    [[nodiscard]] static QueryProfile takeQueryProfile() noexcept;
+    /// @param[in] time  The UTC time in seconds since the epoch.
+    /// @result The first time after the given time at which a station or
+    ///         channel epoch opens or closes, i.e., when the active set next
+    ///         changes even if the database does not.  If no epoch opens or
+    ///         closes after the given time then this is std::nullopt.
+    [[nodiscard]] std::optional<std::chrono::seconds> getNextEpochBoundary(const std::chrono::seconds &time) const;
     [[nodiscard]] std::optional<Station> getActiveStationInformation(const std::string &network, const std::string &name) const;
+    /// @brief Inserts the stations in a single transaction.  Stations whose
+    ///        network, name, and start time already exist are skipped, as
+    ///        are stations lacking a required property, so that one bad
+    ///        station does not fail the whole batch.
     void insert(const std::vector<Station> &stations);
+    /// @brief Inserts a station.  If the station exists it is skipped.
     void insert(const Station &station);
+    /// @brief Reconciles the stations with the database in a single
+    ///        transaction.  New epochs are inserted.  An epoch already in the
+    ///        database, i.e., with the same network, name, and start time, is
+    ///        updated only if the incoming station's last modified time is
+    ///        more recent and its information differs.  Epochs in the
+    ///        database that are absent from the stations are left alone.
+    ///        Stations lacking a required property are logged and skipped
+    ///        rather than failing the whole reconciliation.
+    /// @param[in] stations  The stations to reconcile.
+    /// @result A tally of what was inserted and updated.
+    /// @throws std::runtime_error if the database is not read-write.
+    UpsertSummary upsert(const std::vector<Station> &stations);
+
+    /// @brief Inserts the channels in a single transaction.  Each channel is
+    ///        attached to the station epoch, with the same network and
+    ///        station name, that contains the channel's start time.
+    ///        Channels without such a station or whose network, station,
+    ///        name, location code, and start time already exist are skipped.
+    /// @throws std::runtime_error if the database is not read-write or
+    ///         a channel lacks a required property.
+    void insert(const std::vector<Channel> &channels);
+    /// @brief Inserts a channel.  If the channel exists it is skipped.
+    void insert(const Channel &channel);
+    /// @param[in] network       The network code, e.g., UU.
+    /// @param[in] station       The station name, e.g., CTU.
+    /// @param[in] channel       The channel name, e.g., HHZ.
+    /// @param[in] locationCode  The location code, e.g., 01, or -- if the
+    ///                          channel has none.  A blank location code is
+    ///                          treated as --.
+    /// @result The currently active channel or std::nullopt if there is none.
+    /// @throws std::invalid_argument if the network, station, or channel is
+    ///         empty.
+    [[nodiscard]] std::optional<Channel> getActiveChannelInformation(const std::string &network, const std::string &station, const std::string &channel, const std::string &locationCode) const;
+    /// @result The currently active channels.
+    [[nodiscard]] std::vector<Channel> getAllActiveChannels() const;
+    /// @param[in] time  The UTC time in seconds since the epoch.
+    /// @result The channels with start time <= time <= end time.
+    [[nodiscard]] std::vector<Channel> getChannelsActiveAt(const std::chrono::seconds &time) const;
+    /// @brief Asynchronously gets the currently active channels.
+    [[nodiscard]] Awaitable<std::vector<Channel>> getAllActiveChannelsAsync() const;
+    /// @brief Asynchronously gets a currently active channel.
+    [[nodiscard]] Awaitable<std::optional<Channel>> getActiveChannelInformationAsync(const std::string &network, const std::string &station, const std::string &channel, const std::string &locationCode) const;
+    /// @brief Appends the currently active channels to a gRPC response.
+    /// @throws std::invalid_argument if the response is NULL.
+    void appendActiveChannels(UMetadataAPI::V1::ChannelsResponse *response) const;
+    /// @brief Appends the channels that were active at the given time to a
+    ///        gRPC response.  The rows are decoded directly into the
+    ///        response's messages.
+    /// @throws std::invalid_argument if the response is NULL.
+    void appendChannelsActiveAt(const std::chrono::seconds &time, UMetadataAPI::V1::ChannelsResponse *response) const;
 
+    /// @brief Closes the database.  Queued asynchronous queries are run,
+    ///        and their coroutines resumed, first so this must not be called
+    ///        from a coroutine resumed by the database.
     void close();
 
     ~Database();
@@ -28,6 +281,9 @@ public:
     Database& operator=(const Database &) = delete;
     Database& operator=(Database &&) noexcept = delete;
 private:
+    /// @brief Queues work on the asynchronous query threads.
+    /// @throws std::runtime_error if the database is closed.
+    void submit(std::function<void ()> &&work) const;
     class DatabaseImpl;
     std::unique_ptr<DatabaseImpl> pImpl;
 };
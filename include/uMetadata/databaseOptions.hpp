@@ -0,0 +1,129 @@
+#ifndef UMETADATA_DATABASE_OPTIONS_HPP
+#define UMETADATA_DATABASE_OPTIONS_HPP
+#include <chrono>
+#include <cstdint>
+#include <memory>
+
+namespace UMetadata
+{
+
+/// @class DatabaseOptions "databaseOptions.hpp" "uMetadata/databaseOptions.hpp"
+/// @brief Defines how the SQLite3 metadata database is opened and operated.
+/// @copyright Ben Baker (UUSS) distributed under the NO AI MIT license.
+class DatabaseOptions
+{
+public:
+    /// @brief The journaling mode used by read-write connections.
+    enum class JournalMode
+    {
+        Delete, /*!< The traditional rollback journal.  A writer blocks
+                     readers while it commits. */
+        WAL     /*!< Write-ahead logging.  Readers continue to read the last
+                     committed snapshot while a writer commits. */
+    };
+    /// @brief Defines how a read-only database is served.
+    enum class ServingMode
+    {
+        File,         /*!< Pages are read through the VFS and SQLite's page
+                           cache. */
+        MemoryMapped, /*!< The database file is memory-mapped so that pages
+                           are read directly from the OS page cache. */
+        InMemory      /*!< The database is copied into RAM when it is opened
+                           so queries never touch the filesystem.  Changes
+                           made to the file afterwards are not seen. */
+    };
+public:
+    /// @brief Constructor.
+    DatabaseOptions();
+    /// @brief Copy constructor.
+    /// @param[in] options  The options from which to construct this class.
+    DatabaseOptions(const DatabaseOptions &options);
+    /// @brief Move constructor.
+    /// @param[in,out] options  The options from which to construct this class.
+    ///                         On exit, options's behavior is undefined.
+    DatabaseOptions(DatabaseOptions &&options) noexcept;
+
+    /// @brief Sets the journal mode.  This is applied when the database is
+    ///        opened in read-write mode and persists in the database file so
+    ///        that read-only connections inherit it.
+    /// @param[in] mode  The journal mode.
+    void setJournalMode(JournalMode mode) noexcept;
+    /// @result The journal mode.  By default this is WAL.
+    [[nodiscard]] JournalMode getJournalMode() const noexcept;
+
+    /// @brief Sets the amount of time a connection will wait on a lock held
+    ///        by another connection before the query is retried or fails.
+    /// @param[in] timeout  The busy timeout.
+    /// @throws std::invalid_argument if the timeout is negative.
+    void setBusyTimeout(const std::chrono::milliseconds &timeout);
+    /// @result The busy timeout.  By default this is 5 seconds.
+    [[nodiscard]] std::chrono::milliseconds getBusyTimeout() const noexcept;
+
+    /// @brief Sets the maximum number of connections in the read-only
+    ///        connection pool.  Each concurrent query checks out its own
+    ///        connection so this should be at least the number of threads
+    ///        that query the database.
+    /// @param[in] poolSize  The maximum number of read-only connections.
+    /// @throws std::invalid_argument if the pool size is not positive.
+    /// @note Read-write databases always use a single connection.
+    void setReadConnectionPoolSize(int poolSize);
+    /// @result The maximum number of read-only connections.  By default this
+    ///         is the number of hardware threads.
+    [[nodiscard]] int getReadConnectionPoolSize() const noexcept;
+
+    /// @brief Sets the number of threads that run the asynchronous queries.
+    ///        Each thread has a read-only connection of its own so these
+    ///        queries do not compete with synchronous callers for the
+    ///        connection pool.  The threads are started by the first
+    ///        asynchronous query.
+    /// @param[in] nThreads  The number of asynchronous query threads.
+    /// @throws std::invalid_argument if the number of threads is not
+    ///         positive.
+    void setAsyncQueryThreads(int nThreads);
+    /// @result The number of asynchronous query threads.  By default this
+    ///         is 2.
+    [[nodiscard]] int getAsyncQueryThreads() const noexcept;
+
+    /// @brief Sets how a read-only database is served.
+    /// @param[in] mode  The serving mode.
+    /// @note Read-write databases are always served from the file.
+    void setServingMode(ServingMode mode) noexcept;
+    /// @result The serving mode.  By default this is File.
+    [[nodiscard]] ServingMode getServingMode() const noexcept;
+
+    /// @brief Sets the maximum number of bytes of the database file that
+    ///        are memory-mapped when the serving mode is MemoryMapped.
+    ///        SQLite caps this at its compile-time SQLITE_MAX_MMAP_SIZE.
+    /// @param[in] memoryMapSize  The memory map size in bytes.
+    /// @throws std::invalid_argument if the size is not positive.
+    void setMemoryMapSize(int64_t memoryMapSize);
+    /// @result The memory map size in bytes.  By default this is 256 MiB.
+    [[nodiscard]] int64_t getMemoryMapSize() const noexcept;
+
+    /// @brief Sets the size of each connection's page cache.
+    /// @param[in] cacheSize  The page cache size in bytes.  If this is 0 then
+    ///                       SQLite's default of about 2 MB is used.
+    /// @throws std::invalid_argument if the size is negative.
+    void setCacheSize(int64_t cacheSize);
+    /// @result The page cache size in bytes.  0 indicates SQLite's default.
+    [[nodiscard]] int64_t getCacheSize() const noexcept;
+
+    /// @brief Copy assignment.
+    /// @param[in] options  The options to copy to this.
+    /// @result A deep copy of the options.
+    DatabaseOptions& operator=(const DatabaseOptions &options);
+    /// @brief Move assignment.
+    /// @param[in,out] options  The options whose memory will be moved to this.
+    ///                         On exit, options's behavior is undefined.
+    /// @result The memory from options moved to this.
+    DatabaseOptions& operator=(DatabaseOptions &&options) noexcept;
+
+    /// @brief Destructor.
+    ~DatabaseOptions();
+private:
+    class DatabaseOptionsImpl;
+    std::unique_ptr<DatabaseOptionsImpl> pImpl;
+};
+
+}
+#endif
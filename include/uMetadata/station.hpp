@@ -128,6 +128,9 @@ public:
     /// @result The memory from station moved to this. 
     Station& operator=(Station &&station) noexcept;
 
+    /// @brief Resets the class and releases the station's information.
+    ///        Allocated memory is retained so the station can be reused.
+    void clear() noexcept;
     /// @brief Destructor.
     ~Station();
 private:
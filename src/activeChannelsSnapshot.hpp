@@ -0,0 +1,242 @@
+#ifndef ACTIVE_CHANNELS_SNAPSHOT_HPP
+#define ACTIVE_CHANNELS_SNAPSHOT_HPP
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <google/protobuf/field_mask.pb.h>
+#include <google/protobuf/util/message_differencer.h>
+#include "uMetadataAPI/v1/channel.pb.h"
+#include "uMetadataAPI/v1/channels_response.pb.h"
+#include "activeStationsSnapshot.hpp"
+namespace
+{
+
+/// @brief The optional channel fields selected by a field mask.  The
+///        network, station, name, and location code are always returned.
+///        Combine these with a bitwise or.
+namespace ChannelColumn
+{
+enum : uint32_t
+{
+    Latitude = 1U << 0U,      /*!< The latitude. */
+    Longitude = 1U << 1U,     /*!< The longitude. */
+    Elevation = 1U << 2U,     /*!< The elevation. */
+    SamplingRate = 1U << 3U,  /*!< The sampling rate. */
+    Azimuth = 1U << 4U,       /*!< The azimuth. */
+    Dip = 1U << 5U,           /*!< The dip. */
+    StartTime = 1U << 6U,     /*!< The epoch's start time. */
+    EndTime = 1U << 7U,       /*!< The epoch's end time. */
+    LastModified = 1U << 8U,  /*!< The last modification time. */
+    AllChannelColumns = (1U << 9U) - 1U /*!< Every column. */
+};
+}
+
+/// @result The ChannelColumn bits selected by a field mask.  An empty mask
+///         selects every column.
+/// @throws std::invalid_argument if a path does not name a channel field.
+[[maybe_unused]] [[nodiscard]]
+uint32_t toChannelColumns(const google::protobuf::FieldMask &mask)
+{
+    if (mask.paths().empty()){return ChannelColumn::AllChannelColumns;}
+    uint32_t columns{0};
+    for (const auto &path : mask.paths())
+    {
+        if (path == "network" || path == "station" || path == "name" ||
+            path == "location_code")
+        {
+            continue; // Always returned
+        }
+        else if (path == "latitude")
+        {
+            columns = columns | ChannelColumn::Latitude;
+        }
+        else if (path == "longitude")
+        {
+            columns = columns | ChannelColumn::Longitude;
+        }
+        else if (path == "elevation")
+        {
+            columns = columns | ChannelColumn::Elevation;
+        }
+        else if (path == "sampling_rate")
+        {
+            columns = columns | ChannelColumn::SamplingRate;
+        }
+        else if (path == "azimuth")
+        {
+            columns = columns | ChannelColumn::Azimuth;
+        }
+        else if (path == "dip")
+        {
+            columns = columns | ChannelColumn::Dip;
+        }
+        else if (path == "start_time")
+        {
+            columns = columns | ChannelColumn::StartTime;
+        }
+        else if (path == "end_time")
+        {
+            columns = columns | ChannelColumn::EndTime;
+        }
+        else if (path == "last_modified")
+        {
+            columns = columns | ChannelColumn::LastModified;
+        }
+        else
+        {
+            throw std::invalid_argument("Unknown channel field " + path);
+        }
+    }
+    return columns;
+}
+
+/// @brief Copies the network, station, name, location code, and selected
+///        columns of a channel.
+[[maybe_unused]]
+void projectChannel(const UMetadataAPI::V1::Channel &from,
+                    const uint32_t columns,
+                    UMetadataAPI::V1::Channel *to)
+{
+    if (columns == ChannelColumn::AllChannelColumns)
+    {
+        *to = from;
+        return;
+    }
+    to->set_network(from.network());
+    to->set_station(from.station());
+    to->set_name(from.name());
+    to->set_location_code(from.location_code());
+    if ((columns & ChannelColumn::Latitude) != 0)
+    {
+        to->set_latitude(from.latitude());
+    }
+    if ((columns & ChannelColumn::Longitude) != 0)
+    {
+        to->set_longitude(from.longitude());
+    }
+    if ((columns & ChannelColumn::Elevation) != 0)
+    {
+        to->set_elevation(from.elevation());
+    }
+    if ((columns & ChannelColumn::SamplingRate) != 0)
+    {
+        to->set_sampling_rate(from.sampling_rate());
+    }
+    if ((columns & ChannelColumn::Azimuth) != 0)
+    {
+        to->set_azimuth(from.azimuth());
+    }
+    if ((columns & ChannelColumn::Dip) != 0){to->set_dip(from.dip());}
+    if ((columns & ChannelColumn::StartTime) != 0)
+    {
+        *to->mutable_start_time() = from.start_time();
+    }
+    if ((columns & ChannelColumn::EndTime) != 0)
+    {
+        *to->mutable_end_time() = from.end_time();
+    }
+    if ((columns & ChannelColumn::LastModified) != 0)
+    {
+        *to->mutable_last_modified() = from.last_modified();
+    }
+}
+
+/// @result The inventory version sent to clients with a response holding the
+///         given columns of an active set.  Like the station inventory
+///         version, the columns are folded into the low bits so a client
+///         that changes its field mask is never told that the response it
+///         cached for another mask is unchanged.
+[[maybe_unused]] [[nodiscard]]
+constexpr uint64_t toChannelInventoryVersion(const uint64_t version,
+                                             const uint32_t columns) noexcept
+{
+    static_assert(ChannelColumn::AllChannelColumns == (1U << 9U) - 1U,
+                  "Channel columns must fit in the version's low bits");
+    return (version << 9U) | (columns & ChannelColumn::AllChannelColumns);
+}
+
+/// @brief An immutable view of the active channels.  Like the station
+///        snapshot, this is never modified after it is published.
+struct ActiveChannelsSnapshot
+{
+    [[nodiscard]] bool isCurrent(const int64_t version,
+                                 const std::chrono::seconds &now) const
+    {
+        return dataVersion == version && now < validUntil;
+    }
+    /// The serialized GetAllActiveChannels response.
+    std::shared_ptr<const std::string> bytes;
+    /// The active channels keyed on NET.STA.CHA.LOC.
+    std::unordered_map<std::string, UMetadataAPI::V1::Channel,
+                       KeyHash, std::equal_to<>> channels;
+    /// The active channels in the database's order.  These point into
+    /// channels.
+    std::vector<const UMetadataAPI::V1::Channel *> orderedChannels;
+    /// Identifies the active set.  This changes only when the active set
+    /// changes.
+    uint64_t version{0};
+    int64_t dataVersion{0};
+    std::chrono::seconds validUntil{0};
+};
+
+/// @result True if two snapshots hold the same active channels.  A rebuilt
+///         snapshot keeps its predecessor's version when this is true.
+[[maybe_unused]] [[nodiscard]]
+bool haveSameChannels(const ActiveChannelsSnapshot &previous,
+                      const ActiveChannelsSnapshot &current)
+{
+    if (previous.channels.size() != current.channels.size()){return false;}
+    for (const auto &[key, channel] : current.channels)
+    {
+        auto other = previous.channels.find(key);
+        if (other == previous.channels.end() ||
+            !google::protobuf::util::MessageDifferencer::Equals(other->second,
+                                                                channel))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// @brief Fills a GetAllActiveChannels response with the given columns of
+///        the snapshot's channels in the database's order.
+[[maybe_unused]]
+void projectChannels(const ActiveChannelsSnapshot &snapshot,
+                     const uint32_t columns,
+                     UMetadataAPI::V1::ChannelsResponse *response)
+{
+    response->set_version(::toChannelInventoryVersion(snapshot.version,
+                                                      columns));
+    response->mutable_channels()->Reserve(
+        static_cast<int> (snapshot.orderedChannels.size()));
+    for (const auto &channel : snapshot.orderedChannels)
+    {
+        ::projectChannel(*channel, columns, response->add_channels());
+    }
+}
+
+/// @result A channelless "unchanged" response if the client already has the
+///         current version of the given columns and NULL otherwise.
+[[maybe_unused]] [[nodiscard]]
+std::shared_ptr<const std::string>
+    toUnchangedChannelsResponse(const ActiveChannelsSnapshot &snapshot,
+                                const uint32_t columns,
+                                const uint64_t clientVersion)
+{
+    const auto version = ::toChannelInventoryVersion(snapshot.version,
+                                                     columns);
+    if (clientVersion == 0 || clientVersion != version){return nullptr;}
+    UMetadataAPI::V1::ChannelsResponse unchanged;
+    unchanged.set_version(version);
+    unchanged.set_unchanged(true);
+    return std::make_shared<const std::string> (unchanged.SerializeAsString());
+}
+
+}
+#endif
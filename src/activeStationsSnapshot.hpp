@@ -0,0 +1,275 @@
+#ifndef ACTIVE_STATIONS_SNAPSHOT_HPP
+#define ACTIVE_STATIONS_SNAPSHOT_HPP
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <google/protobuf/field_mask.pb.h>
+#include <google/protobuf/util/message_differencer.h>
+#include "uMetadata/database.hpp"
+#include "uMetadataAPI/v1/active_stations_update.pb.h"
+#include "uMetadataAPI/v1/station.pb.h"
+namespace
+{
+
+/// @brief Allows lookups of std::string keys with a std::string_view.
+struct KeyHash
+{
+    using is_transparent = void;
+    [[nodiscard]] size_t operator()(const std::string_view &key) const noexcept
+    {
+        return std::hash<std::string_view> {}(key);
+    }
+};
+
+/// @result The Database::StationColumn bits selected by a field mask.  An
+///         empty mask selects every column.
+/// @throws std::invalid_argument if a path does not name a station field.
+[[maybe_unused]] [[nodiscard]]
+uint32_t toStationColumns(const google::protobuf::FieldMask &mask)
+{
+    using Column = UMetadata::Database::StationColumn;
+    if (mask.paths().empty()){return Column::AllStationColumns;}
+    uint32_t columns{0};
+    for (const auto &path : mask.paths())
+    {
+        if (path == "network" || path == "name")
+        {
+            continue; // Always returned
+        }
+        else if (path == "latitude")
+        {
+            columns = columns | Column::Latitude;
+        }
+        else if (path == "longitude")
+        {
+            columns = columns | Column::Longitude;
+        }
+        else if (path == "elevation")
+        {
+            columns = columns | Column::Elevation;
+        }
+        else if (path == "start_time")
+        {
+            columns = columns | Column::StartTime;
+        }
+        else if (path == "end_time")
+        {
+            columns = columns | Column::EndTime;
+        }
+        else if (path == "last_modified")
+        {
+            columns = columns | Column::LastModified;
+        }
+        else if (path == "description")
+        {
+            columns = columns | Column::Description;
+        }
+        else
+        {
+            throw std::invalid_argument("Unknown station field " + path);
+        }
+    }
+    return columns;
+}
+
+/// @brief Copies the network, name, and selected columns of a station.
+[[maybe_unused]]
+void projectStation(const UMetadataAPI::V1::Station &from,
+                    const uint32_t columns,
+                    UMetadataAPI::V1::Station *to)
+{
+    using Column = UMetadata::Database::StationColumn;
+    if (columns == Column::AllStationColumns)
+    {
+        *to = from;
+        return;
+    }
+    to->set_network(from.network());
+    to->set_name(from.name());
+    if ((columns & Column::Latitude) != 0){to->set_latitude(from.latitude());}
+    if ((columns & Column::Longitude) != 0)
+    {
+        to->set_longitude(from.longitude());
+    }
+    if ((columns & Column::Elevation) != 0)
+    {
+        to->set_elevation(from.elevation());
+    }
+    if ((columns & Column::StartTime) != 0)
+    {
+        *to->mutable_start_time() = from.start_time();
+    }
+    if ((columns & Column::EndTime) != 0)
+    {
+        *to->mutable_end_time() = from.end_time();
+    }
+    if ((columns & Column::LastModified) != 0)
+    {
+        *to->mutable_last_modified() = from.last_modified();
+    }
+    if ((columns & Column::Description) != 0)
+    {
+        to->set_description(from.description());
+    }
+}
+
+/// @result The inventory version sent to clients with a response holding the
+///         given columns of an active set.  The columns are folded into the
+///         low bits so that a client that changes its field mask is never
+///         told that the response it cached for another mask is unchanged.
+///         Sequence numbers start from a time in microseconds so there is
+///         ample room above the columns.
+[[maybe_unused]] [[nodiscard]]
+constexpr uint64_t toInventoryVersion(const uint64_t sequenceNumber,
+                                      const uint32_t columns) noexcept
+{
+    constexpr uint32_t allColumns
+        = UMetadata::Database::StationColumn::AllStationColumns;
+    static_assert(allColumns == (1U << 7U) - 1U,
+                  "Station columns must fit in the version's low bits");
+    return (sequenceNumber << 7U) | (columns & allColumns);
+}
+
+/// @brief An immutable view of the active stations.  A snapshot is never
+///        modified after it is published so any number of threads may read
+///        it without synchronization.
+struct ActiveStationsSnapshot
+{
+    [[nodiscard]] bool isCurrent(const int64_t version,
+                                 const std::chrono::seconds &now) const
+    {
+        return dataVersion == version && now < validUntil;
+    }
+    /// The serialized GetAllActiveStations response.
+    std::shared_ptr<const std::string> bytes;
+    /// The active stations keyed on NET.STA.
+    std::unordered_map<std::string, UMetadataAPI::V1::Station,
+                       KeyHash, std::equal_to<>> stations;
+    /// The active stations in the database's order.  These point into
+    /// stations.
+    std::vector<const UMetadataAPI::V1::Station *> orderedStations;
+    /// The changes from the previous snapshot.
+    std::shared_ptr<const UMetadataAPI::V1::ActiveStationsUpdate> delta;
+    /// Identifies the active set.  This changes only when the active set
+    /// changes.
+    uint64_t sequenceNumber{0};
+    int64_t dataVersion{0};
+    /// The time at which the active stations were queried.
+    std::chrono::seconds time{0};
+    std::chrono::seconds validUntil{0};
+};
+
+/// @brief Adds to the update the stations that differ between two snapshots.
+[[maybe_unused]]
+void appendDifferences(const ActiveStationsSnapshot &from,
+                       const ActiveStationsSnapshot &to,
+                       UMetadataAPI::V1::ActiveStationsUpdate *update)
+{
+    for (const auto &[key, station] : to.stations)
+    {
+        auto previous = from.stations.find(key);
+        if (previous == from.stations.end())
+        {
+            *update->add_added() = station;
+        }
+        else if (!google::protobuf::util::MessageDifferencer::Equals(
+                     previous->second, station))
+        {
+            *update->add_modified() = station;
+        }
+    }
+    for (const auto &[key, station] : from.stations)
+    {
+        if (!to.stations.contains(key))
+        {
+            *update->add_removed() = station;
+        }
+    }
+}
+
+/// @brief Remembers the most recently replaced active sets so that a client
+///        that fell behind by more than one change can be brought forward
+///        with only the differences.
+class ActiveStationsHistory
+{
+public:
+    static constexpr size_t DEFAULT_SIZE{16};
+    explicit ActiveStationsHistory(const size_t size = DEFAULT_SIZE) :
+        mSize(size)
+    {
+    }
+    /// @brief Remembers a snapshot that was replaced by one with a new
+    ///        active set.  The oldest snapshot is forgotten once the
+    ///        history is full.
+    void push(std::shared_ptr<const ActiveStationsSnapshot> snapshot)
+    {
+        const std::lock_guard<std::mutex> lock(mMutex);
+        mSnapshots.push_back(std::move(snapshot));
+        if (mSnapshots.size() > mSize){mSnapshots.pop_front();}
+    }
+    /// @brief Fills the update that brings a client from the given sequence
+    ///        number to the given snapshot.
+    /// @param[in] snapshot        The snapshot to bring the client to.
+    /// @param[in] sequenceNumber  The last sequence number the client applied.
+    /// @param[out] update         The changes or, if the client cannot be
+    ///                            brought forward, a full snapshot.
+    /// @result False if the client is already at the snapshot.
+    [[nodiscard]] bool getUpdateSince(
+        const ActiveStationsSnapshot &snapshot,
+        const uint64_t sequenceNumber,
+        UMetadataAPI::V1::ActiveStationsUpdate *update) const
+    {
+        update->Clear();
+        if (sequenceNumber == snapshot.sequenceNumber){return false;}
+        update->set_sequence_number(snapshot.sequenceNumber);
+        // Most clients are one change behind
+        if (snapshot.delta &&
+            snapshot.delta->sequence_number() == sequenceNumber)
+        {
+            update->mutable_added()->CopyFrom(snapshot.delta->added());
+            update->mutable_modified()->CopyFrom(snapshot.delta->modified());
+            update->mutable_removed()->CopyFrom(snapshot.delta->removed());
+            return true;
+        }
+        std::shared_ptr<const ActiveStationsSnapshot> from{nullptr};
+        {
+            const std::lock_guard<std::mutex> lock(mMutex);
+            for (const auto &previous : mSnapshots)
+            {
+                if (previous->sequenceNumber == sequenceNumber)
+                {
+                    from = previous;
+                    break;
+                }
+            }
+        }
+        if (from)
+        {
+            ::appendDifferences(*from, snapshot, update);
+            return true;
+        }
+        update->set_is_snapshot(true);
+        update->mutable_added()->Reserve(
+            static_cast<int> (snapshot.orderedStations.size()));
+        for (const auto &station : snapshot.orderedStations)
+        {
+            *update->add_added() = *station;
+        }
+        return true;
+    }
+private:
+    mutable std::mutex mMutex;
+    std::deque<std::shared_ptr<const ActiveStationsSnapshot>> mSnapshots;
+    size_t mSize{DEFAULT_SIZE};
+};
+
+}
+#endif
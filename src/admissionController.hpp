@@ -0,0 +1,174 @@
+#ifndef ADMISSION_CONTROLLER_HPP
+#define ADMISSION_CONTROLLER_HPP
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <grpcpp/support/status.h>
+#include <spdlog/spdlog.h>
+#include "databaseExecutor.hpp"
+#include "latencyStatistics.hpp"
+#include "metrics.hpp"
+namespace
+{
+
+/// @brief Limits the calls in flight to each RPC so that, when every client
+///        reconnects at once, the excess is turned away immediately with
+///        RESOURCE_EXHAUSTED rather than slowing down every caller.  Point
+///        lookups and full-inventory dumps have separate limits and queue
+///        budgets so that cheap lookups keep being served.
+class AdmissionController
+{
+public:
+    /// @brief A call's claim on its RPC's concurrency.  The claim is given
+    ///        back when the last reference is released, i.e., once gRPC is
+    ///        done with the call.
+    /// @note The controller must outlive its admissions.
+    class Admission
+    {
+    public:
+        ~Admission()
+        {
+            mInFlight.fetch_sub(1, std::memory_order_relaxed);
+        }
+        Admission(const Admission &) = delete;
+        Admission& operator=(const Admission &) = delete;
+        [[nodiscard]] ::RequestClass getRequestClass() const noexcept
+        {
+            return mRequestClass;
+        }
+        /// @result The longest the call may wait for a database worker.
+        [[nodiscard]] std::chrono::milliseconds getQueueBudget() const noexcept
+        {
+            return mQueueBudget;
+        }
+        void recordQueueTime(const std::chrono::nanoseconds &duration) const
+        {
+            mMetrics.recordQueueTime(
+                mMethod,
+                std::chrono::duration<double, std::milli> {duration}.count());
+        }
+        /// @param[in] reason  Why the admitted call was turned away.
+        void recordRejection(const std::string_view &reason) const
+        {
+            mMetrics.addRejectedRequest(mMethod, reason);
+        }
+    private:
+        friend class AdmissionController;
+        Admission(std::atomic<int> &inFlight,
+                  ::Metrics &metrics,
+                  const std::string_view &method,
+                  const ::RequestClass requestClass,
+                  const std::chrono::milliseconds &queueBudget) :
+            mInFlight(inFlight),
+            mMetrics(metrics),
+            mMethod(method),
+            mQueueBudget(queueBudget),
+            mRequestClass(requestClass)
+        {
+        }
+        std::atomic<int> &mInFlight;
+        ::Metrics &mMetrics;
+        std::string_view mMethod;
+        std::chrono::milliseconds mQueueBudget;
+        ::RequestClass mRequestClass;
+    };
+
+    /// @param[in] maximumConcurrentLookups      The calls to each point
+    ///                                          lookup RPC that may be in
+    ///                                          flight.
+    /// @param[in] maximumConcurrentInventories  The calls to each
+    ///                                          full-inventory RPC that may
+    ///                                          be in flight.
+    /// @param[in] lookupQueueBudget             The longest a lookup may wait
+    ///                                          for a database worker.
+    /// @param[in] inventoryQueueBudget          The longest an inventory may
+    ///                                          wait for a database worker.
+    /// @param[in] metrics                       Counts the rejections.  This
+    ///                                          must outlive every admission.
+    AdmissionController(const int maximumConcurrentLookups,
+                        const int maximumConcurrentInventories,
+                        const std::chrono::milliseconds &lookupQueueBudget,
+                        const std::chrono::milliseconds &inventoryQueueBudget,
+                        ::Metrics &metrics) :
+        mMetrics(metrics),
+        mLookupQueueBudget(lookupQueueBudget),
+        mInventoryQueueBudget(inventoryQueueBudget),
+        mMaximumConcurrentLookups(maximumConcurrentLookups),
+        mMaximumConcurrentInventories(maximumConcurrentInventories)
+    {
+        spdlog::info("Admitting at most "
+                   + std::to_string(mMaximumConcurrentLookups)
+                   + " calls to each lookup and "
+                   + std::to_string(mMaximumConcurrentInventories)
+                   + " calls to each inventory RPC");
+    }
+    AdmissionController(const AdmissionController &) = delete;
+    AdmissionController& operator=(const AdmissionController &) = delete;
+    /// @result The call's admission or nullptr if its RPC is at its limit.
+    [[nodiscard]] std::shared_ptr<const Admission>
+        admit(const ::Operation operation)
+    {
+        const auto method = OPERATION_NAMES[static_cast<size_t> (operation)];
+        const auto requestClass = ::AdmissionController::classify(operation);
+        const auto limit = requestClass == ::RequestClass::Lookup ?
+                           mMaximumConcurrentLookups :
+                           mMaximumConcurrentInventories;
+        auto &inFlight = mInFlight[static_cast<size_t> (operation)];
+        if (inFlight.fetch_add(1, std::memory_order_relaxed) >= limit)
+        {
+            inFlight.fetch_sub(1, std::memory_order_relaxed);
+            mMetrics.addRejectedRequest(method, "concurrency");
+            return nullptr;
+        }
+        return std::shared_ptr<const Admission>
+               (new Admission(inFlight,
+                              mMetrics,
+                              method,
+                              requestClass,
+                              requestClass == ::RequestClass::Lookup ?
+                              mLookupQueueBudget : mInventoryQueueBudget));
+    }
+    /// @result The calls to the RPC that are holding an admission.
+    [[nodiscard]] int getInFlight(const ::Operation operation) const noexcept
+    {
+        return mInFlight[static_cast<size_t> (operation)].load(
+                  std::memory_order_relaxed);
+    }
+    /// @result The status of a call that was not admitted.
+    [[nodiscard]] static grpc::Status getRejectedStatus(
+        const ::Operation operation)
+    {
+        return grpc::Status{grpc::StatusCode::RESOURCE_EXHAUSTED,
+                            "Too many "
+                          + std::string {OPERATION_NAMES[
+                               static_cast<size_t> (operation)]}
+                          + " requests in progress"};
+    }
+    /// @result Full-inventory RPCs, including the watch streams that open
+    ///         with the full inventory, are inventories and the rest lookups.
+    [[nodiscard]] static ::RequestClass classify(
+        const ::Operation operation) noexcept
+    {
+        if (operation == ::Operation::GetAllActiveStations ||
+            operation == ::Operation::GetAllActiveStationsPaged ||
+            operation == ::Operation::WatchActiveStations ||
+            operation == ::Operation::GetAllActiveChannels)
+        {
+            return ::RequestClass::Inventory;
+        }
+        return ::RequestClass::Lookup;
+    }
+private:
+    ::Metrics &mMetrics;
+    std::array<std::atomic<int>, OPERATION_NAMES.size()> mInFlight{};
+    std::chrono::milliseconds mLookupQueueBudget;
+    std::chrono::milliseconds mInventoryQueueBudget;
+    int mMaximumConcurrentLookups{256};
+    int mMaximumConcurrentInventories{16};
+};
+
+}
+#endif
@@ -165,10 +165,7 @@ void Channel::setLocationCode(const std::string &locationCodeIn)
     {
         locationCode = "--";
     }
-    else
-    {
-        pImpl->mLocationCode = locationCode;
-    }
+    pImpl->mLocationCode = locationCode;
 }
 
 std::string Channel::getLocationCode() const
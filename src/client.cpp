@@ -7,13 +7,122 @@
 #include <grpcpp/create_channel.h>
 #include <grpcpp/security/credentials.h>
 #include <spdlog/spdlog.h>
+#ifdef WITH_TRACING
+#include <opentelemetry/trace/propagation/http_trace_context.h>
+#include <opentelemetry/context/runtime_context.h>
+#endif
 #include "uMetadata/client.hpp"
+#include "uMetadata/version.hpp"
 #include "uMetadata/station.hpp"
+#include "uMetadata/channel.hpp"
 #include "uMetadataAPI/v1/station_information_service.grpc.pb.h"
+#include "uMetadataAPI/v1/channel_information_service.grpc.pb.h"
+#include "tracing.hpp"
 //#include "uMetadataAPI/v1/station.grpc.pb.h"
 
 using namespace UMetadata;
 
+namespace
+{
+
+#ifdef WITH_TRACING
+/// @brief Writes the W3C trace context headers into a request's metadata.
+class ClientContextCarrier :
+    public opentelemetry::context::propagation::TextMapCarrier
+{
+public:
+    explicit ClientContextCarrier(grpc::ClientContext *context) :
+        mContext(context)
+    {
+    }
+    opentelemetry::nostd::string_view Get(
+        opentelemetry::nostd::string_view) const noexcept override
+    {
+        return "";
+    }
+    void Set(opentelemetry::nostd::string_view key,
+             opentelemetry::nostd::string_view value) noexcept override
+    {
+        mContext->AddMetadata(std::string {key.data(), key.size()},
+                              std::string {value.data(), value.size()});
+    }
+private:
+    grpc::ClientContext *mContext{nullptr};
+};
+
+/// @brief Traces an RPC from the client's side.  The span is a child of the
+///        caller's active span, if any, and its context is sent with the
+///        request so that the server's spans join the same trace.
+class ClientSpan
+{
+public:
+    /// @param[in] method  The full method name, e.g.,
+    ///                    UMetadataAPI.V1.StationInformation/GetActiveStation.
+    ClientSpan(const ::TracerHandle &tracer,
+               const std::string_view &method,
+               grpc::ClientContext *context) :
+        mSpan(startSpan(tracer, method)),
+        mScope(mSpan)
+    {
+        ClientContextCarrier carrier{context};
+        opentelemetry::trace::propagation::HttpTraceContext propagator;
+        propagator.Inject(carrier,
+                          opentelemetry::context::RuntimeContext::GetCurrent());
+    }
+    /// @brief Marks the span as failed unless the RPC succeeded.
+    void setStatus(const grpc::Status &status) noexcept
+    {
+        mSpan->SetAttribute("rpc.grpc.status_code",
+                            static_cast<int> (status.error_code()));
+        if (!status.ok())
+        {
+            mSpan->SetStatus(opentelemetry::trace::StatusCode::kError,
+                             status.error_message());
+        }
+    }
+    ~ClientSpan()
+    {
+        mSpan->End();
+    }
+    ClientSpan(const ClientSpan &) = delete;
+    ClientSpan& operator=(const ClientSpan &) = delete;
+private:
+    static opentelemetry::nostd::shared_ptr<opentelemetry::trace::Span>
+        startSpan(const ::TracerHandle &tracer,
+                  const std::string_view &method)
+    {
+        opentelemetry::trace::StartSpanOptions options;
+        options.kind = opentelemetry::trace::SpanKind::kClient;
+        auto slash = method.find('/');
+        return tracer->StartSpan(method,
+                                 {{"rpc.system", "grpc"},
+                                  {"rpc.service", method.substr(0, slash)},
+                                  {"rpc.method", method.substr(slash + 1)}},
+                                 options);
+    }
+    opentelemetry::nostd::shared_ptr<opentelemetry::trace::Span> mSpan;
+    opentelemetry::trace::Scope mScope;
+};
+#else
+/// @brief Without tracing a client span costs nothing.
+class ClientSpan
+{
+public:
+    ClientSpan(const ::TracerHandle &,
+               const std::string_view &,
+               grpc::ClientContext *) noexcept
+    {
+    }
+    void setStatus(const grpc::Status &) noexcept
+    {
+    }
+    ClientSpan(const ClientSpan &) = delete;
+    ClientSpan& operator=(const ClientSpan &) = delete;
+};
+#endif
+
+}
+
 class Client::ClientImpl
 {
 public:
@@ -28,21 +137,95 @@ public:
             = grpc::CreateChannel(endPoint,
                                   grpc::InsecureChannelCredentials());
         mStub = std::make_unique<UMetadataAPI::V1::StationInformation::Stub> (channel); 
+        mChannelStub
+            = std::make_unique<UMetadataAPI::V1::ChannelInformation::Stub> (channel);
     }
     // Get all the stations
     [[nodiscard]] std::vector<UMetadata::Station> getAllActiveStations() const
     {
         spdlog::debug("Querying for all active stations");
         std::vector<UMetadata::Station> result;
-        UMetadataAPI::V1::AllActiveStationsRequest request;
-        grpc::ClientContext context;
+        uint64_t version{0};
+        {
+            std::lock_guard<std::mutex> cacheLock(mCacheMutex);
+            version = mCachedVersion;
+        }
         UMetadataAPI::V1::StationsResponse response;
+        auto status = requestAllActiveStations(version, &response);
+        if (status.ok() && response.unchanged())
+        {
+            std::lock_guard<std::mutex> cacheLock(mCacheMutex);
+            if (response.version() == mCachedVersion)
+            {
+                spdlog::debug("Active stations unchanged at version "
+                            + std::to_string(response.version()));
+                return mCachedStations;
+            }
+        }
+        if (status.ok() && response.unchanged())
+        {
+            // Another call replaced the cache while this one was in flight
+            spdlog::debug("Cached active stations changed; requerying");
+            response.Clear();
+            status = requestAllActiveStations(0, &response);
+            if (status.ok() && response.unchanged())
+            {
+                throw std::runtime_error(
+                    "Server reported unchanged active stations for version 0");
+            }
+        }
+
+        // Take action
+        if (status.ok())
+        {
+            std::lock_guard<std::mutex> cacheLock(mCacheMutex);
+            spdlog::debug("Successfully queried " 
+                        + std::to_string(response.stations().size())
+                        + " stations");
+            result.reserve(static_cast<size_t> (response.stations_size()));
+            for (const auto &station : response.stations())
+            {
+                result.push_back( UMetadata::Station {station} );
+            }
+            mCachedStations = result;
+            mCachedVersion = response.version();
+            return result;
+        }
+        else
+        {
+            auto error = "Active stations request failed with "
+                        + std::to_string(static_cast<int> (status.error_code()))
+                        + ": " 
+                        + status.error_message();
+            throw std::runtime_error(error);
+        }
+    }
+    // Get several stations
+    [[nodiscard]] std::vector<UMetadata::Station>
+        getActiveStations(
+            const std::vector<std::pair<std::string, std::string>> &stations) const
+    {
+        spdlog::debug("Querying for " + std::to_string(stations.size())
+                    + " active stations");
+        std::vector<UMetadata::Station> result;
+        if (stations.empty()){return result;}
+        UMetadataAPI::V1::ActiveStationsRequest request;
+        request.mutable_stations()->Reserve(static_cast<int> (stations.size()));
+        for (const auto &[network, name] : stations)
+        {
+            auto station = request.add_stations();
+            station->set_network(network);
+            station->set_name(name);
+        }
+        grpc::ClientContext context;
+        ClientSpan span{mTracer, "UMetadataAPI.V1.StationInformation/GetActiveStations", &context};
+        UMetadataAPI::V1::ActiveStationsResponse response;
 
         std::mutex mutex;
         std::condition_variable cv;
-        grpc::Status status; 
+        grpc::Status status;
         bool done{false};
-        mStub->async()->GetAllActiveStations(
+        mStub->async()->GetActiveStations(
             &context, &request, &response,
             [&mutex, &cv, &done, &status](grpc::Status returnedStatus)
         {
@@ -57,29 +240,257 @@ public:
         {
             cv.wait(lock);
         }
+        span.setStatus(status);
 
-        // Take action
-        if (status.ok())
+        if (!status.ok())
         {
-            spdlog::debug("Successfully queried " 
-                        + std::to_string(response.stations().size())
-                        + " stations");
-            for (const auto &station : response.stations())
+            auto error = "Active stations batch request failed with "
+                        + std::to_string(static_cast<int> (status.error_code()))
+                        + ": "
+                        + status.error_message();
+            throw std::runtime_error(error);
+        }
+        for (const auto &missing : response.missing())
+        {
+            spdlog::debug("Could not find " + missing.network() + "."
+                        + missing.name());
+        }
+        result.reserve(static_cast<size_t> (response.stations_size()));
+        for (const auto &station : response.stations())
+        {
+            result.push_back( UMetadata::Station {station} );
+        }
+        return result;
+    }
+    // Stream all the stations
+    void forEachActiveStation(
+        const std::function<void (const UMetadata::Station &)> &visitor) const
+    {
+        spdlog::debug("Streaming all active stations");
+        UMetadataAPI::V1::ActiveStationsPagesRequest request;
+        grpc::ClientContext context;
+        ClientSpan span{mTracer, "UMetadataAPI.V1.StationInformation/GetAllActiveStationsPaged", &context};
+        auto reader = mStub->GetAllActiveStationsPaged(&context, request);
+        UMetadataAPI::V1::StationsResponse page;
+        size_t nStations{0};
+        try
+        {
+            while (reader->Read(&page))
             {
-                result.push_back( UMetadata::Station {station} );
+                for (const auto &station : page.stations())
+                {
+                    visitor(UMetadata::Station {station});
+                }
+                nStations = nStations + page.stations().size();
             }
-            return result;
         }
-        else
+        catch (...)
         {
-            auto error = "Active stations request failed with "
+            // The stream must be drained before the reader can be released
+            context.TryCancel();
+            while (reader->Read(&page)){}
+            reader->Finish();
+            throw;
+        }
+        auto status = reader->Finish();
+        span.setStatus(status);
+        if (!status.ok())
+        {
+            auto error = "Active stations stream failed with "
                         + std::to_string(static_cast<int> (status.error_code()))
-                        + ": " 
+                        + ": "
                         + status.error_message();
             throw std::runtime_error(error);
         }
+        spdlog::debug("Successfully streamed "
+                    + std::to_string(nStations) + " stations");
+    }
+    // Get all the channels
+    [[nodiscard]] std::vector<UMetadata::Channel> getAllActiveChannels() const
+    {
+        spdlog::debug("Querying for all active channels");
+        std::vector<UMetadata::Channel> result;
+        uint64_t version{0};
+        {
+            std::lock_guard<std::mutex> cacheLock(mCacheMutex);
+            version = mCachedChannelsVersion;
+        }
+        UMetadataAPI::V1::ChannelsResponse response;
+        auto status = requestAllActiveChannels(version, &response);
+        if (status.ok() && response.unchanged())
+        {
+            std::lock_guard<std::mutex> cacheLock(mCacheMutex);
+            if (response.version() == mCachedChannelsVersion)
+            {
+                spdlog::debug("Active channels unchanged at version "
+                            + std::to_string(response.version()));
+                return mCachedChannels;
+            }
+        }
+        if (status.ok() && response.unchanged())
+        {
+            // Another call replaced the cache while this one was in flight
+            spdlog::debug("Cached active channels changed; requerying");
+            response.Clear();
+            status = requestAllActiveChannels(0, &response);
+            if (status.ok() && response.unchanged())
+            {
+                throw std::runtime_error(
+                    "Server reported unchanged active channels for version 0");
+            }
+        }
+
+        if (!status.ok())
+        {
+            auto error = "Active channels request failed with "
+                        + std::to_string(static_cast<int> (status.error_code()))
+                        + ": "
+                        + status.error_message();
+            throw std::runtime_error(error);
+        }
+        std::lock_guard<std::mutex> cacheLock(mCacheMutex);
+        spdlog::debug("Successfully queried "
+                    + std::to_string(response.channels().size())
+                    + " channels");
+        result.reserve(static_cast<size_t> (response.channels_size()));
+        for (const auto &channel : response.channels())
+        {
+            result.push_back( UMetadata::Channel {channel} );
+        }
+        mCachedChannels = result;
+        mCachedChannelsVersion = response.version();
+        return result;
+    }
+    // Get a channel
+    [[nodiscard]] std::optional<UMetadata::Channel>
+        getActiveChannel(const std::string &network,
+                         const std::string &station,
+                         const std::string &channel,
+                         const std::string &locationCode) const
+    {
+        UMetadataAPI::V1::ActiveChannelRequest request;
+        request.set_network(network);
+        request.set_name(station);
+        request.set_channel(channel);
+        request.set_location_code(locationCode);
+        grpc::ClientContext context;
+        ClientSpan span{mTracer, "UMetadataAPI.V1.ChannelInformation/GetActiveChannel", &context};
+        UMetadataAPI::V1::Channel response;
+
+        std::mutex mutex;
+        std::condition_variable cv;
+        grpc::Status status;
+        bool done{false};
+        mChannelStub->async()->GetActiveChannel(
+            &context, &request, &response,
+            [&mutex, &cv, &done, &status](grpc::Status returnedStatus)
+        {
+            status = std::move(returnedStatus);
+            std::lock_guard<std::mutex> lock(mutex);
+            done = true;
+            cv.notify_one();
+        });
+
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!done)
+        {
+            cv.wait(lock);
+        }
+        span.setStatus(status);
+
+        if (status.error_code() == grpc::StatusCode::NOT_FOUND)
+        {
+            spdlog::debug(status.error_message());
+            return std::nullopt;
+        }
+        if (!status.ok())
+        {
+            auto error = "Active channel request failed with "
+                        + std::to_string(static_cast<int> (status.error_code()))
+                        + ": "
+                        + status.error_message();
+            throw std::runtime_error(error);
+        }
+        return UMetadata::Channel {response};
+    }
+private:
+    /// Sends a GetAllActiveStations request with the given inventory version
+    /// and waits for the response.
+    [[nodiscard]] grpc::Status requestAllActiveStations(
+        const uint64_t version,
+        UMetadataAPI::V1::StationsResponse *response) const
+    {
+        UMetadataAPI::V1::AllActiveStationsRequest request;
+        request.set_version(version);
+        grpc::ClientContext context;
+        ClientSpan span{mTracer, "UMetadataAPI.V1.StationInformation/GetAllActiveStations", &context};
+
+        std::mutex mutex;
+        std::condition_variable cv;
+        grpc::Status status; 
+        bool done{false};
+        mStub->async()->GetAllActiveStations(
+            &context, &request, response,
+            [&mutex, &cv, &done, &status](grpc::Status returnedStatus)
+        {
+            status = std::move(returnedStatus);
+            std::lock_guard<std::mutex> lock(mutex);
+            done = true;
+            cv.notify_one();
+        });
+
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!done)
+        {
+            cv.wait(lock);
+        }
+        span.setStatus(status);
+        return status;
+    }
+    /// Sends a GetAllActiveChannels request with the given inventory version
+    /// and waits for the response.
+    [[nodiscard]] grpc::Status requestAllActiveChannels(
+        const uint64_t version,
+        UMetadataAPI::V1::ChannelsResponse *response) const
+    {
+        UMetadataAPI::V1::AllActiveChannelsRequest request;
+        request.set_version(version);
+        grpc::ClientContext context;
+        ClientSpan span{mTracer, "UMetadataAPI.V1.ChannelInformation/GetAllActiveChannels", &context};
+
+        std::mutex mutex;
+        std::condition_variable cv;
+        grpc::Status status;
+        bool done{false};
+        mChannelStub->async()->GetAllActiveChannels(
+            &context, &request, response,
+            [&mutex, &cv, &done, &status](grpc::Status returnedStatus)
+        {
+            status = std::move(returnedStatus);
+            std::lock_guard<std::mutex> lock(mutex);
+            done = true;
+            cv.notify_one();
+        });
+
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!done)
+        {
+            cv.wait(lock);
+        }
+        span.setStatus(status);
+        return status;
     }
     std::unique_ptr<UMetadataAPI::V1::StationInformation::Stub> mStub{nullptr};
+    std::unique_ptr<UMetadataAPI::V1::ChannelInformation::Stub>
+        mChannelStub{nullptr};
+    // The last inventory and its version so unchanged polls are not
+    // re-downloaded
+    mutable std::mutex mCacheMutex;
+    mutable std::vector<UMetadata::Station> mCachedStations;
+    mutable uint64_t mCachedVersion{0};
+    mutable std::vector<UMetadata::Channel> mCachedChannels;
+    mutable uint64_t mCachedChannelsVersion{0};
+    ::TracerHandle mTracer{::getLibraryTracer("uMetadataClient")};
 };
 
 /// Constructor
@@ -94,5 +505,36 @@ std::vector<UMetadata::Station> Client::getAllActiveStations() const
     return pImpl->getAllActiveStations();
 }
 
+/// Gets several current stations
+std::vector<UMetadata::Station> Client::getActiveStations(
+    const std::vector<std::pair<std::string, std::string>> &stations) const
+{
+    return pImpl->getActiveStations(stations);
+}
+
+/// Streams all the current stations
+void Client::forEachActiveStation(
+    const std::function<void (const UMetadata::Station &)> &visitor) const
+{
+    if (!visitor){throw std::invalid_argument("Visitor is not callable");}
+    pImpl->forEachActiveStation(visitor);
+}
+
+/// Gets all the current channels
+std::vector<UMetadata::Channel> Client::getAllActiveChannels() const
+{
+    return pImpl->getAllActiveChannels();
+}
+
+/// Gets a current channel
+std::optional<UMetadata::Channel> Client::getActiveChannel(
+    const std::string &network,
+    const std::string &station,
+    const std::string &channel,
+    const std::string &locationCode) const
+{
+    return pImpl->getActiveChannel(network, station, channel, locationCode);
+}
+
 /// Destructor
 Client::~Client() = default;
@@ -1,25 +1,51 @@
 #include <iostream>
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <chrono>
 #include <cmath>
+#include <condition_variable>
 #include <cstdint>
+#include <deque>
 #include <exception>
 #include <filesystem>
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <numbers>
 #include <optional>
 #include <stdexcept>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <unordered_set>
 #include <utility>
 #include <vector>
+#include <sys/resource.h>
 #include <sqlite3.h>
 #include <spdlog/spdlog.h>
 #include <spdlog/logger.h>
 #include "uMetadata/database.hpp"
+#include "uMetadata/databaseOptions.hpp"
 #include "uMetadata/station.hpp"
 #include "uMetadata/channel.hpp"
+#include "uMetadata/version.hpp"
 #include "utilities.hpp"
+#include "tracing.hpp"
+#include "uMetadataAPI/v1/station.pb.h"
+#include "uMetadataAPI/v1/stations_response.pb.h"
+#include "uMetadataAPI/v1/channel.pb.h"
+#include "uMetadataAPI/v1/channels_response.pb.h"
 #define STATION_TABLE "station"
 #define CHANNEL_TABLE "channel"
 #define POLE_ZERO_TABLE "poles_and_zeros"
+#define STATION_EPOCH_INDEX "station_epoch"
+#define STATION_LOCATION_INDEX "station_location"
+#define CHANNEL_EPOCH_INDEX "channel_epoch"
+/// The schema version recorded in PRAGMA user_version.  Version 1 corrected
+/// the channel table's dip constraint.
+#define SCHEMA_VERSION 1
 
 #define SQLITE_CHECK_BIND(returnCode, statement) \
 { \
@@ -41,6 +67,15 @@
     } \
 }
 
+#define SQLITE_CHECK_CACHED_BIND(returnCode) \
+{ \
+    if ((returnCode) != SQLITE_OK) \
+    { \
+        throw std::runtime_error("Failed to bind cached statement with " \
+                               + std::to_string(returnCode)); \
+    } \
+}
+
 #define SQLITE_CHECK_FINALIZE(returnCode) \
 { \
     if ((returnCode) != SQLITE_OK) \
@@ -51,8 +86,835 @@
 
 
 
-namespace
+namespace
+{
+
+/// The current channel table.
+constexpr std::string_view CHANNEL_TABLE_SCHEMA{
+R"""(CREATE TABLE channel (
+  identifier INTEGER PRIMARY KEY AUTOINCREMENT,
+  station_identifier INTEGER,
+  name TEXT,
+  location_code TEXT DEFAULT NULL,
+  latitude DOUBLE NOT NULL CHECK( latitude >= -90 AND latitude <= 90),
+  longitude DOUBLE NOT NULL,
+  elevation DOUBLE NOT NULL CHECK( elevation >= -10000 AND elevation <= 8600 ),
+  sampling_rate DOUBLE NOT NULL CHECK ( sampling_rate > 0 ),
+  azimuth DOUBLE CHECK( azimuth >= 0 AND azimuth < 360 ),
+  dip DOUBLE CHECK( dip >= -90 AND dip <= 90 ),
+  start_time BIGINT NOT NULL,
+  end_time BIGINT DEFAULT 32503680000 CHECK (end_time > start_time),
+  last_modified DOUBLE DEFAULT CURRENT_TIMESTAMP,
+  UNIQUE(station_identifier, name, location_code, start_time),
+  FOREIGN KEY(station_identifier) REFERENCES station(identifier)
+)
+)"""};
+
+/// The queries whose prepared statements are cached for the lifetime of the
+/// connection.
+enum class Query : int
+{
+    StationExists = 0,
+    ActiveStation,
+    StationsActiveAt,
+    StationsActiveAtScan,
+    StationsInBox,
+    StationsInBoxScan,
+    InsertStation,
+    UpsertStation,
+    AllStationKeys,
+    AllStationsByKey,
+    NextStationEpochBoundary,
+    NextChannelEpochBoundary,
+    DataVersion,
+    ChannelStation,
+    InsertChannel,
+    ActiveChannel,
+    ChannelsActiveAt,
+    ChannelsActiveAtScan
+};
+constexpr size_t NUMBER_OF_QUERIES{18};
+
+[[nodiscard]] std::string_view toSQL(const Query query)
+{
+    if (query == Query::StationExists)
+    {
+        return
+R"""(
+SELECT COUNT(*) FROM station WHERE
+  network = ?1 AND
+  name = ?2 AND
+  ((start_time >= ?3 AND ?4 <= end_time) OR (start_time >= ?5 AND ?6 <= end_time))
+)""";
+    }
+    else if (query == Query::ActiveStation)
+    {
+        return
+R"""(
+SELECT network, name, description, latitude, longitude, elevation, start_time, end_time, last_modified FROM station WHERE
+  network = ?1 AND name = ?2 AND
+  unixepoch(CURRENT_TIMESTAMP) >= start_time AND unixepoch(CURRENT_TIMESTAMP) <= end_time LIMIT 1
+)""";
+    }
+    else if (query == Query::StationsActiveAt)
+    {
+        // The R*Tree stores 32-bit floats and rounds outward so it returns
+        // a superset of the candidate epochs which are then checked exactly.
+        return
+R"""(
+SELECT station.network, station.name, station.description, station.latitude, station.longitude, station.elevation, station.start_time, station.end_time, station.last_modified
+  FROM station_epoch JOIN station ON station.identifier = station_epoch.identifier WHERE
+  station_epoch.start_time <= ?1 AND station_epoch.end_time >= ?1 AND
+  station.start_time <= ?1 AND station.end_time >= ?1
+)""";
+    }
+    else if (query == Query::StationsActiveAtScan)
+    {
+        return
+R"""(
+SELECT network, name, description, latitude, longitude, elevation, start_time, end_time, last_modified FROM station WHERE
+  ?1 >= start_time AND ?1 <= end_time
+)""";
+    }
+    else if (query == Query::StationsInBox)
+    {
+        return
+R"""(
+SELECT station.network, station.name, station.description, station.latitude, station.longitude, station.elevation, station.start_time, station.end_time, station.last_modified
+  FROM station_location JOIN station ON station.identifier = station_location.identifier WHERE
+  station_location.max_latitude >= ?1 AND station_location.min_latitude <= ?2 AND
+  station_location.max_longitude >= ?3 AND station_location.min_longitude <= ?4 AND
+  station.latitude >= ?1 AND station.latitude <= ?2 AND
+  station.longitude >= ?3 AND station.longitude <= ?4 AND
+  station.start_time <= ?5 AND station.end_time >= ?5
+)""";
+    }
+    else if (query == Query::StationsInBoxScan)
+    {
+        return
+R"""(
+SELECT network, name, description, latitude, longitude, elevation, start_time, end_time, last_modified FROM station WHERE
+  latitude >= ?1 AND latitude <= ?2 AND longitude >= ?3 AND longitude <= ?4 AND
+  start_time <= ?5 AND end_time >= ?5
+)""";
+    }
+    else if (query == Query::InsertStation)
+    {
+        return
+R"""(
+INSERT INTO station (network, name, latitude, longitude, elevation, start_time, end_time, last_modified, description)
+  VALUES (?1, ?2, ?3, ?4, ?5, ?6, ?7, ?8, ?9)
+)""";
+    }
+    else if (query == Query::UpsertStation)
+    {
+        return
+R"""(
+INSERT INTO station (network, name, latitude, longitude, elevation, start_time, end_time, last_modified, description)
+  VALUES (?1, ?2, ?3, ?4, ?5, ?6, ?7, ?8, ?9)
+  ON CONFLICT(network, name, start_time) DO UPDATE SET
+    latitude = excluded.latitude, longitude = excluded.longitude, elevation = excluded.elevation,
+    end_time = excluded.end_time, last_modified = excluded.last_modified, description = excluded.description
+  WHERE excluded.last_modified > station.last_modified
+)""";
+    }
+    else if (query == Query::AllStationKeys)
+    {
+        return "SELECT network, name, start_time FROM station";
+    }
+    else if (query == Query::DataVersion)
+    {
+        return "PRAGMA data_version";
+    }
+    else if (query == Query::NextStationEpochBoundary)
+    {
+        // A station becomes active at its start time and inactive the second
+        // after its end time
+        return
+R"""(
+SELECT MIN(boundary) FROM (
+  SELECT MIN(start_time) AS boundary FROM station WHERE start_time > ?1
+  UNION ALL
+  SELECT MIN(end_time) + 1 AS boundary FROM station WHERE end_time >= ?1
+)
+)""";
+    }
+    else if (query == Query::NextChannelEpochBoundary)
+    {
+        return
+R"""(
+SELECT MIN(boundary) FROM (
+  SELECT MIN(start_time) AS boundary FROM channel WHERE start_time > ?1
+  UNION ALL
+  SELECT MIN(end_time) + 1 AS boundary FROM channel WHERE end_time >= ?1
+)
+)""";
+    }
+    else if (query == Query::AllStationsByKey)
+    {
+        return
+R"""(
+SELECT network, name, description, latitude, longitude, elevation, start_time, end_time, last_modified FROM station
+  ORDER BY network, name, start_time
+)""";
+    }
+    else if (query == Query::ChannelStation)
+    {
+        // The station epoch to which a channel epoch belongs
+        return
+R"""(
+SELECT identifier FROM station WHERE
+  network = ?1 AND name = ?2 AND start_time <= ?3 AND end_time >= ?3
+  ORDER BY start_time DESC LIMIT 1
+)""";
+    }
+    else if (query == Query::InsertChannel)
+    {
+        return
+R"""(
+INSERT INTO channel (station_identifier, name, location_code, latitude, longitude, elevation, sampling_rate, azimuth, dip, start_time, end_time, last_modified)
+  VALUES (?1, ?2, ?3, ?4, ?5, ?6, ?7, ?8, ?9, ?10, ?11, ?12)
+  ON CONFLICT(station_identifier, name, location_code, start_time) DO NOTHING
+)""";
+    }
+    else if (query == Query::ActiveChannel)
+    {
+        // Both lookups are covered by the tables' UNIQUE indices
+        return
+R"""(
+SELECT station.network, station.name, channel.name, channel.location_code, channel.latitude, channel.longitude, channel.elevation, channel.sampling_rate, channel.azimuth, channel.dip, channel.start_time, channel.end_time, channel.last_modified
+  FROM station JOIN channel ON channel.station_identifier = station.identifier WHERE
+  station.network = ?1 AND station.name = ?2 AND
+  channel.name = ?3 AND channel.location_code = ?4 AND
+  unixepoch(CURRENT_TIMESTAMP) >= channel.start_time AND unixepoch(CURRENT_TIMESTAMP) <= channel.end_time LIMIT 1
+)""";
+    }
+    else if (query == Query::ChannelsActiveAt)
+    {
+        return
+R"""(
+SELECT station.network, station.name, channel.name, channel.location_code, channel.latitude, channel.longitude, channel.elevation, channel.sampling_rate, channel.azimuth, channel.dip, channel.start_time, channel.end_time, channel.last_modified
+  FROM channel_epoch JOIN channel ON channel.identifier = channel_epoch.identifier
+  JOIN station ON station.identifier = channel.station_identifier WHERE
+  channel_epoch.start_time <= ?1 AND channel_epoch.end_time >= ?1 AND
+  channel.start_time <= ?1 AND channel.end_time >= ?1
+)""";
+    }
+    else if (query == Query::ChannelsActiveAtScan)
+    {
+        return
+R"""(
+SELECT station.network, station.name, channel.name, channel.location_code, channel.latitude, channel.longitude, channel.elevation, channel.sampling_rate, channel.azimuth, channel.dip, channel.start_time, channel.end_time, channel.last_modified
+  FROM channel JOIN station ON station.identifier = channel.station_identifier WHERE
+  ?1 >= channel.start_time AND ?1 <= channel.end_time
+)""";
+    }
+    throw std::invalid_argument("Unhandled query");
+}
+
+/// @brief Holds one prepared statement per query kind.  A statement is
+///        compiled on first use and is subsequently reset and rebound rather
+///        than re-prepared.
+/// @note This is not thread-safe.  The owner must serialize access.
+class StatementCache
+{
+public:
+    [[nodiscard]] sqlite3_stmt *get(sqlite3 *handle, const Query query)
+    {
+        auto index = static_cast<size_t> (query);
+        if (mStatements.at(index) == nullptr)
+        {
+            auto sql = ::toSQL(query);
+            sqlite3_stmt *statement{nullptr};
+            auto returnCode = sqlite3_prepare_v3(handle,
+                                                 sql.data(),
+                                                 static_cast<int> (sql.size()),
+                                                 SQLITE_PREPARE_PERSISTENT,
+                                                 &statement,
+                                                 nullptr);
+            SQLITE_CHECK_PREPARE(returnCode, statement);
+            mStatements[index] = statement;
+        }
+        return mStatements[index];
+    }
+    void finalize() noexcept
+    {
+        for (auto &statement : mStatements)
+        {
+            if (statement)
+            {
+                auto returnCode = sqlite3_finalize(statement);
+                SQLITE_CHECK_FINALIZE(returnCode);
+                statement = nullptr;
+            }
+        }
+    }
+    ~StatementCache()
+    {
+        finalize();
+    }
+private:
+    std::array<sqlite3_stmt *, NUMBER_OF_QUERIES> mStatements{};
+};
+
+/// @brief Resets a cached statement and clears its bindings on scope exit so
+///        the next caller receives a clean statement.
+class StatementReset
+{
+public:
+    explicit StatementReset(sqlite3_stmt *statement) :
+        mStatement(statement)
+    {
+    }
+    ~StatementReset()
+    {
+        sqlite3_reset(mStatement);
+        sqlite3_clear_bindings(mStatement);
+    }
+    StatementReset(const StatementReset &) = delete;
+    StatementReset& operator=(const StatementReset &) = delete;
+private:
+    sqlite3_stmt *mStatement{nullptr};
+};
+
+/// @brief A SQLite3 connection and its cache of prepared statements.  A
+///        connection is only ever used by one thread at a time so it is
+///        opened without SQLite's connection mutex.
+class Connection
+{
+public:
+    explicit Connection(sqlite3 *handle) :
+        mHandle(handle)
+    {
+    }
+    [[nodiscard]] sqlite3 *handle() const noexcept
+    {
+        return mHandle;
+    }
+    [[nodiscard]] sqlite3_stmt *statement(const Query query)
+    {
+        return mStatements.get(mHandle, query);
+    }
+    void close() noexcept
+    {
+        // Cached statements must be finalized before the connection closes
+        mStatements.finalize();
+        if (mHandle)
+        {
+            if (sqlite3_close(mHandle) != SQLITE_OK)
+            {
+                spdlog::warn("Failed to close sqlite3 connection");
+            }
+            mHandle = nullptr;
+        }
+    }
+    ~Connection()
+    {
+        close();
+    }
+    Connection(const Connection &) = delete;
+    Connection& operator=(const Connection &) = delete;
+private:
+    sqlite3 *mHandle{nullptr};
+    StatementCache mStatements;
+};
+
+/// @brief A pool of connections.  A caller checks out a connection for the
+///        duration of a query so that concurrent readers do not serialize on
+///        a shared connection.  Connections are opened on demand up to the
+///        maximum pool size after which callers wait for a connection to be
+///        returned.
+class ConnectionPool
+{
+public:
+    /// @brief Returns the connection to the pool on scope exit.
+    class Lease
+    {
+    public:
+        Lease(ConnectionPool *pool, Connection *connection) :
+            mPool(pool),
+            mConnection(connection)
+        {
+        }
+        Lease(Lease &&lease) noexcept :
+            mPool(lease.mPool),
+            mConnection(lease.mConnection)
+        {
+            lease.mConnection = nullptr;
+        }
+        ~Lease()
+        {
+            if (mConnection){mPool->release(mConnection);}
+        }
+        [[nodiscard]] Connection *operator->() const noexcept
+        {
+            return mConnection;
+        }
+        [[nodiscard]] Connection &operator*() const noexcept
+        {
+            return *mConnection;
+        }
+        Lease(const Lease &) = delete;
+        Lease& operator=(const Lease &) = delete;
+        Lease& operator=(Lease &&) = delete;
+    private:
+        ConnectionPool *mPool{nullptr};
+        Connection *mConnection{nullptr};
+    };
+
+    /// @brief Opens the pool.  The first connection is opened immediately so
+    ///        that a bad database is detected up front.
+    void open(std::function<sqlite3 * ()> factory, const size_t maximumSize)
+    {
+        if (maximumSize < 1)
+        {
+            throw std::invalid_argument("Pool size must be positive");
+        }
+        auto connection = std::make_unique<Connection> (factory());
+        std::lock_guard<std::mutex> lock(mMutex);
+        mFactory = std::move(factory);
+        mMaximumSize = maximumSize;
+        mIdle.push_back(connection.get());
+        mConnections.push_back(std::move(connection));
+        mOpen = true;
+    }
+    [[nodiscard]] Lease acquire()
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        while (true)
+        {
+            if (!mOpen)
+            {
+                throw std::runtime_error("database not initialized");
+            }
+            if (!mIdle.empty())
+            {
+                auto connection = mIdle.back();
+                mIdle.pop_back();
+                return Lease{this, connection};
+            }
+            if (mConnections.size() + mPending < mMaximumSize)
+            {
+                // Open the connection outside of the lock
+                mPending = mPending + 1;
+                lock.unlock();
+                std::unique_ptr<Connection> connection{nullptr};
+                try
+                {
+                    connection = std::make_unique<Connection> (mFactory());
+                }
+                catch (...)
+                {
+                    lock.lock();
+                    mPending = mPending - 1;
+                    mConditionVariable.notify_all();
+                    throw;
+                }
+                lock.lock();
+                mPending = mPending - 1;
+                auto result = connection.get();
+                mConnections.push_back(std::move(connection));
+                return Lease{this, result};
+            }
+            mConditionVariable.wait(lock);
+        }
+    }
+    /// @brief Closes the pool.  This waits for outstanding leases.
+    void close()
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mOpen = false;
+        mConditionVariable.wait(lock, [this]()
+        {
+            return mPending == 0 && mIdle.size() == mConnections.size();
+        });
+        mIdle.clear();
+        mConnections.clear();
+        mConditionVariable.notify_all();
+    }
+    [[nodiscard]] bool isOpen() const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mOpen;
+    }
+private:
+    void release(Connection *connection)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mIdle.push_back(connection);
+        mConditionVariable.notify_all();
+    }
+    mutable std::mutex mMutex;
+    std::condition_variable mConditionVariable;
+    std::function<sqlite3 * ()> mFactory;
+    std::vector<std::unique_ptr<Connection>> mConnections;
+    std::vector<Connection *> mIdle;
+    size_t mMaximumSize{1};
+    size_t mPending{0};
+    bool mOpen{false};
+};
+
+/// @brief Runs the asynchronous queries.  The threads lease connections from
+///        a pool of their own, sized to the number of threads, so that the
+///        asynchronous queries neither wait for nor hold up the connections
+///        of synchronous callers.
+class AsyncQueryExecutor
+{
+public:
+    /// @param[in] owner    The database whose queries these threads run.
+    /// @param[in] factory  Opens a read-only connection.
+    AsyncQueryExecutor(const void *owner,
+                       std::function<sqlite3 * ()> factory,
+                       const int nThreads) :
+        mOwner(owner)
+    {
+        if (nThreads < 1)
+        {
+            throw std::invalid_argument("Number of threads must be positive");
+        }
+        mPool.open(std::move(factory), static_cast<size_t> (nThreads));
+        mThreads.reserve(static_cast<size_t> (nThreads));
+        for (int i = 0; i < nThreads; ++i)
+        {
+            mThreads.emplace_back(&AsyncQueryExecutor::run, this);
+        }
+    }
+    /// Queued queries are run before the threads exit.
+    ~AsyncQueryExecutor()
+    {
+        {
+            const std::lock_guard<std::mutex> lock(mMutex);
+            mKeepRunning = false;
+        }
+        mConditionVariable.notify_all();
+        for (auto &thread : mThreads)
+        {
+            if (thread.joinable()){thread.join();}
+        }
+        mPool.close();
+    }
+    AsyncQueryExecutor(const AsyncQueryExecutor &) = delete;
+    AsyncQueryExecutor& operator=(const AsyncQueryExecutor &) = delete;
+    void submit(std::function<void ()> &&work)
+    {
+        {
+            const std::lock_guard<std::mutex> lock(mMutex);
+            mQueue.push_back(std::move(work));
+        }
+        mConditionVariable.notify_one();
+    }
+    /// @result The connection pool of the given database's asynchronous
+    ///         query threads if the calling thread is one of them.
+    ///         Otherwise, NULL.
+    [[nodiscard]] static ConnectionPool *getThreadPool(const void *owner)
+        noexcept
+    {
+        const auto executor = threadExecutor;
+        return executor && executor->mOwner == owner ?
+               &executor->mPool : nullptr;
+    }
+private:
+    void run()
+    {
+        threadExecutor = this;
+        while (true)
+        {
+            std::function<void ()> work;
+            {
+                std::unique_lock<std::mutex> lock(mMutex);
+                mConditionVariable.wait(lock, [this]()
+                                        {
+                                            return !mKeepRunning ||
+                                                   !mQueue.empty();
+                                        });
+                if (mQueue.empty()){break;}
+                work = std::move(mQueue.front());
+                mQueue.pop_front();
+            }
+            try
+            {
+                work();
+            }
+            catch (const std::exception &e)
+            {
+                spdlog::error("Asynchronous query failed because "
+                            + std::string {e.what()});
+            }
+        }
+        threadExecutor = nullptr;
+    }
+    static inline thread_local AsyncQueryExecutor *threadExecutor{nullptr};
+    ConnectionPool mPool;
+    std::mutex mMutex;
+    std::condition_variable mConditionVariable;
+    std::deque<std::function<void ()>> mQueue;
+    std::vector<std::thread> mThreads;
+    const void *mOwner{nullptr};
+    bool mKeepRunning{true};
+};
+
+/// @brief Executes SQL that returns no rows of interest.
+void execute(sqlite3 *handle, const char *sql)
+{
+    char *errorMessage{nullptr};
+    auto returnCode = sqlite3_exec(handle,
+                                   sql,
+                                   nullptr,
+                                   nullptr,
+                                   &errorMessage);
+    if (returnCode != SQLITE_OK)
+    {
+        std::string error{"Failed to execute " + std::string {sql}};
+        if (errorMessage)
+        {
+            error = error + " because " + std::string {errorMessage};
+            sqlite3_free(errorMessage);
+        }
+        throw std::runtime_error(error);
+    }
+}
+
+/// The calling thread's query profile.  Each thread only touches its own so
+/// profiling never contends with queries on other threads.
+thread_local UMetadata::Database::QueryProfile threadQueryProfile;
+
+/// Whether queries time their steps and rows.  Off by default since it costs
+/// two clock reads per row in every hot loop.
+std::atomic<bool> queryProfiling{false};
+
+/// @brief Steps the statement and, when profiling, adds the time to the
+///        thread's profile.
+[[nodiscard]] int profiledStep(sqlite3_stmt *statement)
+{
+    if (!queryProfiling.load(std::memory_order_relaxed))
+    {
+        return sqlite3_step(statement);
+    }
+    const auto startTime = std::chrono::steady_clock::now();
+    const auto returnCode = sqlite3_step(statement);
+    threadQueryProfile.step += std::chrono::steady_clock::now() - startTime;
+    return returnCode;
+}
+
+/// @brief Counts a decoded row and, when profiling, adds the time spent
+///        decoding it to the thread's profile.
+class UnpackTimer
+{
+public:
+    UnpackTimer() :
+        mProfiling(queryProfiling.load(std::memory_order_relaxed))
+    {
+        if (mProfiling){mStartTime = std::chrono::steady_clock::now();}
+    }
+    ~UnpackTimer()
+    {
+        if (mProfiling)
+        {
+            threadQueryProfile.unpack
+                += std::chrono::steady_clock::now() - mStartTime;
+        }
+        ++threadQueryProfile.rows;
+    }
+    UnpackTimer(const UnpackTimer &) = delete;
+    UnpackTimer& operator=(const UnpackTimer &) = delete;
+private:
+    std::chrono::steady_clock::time_point mStartTime;
+    bool mProfiling{false};
+};
+
+#ifdef WITH_TRACING
+/// @brief Traces a query.  The span is active while the query runs so the
+///        wait for a connection is its child, and, when the span is sampled,
+///        it ends with the rows decoded and the time the query spent
+///        stepping and decoding them.
+class QuerySpan
+{
+public:
+    /// @param[in] name  The span's name, e.g., Database.getStationsActiveAt.
+    ///                  This is a literal so that starting a span does not
+    ///                  allocate.
+    QuerySpan(const ::TracerHandle &tracer, const char *name) :
+        mSpan(tracer->StartSpan(name,
+                                {{"db.system", "sqlite"},
+                                 {"db.operation", name + PREFIX.size()}})),
+        mScope(mSpan),
+        mStartProfile(threadQueryProfile)
+    {
+    }
+    ~QuerySpan()
+    {
+        if (mSpan->IsRecording())
+        {
+            // The thread's profile only grows while the span is open
+            const auto &profile = threadQueryProfile;
+            mSpan->SetAttribute("db.response.returned_rows",
+                static_cast<int64_t> (profile.rows - mStartProfile.rows));
+            mSpan->SetAttribute("db.sqlite.step_us",
+                std::chrono::duration_cast<std::chrono::microseconds>
+                (profile.step - mStartProfile.step).count());
+            mSpan->SetAttribute("db.sqlite.unpack_us",
+                std::chrono::duration_cast<std::chrono::microseconds>
+                (profile.unpack - mStartProfile.unpack).count());
+        }
+        mSpan->End();
+    }
+    QuerySpan(const QuerySpan &) = delete;
+    QuerySpan& operator=(const QuerySpan &) = delete;
+private:
+    static constexpr std::string_view PREFIX{"Database."};
+    opentelemetry::nostd::shared_ptr<opentelemetry::trace::Span> mSpan;
+    opentelemetry::trace::Scope mScope;
+    UMetadata::Database::QueryProfile mStartProfile;
+};
+#else
+/// @brief Without tracing a query span costs nothing.
+class QuerySpan
+{
+public:
+    QuerySpan(const ::TracerHandle &, const char *) noexcept
+    {
+    }
+    QuerySpan(const QuerySpan &) = delete;
+    QuerySpan& operator=(const QuerySpan &) = delete;
+};
+#endif
+
+/// @brief Steps the statement.  If the database remains busy or locked after
+///        the connection's busy handler gives up then the statement is reset
+///        and retried with an exponential back-off.
+/// @note Only use this for the first step of a statement since a reset
+///       rewinds the result set.
+[[nodiscard]] int stepWithRetry(sqlite3_stmt *statement)
+{
+    constexpr int maximumRetries{5};
+    auto returnCode = ::profiledStep(statement);
+    for (int retry = 0; retry < maximumRetries; ++retry)
+    {
+        if (returnCode != SQLITE_BUSY && returnCode != SQLITE_LOCKED)
+        {
+            break;
+        }
+        spdlog::debug("Database busy; retrying query");
+        sqlite3_reset(statement);
+        std::this_thread::sleep_for(std::chrono::milliseconds {10 << retry});
+        returnCode = ::profiledStep(statement);
+    }
+    return returnCode;
+}
+
+/// @result The great-circle distance in kilometers between two points.
+[[nodiscard]] double haversineDistance(const double latitude1,
+                                       const double longitude1,
+                                       const double latitude2,
+                                       const double longitude2)
+{
+    constexpr double earthRadius{6371.0}; // Mean radius in km
+    constexpr double toRadians{std::numbers::pi/180.0};
+    const double dLatitude = (latitude2 - latitude1)*toRadians;
+    const double dLongitude = (longitude2 - longitude1)*toRadians;
+    const double sinLatitude = std::sin(dLatitude/2);
+    const double sinLongitude = std::sin(dLongitude/2);
+    const double a = sinLatitude*sinLatitude
+                   + std::cos(latitude1*toRadians)*std::cos(latitude2*toRadians)
+                    *sinLongitude*sinLongitude;
+    return 2*earthRadius*std::asin(std::min(1.0, std::sqrt(a)));
+}
+
+/// @result The longitude ranges covered by [minimumLongitude,
+///         maximumLongitude].  A box whose minimum longitude exceeds its
+///         maximum longitude crosses the antimeridian and is split in two.
+[[nodiscard]] std::vector<std::pair<double, double>>
+    toLongitudeRanges(const double minimumLongitude,
+                      const double maximumLongitude)
+{
+    if (minimumLongitude <= maximumLongitude)
+    {
+        return {{minimumLongitude, maximumLongitude}};
+    }
+    return {{minimumLongitude, 180.0}, {-180.0, maximumLongitude}};
+}
+
+/// @result The peak resident set size of this process in bytes.
+[[nodiscard]] int64_t getPeakResidentSetSize()
+{
+    struct rusage usage{};
+    if (getrusage(RUSAGE_SELF, &usage) != 0){return 0;}
+    // Linux reports this in kilobytes
+    return static_cast<int64_t> (usage.ru_maxrss)*1024;
+}
+
+/// @brief A station to reconcile with the table and its unique key.
+struct IncomingStation
+{
+    [[nodiscard]] std::tuple<const std::string &,
+                             const std::string &,
+                             int64_t> key() const noexcept
+    {
+        return std::tie(network, name, startTime);
+    }
+    std::string network;
+    std::string name;
+    int64_t startTime{0};
+    const UMetadata::Station *station{nullptr};
+};
+
+/// @brief Reads every property the station table requires.
+/// @throws std::runtime_error if one is not set.
+void validateStation(const UMetadata::Station &station)
+{
+    [[maybe_unused]] auto network = station.getNetwork();
+    [[maybe_unused]] auto name = station.getName();
+    [[maybe_unused]] auto latitude = station.getLatitude();
+    [[maybe_unused]] auto longitude = station.getLongitude();
+    [[maybe_unused]] auto elevation = station.getElevation();
+    [[maybe_unused]] auto startAndEndTime = station.getStartAndEndTime();
+}
+
+/// @result True if anything other than the key or modification time differs.
+[[nodiscard]] bool hasChanged(const UMetadata::Station &current,
+                              const UMetadata::Station &station)
+{
+    if (current.getLatitude() != station.getLatitude()){return true;}
+    if (current.getLongitude() != station.getLongitude()){return true;}
+    if (current.getElevation() != station.getElevation()){return true;}
+    if (current.getStartAndEndTime().second !=
+        station.getStartAndEndTime().second)
+    {
+        return true;
+    }
+    return current.getDescription() != station.getDescription();
+}
+
+/// @result True if the only change is that the epoch now ends earlier.
+[[nodiscard]] bool isClosure(const UMetadata::Station &current,
+                             const UMetadata::Station &station)
+{
+    if (station.getStartAndEndTime().second >=
+        current.getStartAndEndTime().second)
+    {
+        return false;
+    }
+    return current.getLatitude() == station.getLatitude() &&
+           current.getLongitude() == station.getLongitude() &&
+           current.getElevation() == station.getElevation() &&
+           current.getDescription() == station.getDescription();
+}
+
+/// @result The key on which the station table is unique.
+[[nodiscard]] std::string toStationKey(const std::string_view &network,
+                                       const std::string_view &name,
+                                       const int64_t startTime)
 {
+    std::string result;
+    result.reserve(network.size() + name.size() + 22);
+    result.append(network);
+    result.push_back('.');
+    result.append(name);
+    result.push_back('.');
+    result.append(std::to_string(startTime));
+    return result;
+}
+
 /*
 [[nodiscard]] std::chrono::microseconds getNow() 
 {    
@@ -62,9 +924,9 @@ namespace
      return now;        
 }                    
 */
-[[nodiscard]] UMetadata::Station unpackStationRow(sqlite3_stmt *statement)
+void unpackStationRow(sqlite3_stmt *statement, UMetadata::Station &result)
 {
-     UMetadata::Station result;
+     result.clear();
      const std::string network{
          reinterpret_cast<const char *> (sqlite3_column_text(statement, 0))};
      result.setNetwork(network);
@@ -101,7 +963,118 @@ namespace
               std::floor(sqlite3_column_double(statement, 8)*1.e6));
      result.setLastModified(
          std::chrono::microseconds {lastModified} );
+}
+
+/// @result The text in the column as a view into SQLite's buffer.
+[[nodiscard]] std::string_view columnText(sqlite3_stmt *statement,
+                                          const int column)
+{
+    // Must fetch the text before the byte count
+    auto text
+        = reinterpret_cast<const char *> (sqlite3_column_text(statement, column));
+    if (text == nullptr){return {};}
+    return std::string_view {text,
+                             static_cast<size_t>
+                             (sqlite3_column_bytes(statement, column))};
+}
+
+/// @brief Sets a timestamp from microseconds since the epoch.
+void setTimestamp(const int64_t microseconds,
+                  google::protobuf::Timestamp *timestamp)
+{
+    constexpr int64_t microsecondsPerSecond{1000000};
+    auto seconds = microseconds/microsecondsPerSecond;
+    auto remainder = microseconds%microsecondsPerSecond;
+    if (remainder < 0)
+    {
+        seconds = seconds - 1;
+        remainder = remainder + microsecondsPerSecond;
+    }
+    timestamp->set_seconds(seconds);
+    timestamp->set_nanos(static_cast<int32_t> (remainder*1000));
+}
 
+/// @brief Decodes a station row directly into a protobuf.  This skips the
+///        validation performed by UMetadata::Station's setters.
+void unpackStationRow(sqlite3_stmt *statement,
+                      UMetadataAPI::V1::Station *station)
+{
+     const auto network = ::columnText(statement, 0);
+     station->set_network(network.data(), network.size());
+     const auto name = ::columnText(statement, 1);
+     station->set_name(name.data(), name.size());
+     if (sqlite3_column_type(statement, 2) != SQLITE_NULL)
+     {
+         const auto description = ::columnText(statement, 2);
+         station->set_description(description.data(), description.size());
+     }
+     station->set_latitude(sqlite3_column_double(statement, 3));
+     station->set_longitude(sqlite3_column_double(statement, 4));
+     station->set_elevation(sqlite3_column_double(statement, 5));
+     station->mutable_start_time()->set_seconds(
+         sqlite3_column_int64(statement, 6));
+     station->mutable_end_time()->set_seconds(
+         sqlite3_column_int64(statement, 7));
+     ::setTimestamp(static_cast<int64_t> (
+                       std::floor(sqlite3_column_double(statement, 8)*1.e6)),
+                    station->mutable_last_modified());
+}
+
+[[nodiscard]] UMetadata::Channel unpackChannelRow(sqlite3_stmt *statement)
+{
+     UMetadata::Channel result;
+     result.setNetwork(std::string {::columnText(statement, 0)});
+     result.setStation(std::string {::columnText(statement, 1)});
+     result.setName(std::string {::columnText(statement, 2)});
+     result.setLocationCode(std::string {::columnText(statement, 3)});
+     result.setLatitude(sqlite3_column_double(statement, 4));
+     result.setLongitude(sqlite3_column_double(statement, 5));
+     result.setElevation(sqlite3_column_double(statement, 6));
+     result.setSamplingRate(sqlite3_column_double(statement, 7));
+     result.setAzimuth(sqlite3_column_double(statement, 8));
+     result.setDip(sqlite3_column_double(statement, 9));
+     result.setStartAndEndTime(
+        std::pair { std::chrono::seconds {sqlite3_column_int64(statement, 10)},
+                    std::chrono::seconds {sqlite3_column_int64(statement, 11)} });
+     auto lastModified
+         = static_cast<int64_t> (
+              std::floor(sqlite3_column_double(statement, 12)*1.e6));
+     result.setLastModified(std::chrono::microseconds {lastModified});
+     return result;
+}
+
+/// @brief Decodes a channel row directly into a protobuf.  This skips the
+///        validation performed by UMetadata::Channel's setters.
+void unpackChannelRow(sqlite3_stmt *statement,
+                      UMetadataAPI::V1::Channel *channel)
+{
+     const auto network = ::columnText(statement, 0);
+     channel->set_network(network.data(), network.size());
+     const auto station = ::columnText(statement, 1);
+     channel->set_station(station.data(), station.size());
+     const auto name = ::columnText(statement, 2);
+     channel->set_name(name.data(), name.size());
+     const auto locationCode = ::columnText(statement, 3);
+     channel->set_location_code(locationCode.data(), locationCode.size());
+     channel->set_latitude(sqlite3_column_double(statement, 4));
+     channel->set_longitude(sqlite3_column_double(statement, 5));
+     channel->set_elevation(sqlite3_column_double(statement, 6));
+     channel->set_sampling_rate(sqlite3_column_double(statement, 7));
+     channel->set_azimuth(sqlite3_column_double(statement, 8));
+     channel->set_dip(sqlite3_column_double(statement, 9));
+     channel->mutable_start_time()->set_seconds(
+         sqlite3_column_int64(statement, 10));
+     channel->mutable_end_time()->set_seconds(
+         sqlite3_column_int64(statement, 11));
+     ::setTimestamp(static_cast<int64_t> (
+                       std::floor(sqlite3_column_double(statement, 12)*1.e6)),
+                    channel->mutable_last_modified());
+}
+
+[[nodiscard]] UMetadata::Station unpackStationRow(sqlite3_stmt *statement)
+{
+     UMetadata::Station result;
+     ::unpackStationRow(statement, result);
      return result;
 }
 }
@@ -113,7 +1086,10 @@ class Database::DatabaseImpl
 {
 public:
     //DatabaseImpl() = default;
-    DatabaseImpl(const std::filesystem::path &fileName, const bool readOnly)
+    DatabaseImpl(const std::filesystem::path &fileName,
+                 const bool readOnly,
+                 const DatabaseOptions &options) :
+        mOptions(options)
     {
         if (readOnly)
         {
@@ -126,17 +1102,207 @@ public:
         }
         else
         {
+            if (mOptions.getServingMode() ==
+                DatabaseOptions::ServingMode::InMemory)
+            {
+                spdlog::warn("In-memory serving is only available to read-only "
+                             "databases; serving read-write database from "
+                             "file");
+                mOptions.setServingMode(DatabaseOptions::ServingMode::File);
+            }
             if (!std::filesystem::exists(fileName))
             {
                 openCreateReadWrite(fileName);
                 createStationTable();
                 createChannelTable();
+                setSchemaVersion();
             }
             else
             {
                 openReadWrite(fileName);
+                migrateSchema();
+            }
+            setJournalMode();
+            createEpochIndex(STATION_TABLE);
+            createEpochIndex(CHANNEL_TABLE);
+            createLocationIndex(STATION_TABLE);
+        }
+        mHaveStationEpochIndex = tableExists(STATION_EPOCH_INDEX);
+        if (!mHaveStationEpochIndex)
+        {
+            spdlog::warn(std::string {STATION_EPOCH_INDEX}
+                       + " does not exist; time queries will scan the table");
+        }
+        mHaveChannelTable = tableExists(CHANNEL_TABLE);
+        mHaveChannelEpochIndex = tableExists(CHANNEL_EPOCH_INDEX);
+        if (mHaveChannelTable && !mHaveChannelEpochIndex)
+        {
+            spdlog::warn(std::string {CHANNEL_EPOCH_INDEX}
+                       + " does not exist; channel time queries will scan the table");
+        }
+        mHaveStationLocationIndex = tableExists(STATION_LOCATION_INDEX);
+        if (!mHaveStationLocationIndex)
+        {
+            spdlog::warn(std::string {STATION_LOCATION_INDEX}
+                       + " does not exist; spatial queries will scan the table");
+        }
+    }
+    /// Creates the R*Tree interval index over the table's
+    /// [start_time, end_time] epochs.
+    void createEpochIndex(const std::string &table)
+    {
+        createRTreeIndex(table,
+                         table + "_epoch",
+                         {{"start_time", "end_time", "start_time", "end_time"}});
+    }
+    /// Creates the R*Tree spatial index over the table's points.
+    void createLocationIndex(const std::string &table)
+    {
+        createRTreeIndex(table,
+                         table + "_location",
+                         {{"min_latitude", "max_latitude",
+                           "latitude", "latitude"},
+                          {"min_longitude", "max_longitude",
+                           "longitude", "longitude"}});
+    }
+    /// Creates an R*Tree index.  Each dimension is given by the R*Tree's
+    /// minimum and maximum column names followed by the table's columns from
+    /// which they are populated.  Triggers keep the index synchronized with
+    /// the table.  Existing rows are indexed when the index is created.
+    void createRTreeIndex(const std::string &table,
+                          const std::string &index,
+                          const std::vector<std::array<std::string, 4>> &dimensions)
+    {
+        if (tableExists(index)){return;}
+        spdlog::info("Creating R*Tree index " + index);
+        std::string indexColumns;
+        std::string tableColumns;
+        std::string newColumns;
+        std::string setColumns;
+        std::string updateOf;
+        for (const auto &dimension : dimensions)
+        {
+            indexColumns += ", " + dimension[0] + ", " + dimension[1];
+            tableColumns += ", " + dimension[2] + ", " + dimension[3];
+            newColumns += ", new." + dimension[2] + ", new." + dimension[3];
+            if (!setColumns.empty()){setColumns += ", ";}
+            setColumns += dimension[0] + " = new." + dimension[2] + ", "
+                        + dimension[1] + " = new." + dimension[3];
+            if (updateOf.find(dimension[2]) == std::string::npos)
+            {
+                if (!updateOf.empty()){updateOf += ", ";}
+                updateOf += dimension[2];
+            }
+            if (updateOf.find(dimension[3]) == std::string::npos)
+            {
+                updateOf += ", " + dimension[3];
+            }
+        }
+        const std::string sql{
+            "CREATE VIRTUAL TABLE " + index
+          + " USING rtree(identifier" + indexColumns + ");"
+          + "INSERT INTO " + index
+          + " SELECT identifier" + tableColumns + " FROM " + table + ";"
+          + "CREATE TRIGGER " + index + "_insert AFTER INSERT ON " + table
+          + " BEGIN INSERT INTO " + index
+          + " VALUES (new.identifier" + newColumns + "); END;"
+          + "CREATE TRIGGER " + index + "_update"
+          + " AFTER UPDATE OF " + updateOf + " ON " + table
+          + " BEGIN UPDATE " + index + " SET " + setColumns
+          + " WHERE identifier = new.identifier; END;"
+          + "CREATE TRIGGER " + index + "_delete AFTER DELETE ON " + table
+          + " BEGIN DELETE FROM " + index
+          + " WHERE identifier = old.identifier; END;"};
+        auto connection = mPool.acquire();
+        ::execute(connection->handle(), "BEGIN IMMEDIATE TRANSACTION");
+        try
+        {
+            ::execute(connection->handle(), sql.c_str());
+            ::execute(connection->handle(), "COMMIT TRANSACTION");
+        }
+        catch (const std::exception &e)
+        {
+            spdlog::warn("Failed to create " + index + " because "
+                       + std::string {e.what()});
+            // The index is optional so a failed rollback must not escape
+            try
+            {
+                ::execute(connection->handle(), "ROLLBACK TRANSACTION");
+            }
+            catch (const std::exception &rollbackError)
+            {
+                spdlog::error(rollbackError.what());
+            }
+        }
+    }
+    /// Opens a connection to the database.  The connection waits on another
+    /// connection's lock for the busy timeout rather than immediately failing.
+    [[nodiscard]] sqlite3 *openConnection(const int flags) const
+    {
+        sqlite3 *handle{nullptr};
+        const bool inMemory{mInMemoryHandle != nullptr};
+        auto returnCode = sqlite3_open_v2(mURI.c_str(),
+                                          &handle,
+                                          flags | SQLITE_OPEN_NOMUTEX |
+                                          (inMemory ? SQLITE_OPEN_URI : 0),
+                                          nullptr);
+        if (returnCode != SQLITE_OK)
+        {
+            sqlite3_close(handle);
+            throw std::runtime_error("Failed to open sqlite3 database "
+                                   + mURI);
+        }
+        auto timeout = static_cast<int> (mOptions.getBusyTimeout().count());
+        returnCode = sqlite3_busy_timeout(handle, timeout);
+        if (returnCode != SQLITE_OK)
+        {
+            spdlog::warn("Failed to set busy timeout on " + mURI);
+        }
+        if (inMemory){return handle;}
+        try
+        {
+            if (mOptions.getServingMode() ==
+                DatabaseOptions::ServingMode::MemoryMapped)
+            {
+                ::execute(handle,
+                          ("PRAGMA mmap_size="
+                         + std::to_string(mOptions.getMemoryMapSize())).c_str());
+            }
+            if (mOptions.getCacheSize() > 0)
+            {
+                // A negative cache size is interpreted as kibibytes
+                ::execute(handle,
+                          ("PRAGMA cache_size=-"
+                         + std::to_string(
+                              std::max<int64_t> (1,
+                                                 mOptions.getCacheSize()/1024))
+                          ).c_str());
             }
         }
+        catch (const std::exception &e)
+        {
+            spdlog::warn("Failed to tune " + mURI + " because "
+                       + std::string {e.what()});
+        }
+        return handle;
+    }
+    /// Sets the journal mode.  This persists in the database file so
+    /// subsequent read-only connections will read from the write-ahead log.
+    void setJournalMode()
+    {
+        auto connection = mPool.acquire();
+        if (mOptions.getJournalMode() == DatabaseOptions::JournalMode::WAL)
+        {
+            spdlog::info("Setting journal mode to WAL on " + mURI);
+            ::execute(connection->handle(), "PRAGMA journal_mode=WAL");
+            // Durable across application crashes and far fewer fsyncs
+            ::execute(connection->handle(), "PRAGMA synchronous=NORMAL");
+        }
+        else
+        {
+            spdlog::info("Setting journal mode to DELETE on " + mURI);
+            ::execute(connection->handle(), "PRAGMA journal_mode=DELETE");
+        }
     }
     void openReadOnly(const std::filesystem::path &fileName)
     {
@@ -146,38 +1312,139 @@ public:
         }
         //mURI = "file:/" + fileName.string();
         mURI = fileName.string();
-        spdlog::info("Opening sqlite3 " + mURI + " in read-only mode");
-        auto returnCode = sqlite3_open_v2(mURI.c_str(),
-                                          &mDatabaseHandle,
-                                          SQLITE_OPEN_READONLY |
-                                          SQLITE_OPEN_FULLMUTEX,
+        const auto startTime = std::chrono::steady_clock::now();
+        const auto startMemory = sqlite3_memory_used();
+        const auto servingMode = mOptions.getServingMode();
+        if (servingMode == DatabaseOptions::ServingMode::InMemory)
+        {
+            loadIntoMemory(fileName);
+        }
+        auto poolSize = mOptions.getReadConnectionPoolSize();
+        spdlog::info("Opening sqlite3 " + mURI
+                   + " in read-only mode with up to "
+                   + std::to_string(poolSize) + " connections");
+        mPool.open([this]()
+                   {
+                       return openConnection(SQLITE_OPEN_READONLY);
+                   },
+                   static_cast<size_t> (poolSize));
+        mHaveReadOnlyDatabase = true;
+        mHaveReadWriteDatabase = false;
+        // Report what each serving mode costs to bring up
+        const std::chrono::duration<double> loadTime
+            = std::chrono::steady_clock::now() - startTime;
+        std::string mode{"file"};
+        if (servingMode == DatabaseOptions::ServingMode::MemoryMapped)
+        {
+            mode = "memory-mapped";
+        }
+        else if (servingMode == DatabaseOptions::ServingMode::InMemory)
+        {
+            mode = "in-memory";
+        }
+        spdlog::info("Opened " + fileName.string() + " in " + mode
+                   + " serving mode in "
+                   + std::to_string(loadTime.count()) + " s; this added "
+                   + std::to_string(
+                        (sqlite3_memory_used() - startMemory)/1024)
+                   + " kB to SQLite's heap and the process's peak resident "
+                   + "set size is now "
+                   + std::to_string(::getPeakResidentSetSize()/1024) + " kB");
+    }
+    /// Copies the database file into a named in-memory database that every
+    /// pooled connection shares.  The copy is taken from a consistent
+    /// snapshot so it includes any committed pages still in the WAL.
+    void loadIntoMemory(const std::filesystem::path &fileName)
+    {
+        spdlog::info("Loading " + fileName.string() + " into memory");
+        sqlite3 *source{nullptr};
+        auto returnCode = sqlite3_open_v2(fileName.c_str(),
+                                          &source,
+                                          SQLITE_OPEN_READONLY,
                                           nullptr);
         if (returnCode != SQLITE_OK)
         {
-            sqlite3_close(mDatabaseHandle);
+            sqlite3_close(source);
             throw std::runtime_error("Failed to open sqlite3 database "
                                    + fileName.string());
         }
-        mHaveReadOnlyDatabase = true;
-        mHaveReadWriteDatabase = false;
+        sqlite3_busy_timeout(source,
+                             static_cast<int> (mOptions.getBusyTimeout().count()));
+        sqlite3_int64 size{0};
+        auto *image = sqlite3_serialize(source, "main", &size, 0);
+        sqlite3_close(source);
+        if (image == nullptr)
+        {
+            throw std::runtime_error("Failed to serialize "
+                                   + fileName.string());
+        }
+        // The in-memory VFS cannot use a write-ahead log so mark the image's
+        // file format as a rollback-journal database
+        if (size > 19){image[18] = 1; image[19] = 1;}
+        // A deserialized database is private to its connection so back it up
+        // into the shared one.  SQLite frees the image when staging closes.
+        sqlite3 *staging{nullptr};
+        returnCode = sqlite3_open(":memory:", &staging);
+        if (returnCode != SQLITE_OK)
+        {
+            sqlite3_free(image);
+            sqlite3_close(staging);
+            throw std::runtime_error("Failed to open staging database for "
+                                   + fileName.string());
+        }
+        returnCode = sqlite3_deserialize(staging, "main", image, size, size,
+                                         SQLITE_DESERIALIZE_FREEONCLOSE |
+                                         SQLITE_DESERIALIZE_READONLY);
+        if (returnCode != SQLITE_OK)
+        {
+            sqlite3_close(staging);
+            throw std::runtime_error("Failed to deserialize "
+                                   + fileName.string());
+        }
+        static std::atomic<int> instance{0};
+        mURI = "file:/uMetadata-" + std::to_string(instance++) + "?vfs=memdb";
+        returnCode = sqlite3_open_v2(mURI.c_str(),
+                                     &mInMemoryHandle,
+                                     SQLITE_OPEN_READWRITE |
+                                     SQLITE_OPEN_CREATE |
+                                     SQLITE_OPEN_URI,
+                                     nullptr);
+        if (returnCode == SQLITE_OK)
+        {
+            auto backup = sqlite3_backup_init(mInMemoryHandle, "main",
+                                              staging, "main");
+            if (backup)
+            {
+                sqlite3_backup_step(backup, -1);
+                returnCode = sqlite3_backup_finish(backup);
+            }
+            else
+            {
+                returnCode = sqlite3_errcode(mInMemoryHandle);
+            }
+        }
+        sqlite3_close(staging);
+        if (returnCode != SQLITE_OK)
+        {
+            sqlite3_close(mInMemoryHandle);
+            mInMemoryHandle = nullptr;
+            throw std::runtime_error("Failed to copy " + fileName.string()
+                                   + " into memory");
+        }
+        spdlog::info("Copied " + std::to_string(size/1024)
+                   + " kB from " + fileName.string() + " into memory");
     }
     void openReadWrite(const std::filesystem::path &fileName)
     {
         //mURI = "file:/" + fileName.string();
         mURI = fileName.string();
         spdlog::info("Opening " + mURI + " in read-write mode");
-        auto returnCode = sqlite3_open_v2(mURI.c_str(),
-                                          &mDatabaseHandle,
-                                          SQLITE_OPEN_READWRITE |
-                                          SQLITE_OPEN_FULLMUTEX,
-                                          nullptr);
-        if (returnCode != SQLITE_OK)
-        {
-            sqlite3_close(mDatabaseHandle);
-            throw std::runtime_error(
-                "Failed to open sqlite3 read-write database "
-              + fileName.string());
-        }
+        // There is only one writer
+        mPool.open([this]()
+                   {
+                       return openConnection(SQLITE_OPEN_READWRITE);
+                   },
+                   1);
         mHaveReadOnlyDatabase = false;
         mHaveReadWriteDatabase = true;
     }
@@ -199,29 +1466,19 @@ public:
         }
         mURI = fileName.string();
         spdlog::info("Creating " + mURI + " as read-write database");
-        auto returnCode = sqlite3_open_v2(mURI.c_str(),
-                                          &mDatabaseHandle,
-                                          SQLITE_OPEN_READWRITE |
-                                          SQLITE_OPEN_CREATE |
-                                          SQLITE_OPEN_FULLMUTEX,
-                                          nullptr);
-        if (returnCode != SQLITE_OK)
-        {
-            sqlite3_close(mDatabaseHandle);
-            throw std::runtime_error(
-                "Failed to create sqlite3 read-write database "
-              + fileName.string());
-        }
+        mPool.open([this]()
+                   {
+                       return openConnection(SQLITE_OPEN_READWRITE |
+                                             SQLITE_OPEN_CREATE);
+                   },
+                   1);
         mHaveReadOnlyDatabase = false;
         mHaveReadWriteDatabase = true;
     }
-    [[nodiscard]] bool exists(const Station &station) const
+    [[nodiscard]] static bool exists(::Connection &connection,
+                                     const Station &station)
     {
         bool result{false};
-        if (!mDatabaseHandle)
-        {
-            throw std::runtime_error("database not initialized");
-        }
         // These statements throw
         auto network = station.getNetwork();
         auto name = station.getName();
@@ -229,62 +1486,44 @@ public:
         auto startTime = static_cast<sqlite3_int64> (startAndEndTime.first.count());
         auto endTime = static_cast<sqlite3_int64> (startAndEndTime.second.count());
 
-        const std::string_view sql{
-R"""(
-SELECT COUNT(*) FROM station WHERE
-  network = ?1 AND
-  name = ?2 AND
-  ((start_time >= ?3 AND ?4 <= end_time) OR (start_time >= ?5 AND ?6 <= end_time))
-)"""};
-        sqlite3_stmt *statement{nullptr};
-        auto returnCode = sqlite3_prepare_v2(mDatabaseHandle,
-                                             sql.data(),
-                                             -1,
-                                             &statement,
-                                             nullptr);
-        SQLITE_CHECK_PREPARE(returnCode, statement);
-
-        returnCode = sqlite3_bind_text(statement,
-                                       1,
-                                       network.data(),
-                                       static_cast<int> (network.size()),
-                                       SQLITE_STATIC);
-        SQLITE_CHECK_BIND(returnCode, statement);
+        auto statement = connection.statement(::Query::StationExists);
+        const ::StatementReset reset{statement};
+        auto returnCode = sqlite3_bind_text(statement,
+                                            1,
+                                            network.data(),
+                                            static_cast<int> (network.size()),
+                                            SQLITE_STATIC);
+        SQLITE_CHECK_CACHED_BIND(returnCode);
         returnCode = sqlite3_bind_text(statement,
                                        2,
                                        name.data(),
                                        static_cast<int> (name.size()),
                                        SQLITE_STATIC);
+        SQLITE_CHECK_CACHED_BIND(returnCode);
         returnCode = sqlite3_bind_int64(statement, 3, startTime);
-        SQLITE_CHECK_BIND(returnCode, statement);
+        SQLITE_CHECK_CACHED_BIND(returnCode);
         returnCode = sqlite3_bind_int64(statement, 4, startTime);
-        SQLITE_CHECK_BIND(returnCode, statement);
+        SQLITE_CHECK_CACHED_BIND(returnCode);
         returnCode = sqlite3_bind_int64(statement, 5, endTime);
-        SQLITE_CHECK_BIND(returnCode, statement);
+        SQLITE_CHECK_CACHED_BIND(returnCode);
         returnCode = sqlite3_bind_int64(statement, 6, endTime);
-        SQLITE_CHECK_BIND(returnCode, statement);
-        returnCode = sqlite3_step(statement);
+        SQLITE_CHECK_CACHED_BIND(returnCode);
+        returnCode = ::stepWithRetry(statement);
         if (returnCode == SQLITE_ROW)
         {
             auto exists = sqlite3_column_int(statement, 0);
-            if (exists >= 1){result = true;}
             result = exists == 0 ? false : true;
         }
-        returnCode = sqlite3_finalize(statement);
-        SQLITE_CHECK_FINALIZE(returnCode);
         return result;
     }
     [[nodiscard]] bool tableExists(const std::string_view &table) const
     {
         bool result{false};
-        if (!mDatabaseHandle)
-        {
-            throw std::runtime_error("database not initialized");
-        }
+        auto connection = mPool.acquire();
         sqlite3_stmt *statement{nullptr};
         const std::string_view sql{
             "SELECT COUNT(*) FROM sqlite_master WHERE type = 'table' AND name = ?1"};
-        auto returnCode = sqlite3_prepare_v2(mDatabaseHandle, 
+        auto returnCode = sqlite3_prepare_v2(connection->handle(), 
                                              sql.data(),
                                              -1,
                                              &statement,
@@ -316,8 +1555,9 @@ SELECT COUNT(*) FROM station WHERE
         {            
             throw std::runtime_error("database not initialized");
         }
+        auto connection = mPool.acquire();
         sqlite3_stmt *statement{nullptr};
-        auto returnCode = sqlite3_prepare_v2(mDatabaseHandle,
+        auto returnCode = sqlite3_prepare_v2(connection->handle(),
                                              schema.data(),
                                              -1,
                                              &statement,
@@ -350,26 +1590,7 @@ SELECT COUNT(*) FROM station WHERE
                             + " already exists; will not create");
                 return;
             }
-            const std::string_view schema{
-R"""(
-CREATE TABLE channel (
-  identifier INTEGER PRIMARY KEY AUTOINCREMENT,
-  station_identifier INTEGER,
-  name TEXT,
-  location_code TEXT DEFAULT NULL,
-  latitude DOUBLE NOT NULL CHECK( latitude >= -90 AND latitude <= 90),
-  longitude DOUBLE NOT NULL,
-  elevation DOUBLE NOT NULL CHECK( elevation >= -10000 AND elevation <= 8600 ),
-  sampling_rate DOUBLE NOT NULL CHECK ( sampling_rate > 0 ),
-  azimuth DOUBLE CHECK( azimuth >= 0 AND azimuth < 360 ),
-  dip DOUBLE CHECK( dip >= -90 AND dip <= -90 ),
-  start_time BIGINT NOT NULL,
-  end_time BIGINT DEFAULT 32503680000 CHECK (end_time > start_time),
-  last_modified DOUBLE DEFAULT CURRENT_TIMESTAMP,
-  UNIQUE(station_identifier, name, location_code, start_time),
-  FOREIGN KEY(station_identifier) REFERENCES station(identifier)
-)
-)"""};
+            const std::string_view schema{CHANNEL_TABLE_SCHEMA};
             createTable(schema);
             spdlog::info("Successfully created channel table");
         }
@@ -380,6 +1601,108 @@ CREATE TABLE channel (
             return;
         }
     }
+    /// @result The schema version recorded in the database.  Databases
+    ///         created before the schema was versioned are at version 0.
+    [[nodiscard]] int getSchemaVersion() const
+    {
+        int version{0};
+        auto connection = mPool.acquire();
+        sqlite3_stmt *statement{nullptr};
+        auto returnCode = sqlite3_prepare_v2(connection->handle(),
+                                             "PRAGMA user_version",
+                                             -1,
+                                             &statement,
+                                             nullptr);
+        SQLITE_CHECK_PREPARE(returnCode, statement);
+        if (sqlite3_step(statement) == SQLITE_ROW)
+        {
+            version = sqlite3_column_int(statement, 0);
+        }
+        returnCode = sqlite3_finalize(statement);
+        if (returnCode != SQLITE_OK)
+        {
+            spdlog::warn("Failed to finalize schema version statement");
+        }
+        return version;
+    }
+    void setSchemaVersion()
+    {
+        const std::string sql{"PRAGMA user_version = "
+                            + std::to_string(SCHEMA_VERSION)};
+        auto connection = mPool.acquire();
+        ::execute(connection->handle(), sql.c_str());
+    }
+    /// Brings a database created by an older version of this library up to
+    /// the current schema.
+    void migrateSchema()
+    {
+        const auto version = getSchemaVersion();
+        if (version > SCHEMA_VERSION)
+        {
+            spdlog::warn("Database schema version " + std::to_string(version)
+                       + " is newer than " + std::to_string(SCHEMA_VERSION));
+            return;
+        }
+        if (version == SCHEMA_VERSION){return;}
+        spdlog::info("Migrating database schema from version "
+                   + std::to_string(version) + " to "
+                   + std::to_string(SCHEMA_VERSION));
+        if (version < 1){migrateChannelTable();}
+        setSchemaVersion();
+    }
+    /// Version 0 databases lack a channel table or were created with a CHECK
+    /// that rejected every dip other than -90.  The table is rebuilt with
+    /// the current schema and its rows are copied over.  The epoch index is
+    /// dropped with it and recreated afterward.
+    void migrateChannelTable()
+    {
+        if (!tableExists(CHANNEL_TABLE))
+        {
+            createChannelTable();
+            return;
+        }
+        spdlog::info("Rebuilding channel table with corrected dip constraint");
+        const std::string sql{
+R"""(
+DROP TRIGGER IF EXISTS channel_epoch_insert;
+DROP TRIGGER IF EXISTS channel_epoch_update;
+DROP TRIGGER IF EXISTS channel_epoch_delete;
+DROP TABLE IF EXISTS channel_epoch;
+ALTER TABLE channel RENAME TO channel_version0;
+)"""
+          + std::string {CHANNEL_TABLE_SCHEMA} + ";"
+          + R"""(
+INSERT INTO channel (identifier, station_identifier, name, location_code,
+                     latitude, longitude, elevation, sampling_rate, azimuth,
+                     dip, start_time, end_time, last_modified)
+  SELECT identifier, station_identifier, name, location_code,
+         latitude, longitude, elevation, sampling_rate, azimuth,
+         dip, start_time, end_time, last_modified FROM channel_version0;
+DROP TABLE channel_version0;
+)"""};
+        auto connection = mPool.acquire();
+        ::execute(connection->handle(), "BEGIN IMMEDIATE TRANSACTION");
+        try
+        {
+            ::execute(connection->handle(), sql.c_str());
+            ::execute(connection->handle(), "COMMIT TRANSACTION");
+        }
+        catch (const std::exception &e)
+        {
+            spdlog::error("Failed to rebuild channel table because "
+                        + std::string {e.what()});
+            // A failed rollback must not replace the migration's error
+            try
+            {
+                ::execute(connection->handle(), "ROLLBACK TRANSACTION");
+            }
+            catch (const std::exception &rollbackError)
+            {
+                spdlog::error(rollbackError.what());
+            }
+            throw;
+        }
+    }
     void createStationTable()
     {
         const std::string_view stationTable{STATION_TABLE};
@@ -421,239 +1744,1014 @@ CREATE TABLE station (
         getActiveStationInformation(const std::string &network,
                                     const std::string &name) const
     {
-        if (!mDatabaseHandle)
-        {                  
-            throw std::runtime_error("database not initialized");
-        }
-        const std::string_view sql{
-R"""(
-SELECT network, name, description, latitude, longitude, elevation, start_time, end_time, last_modified FROM station WHERE
-  network = ?1 AND name = ?2 AND
-  unixepoch(CURRENT_TIMESTAMP) >= start_time AND unixepoch(CURRENT_TIMESTAMP) <= end_time LIMIT 1
-)"""};
-        sqlite3_stmt *statement{nullptr};
-        auto returnCode = sqlite3_prepare_v2(mDatabaseHandle,
-                                             sql.data(),
-                                             -1, 
-                                             &statement,
-                                             nullptr);
-        SQLITE_CHECK_PREPARE(returnCode, statement);
-        returnCode = sqlite3_bind_text(statement,
-                                       1,
-                                       network.data(),
-                                       static_cast<int> (network.size()),
-                                       SQLITE_STATIC);
-        SQLITE_CHECK_BIND(returnCode, statement);
+        const ::QuerySpan span{mTracer, "Database.getActiveStationInformation"};
+        auto connection = acquireConnection();
+        auto statement = connection->statement(::Query::ActiveStation);
+        const ::StatementReset reset{statement};
+        auto returnCode = sqlite3_bind_text(statement,
+                                            1,
+                                            network.data(),
+                                            static_cast<int> (network.size()),
+                                            SQLITE_STATIC);
+        SQLITE_CHECK_CACHED_BIND(returnCode);
         returnCode = sqlite3_bind_text(statement,
                                        2,
                                        name.data(),
                                        static_cast<int> (name.size()),
                                        SQLITE_STATIC);
-        SQLITE_CHECK_BIND(returnCode, statement);
+        SQLITE_CHECK_CACHED_BIND(returnCode);
         UMetadata::Station station;
         bool found{false};
-        returnCode = sqlite3_step(statement);
+        returnCode = ::stepWithRetry(statement);
         if (returnCode == SQLITE_ROW)
         {
             try
             {
+                const ::UnpackTimer timer;
                 station = ::unpackStationRow(statement);
                 found = true;
             }
             catch (const std::exception &e)
             {
-                spdlog::warn("Failed to unpack row for "
-                           + network + "." + name);
+                spdlog::warn("Failed to unpack row for "
+                           + network + "." + name);
+            }
+        }
+        return found ? std::optional<UMetadata::Station> {std::move(station)}
+                     : std::nullopt;
+    }
+    std::vector<UMetadata::Station>
+        getStationsActiveAt(const std::chrono::seconds &time) const
+    {
+        std::vector<UMetadata::Station> result;
+        visitStationsActiveAt(time,
+                              [&result](const UMetadata::Station &station)
+                              {
+                                  result.push_back(station);
+                              });
+        return result;
+    }
+    /// Steps through the stations active at the given time.  A single
+    /// station is reused for every row so memory does not grow with the
+    /// size of the inventory.
+    void visitStationsActiveAt(
+        const std::chrono::seconds &time,
+        const std::function<void (const UMetadata::Station &)> &visitor) const
+    {
+        UMetadata::Station station;
+        stepStationsActiveAt(time,
+                             [&](sqlite3_stmt *statement)
+                             {
+                                 bool unpacked{false};
+                                 try
+                                 {
+                                     ::unpackStationRow(statement, station);
+                                     unpacked = true;
+                                 }
+                                 catch (const std::exception &e)
+                                 {
+                                     spdlog::warn("Failed to unpack row");
+                                 }
+                                 if (unpacked){visitor(station);}
+                             });
+    }
+    /// Decodes the stations active at the given time straight into the
+    /// response.  The rows were validated on insertion so they are copied
+    /// from SQLite's buffers without passing through UMetadata::Station.
+    void appendStationsActiveAt(
+        const std::chrono::seconds &time,
+        UMetadataAPI::V1::StationsResponse *response) const
+    {
+        stepStationsActiveAt(time,
+                             [response](sqlite3_stmt *statement)
+                             {
+                                 ::unpackStationRow(statement,
+                                                    response->add_stations());
+                             });
+    }
+    /// Runs the active-at query and hands each row to the callback.
+    void stepStationsActiveAt(
+        const std::chrono::seconds &time,
+        const std::function<void (sqlite3_stmt *)> &onRow) const
+    {
+        const ::QuerySpan span{mTracer, "Database.getStationsActiveAt"};
+        auto connection = acquireConnection();
+        auto statement
+            = connection->statement(mHaveStationEpochIndex ?
+                                    ::Query::StationsActiveAt :
+                                    ::Query::StationsActiveAtScan);
+        const ::StatementReset reset{statement};
+        auto returnCode
+            = sqlite3_bind_int64(statement,
+                                 1,
+                                 static_cast<sqlite3_int64> (time.count()));
+        SQLITE_CHECK_CACHED_BIND(returnCode);
+
+        returnCode = ::stepWithRetry(statement);
+        while (returnCode == SQLITE_ROW)
+        {
+            {
+                const ::UnpackTimer timer;
+                onRow(statement);
+            }
+            returnCode = ::profiledStep(statement);
+        }
+        // A partial result must not be mistaken for the active set
+        if (returnCode != SQLITE_DONE)
+        {
+            throw std::runtime_error("Station epoch query failed with "
+                                   + std::to_string(returnCode));
+        }
+    }
+    std::vector<UMetadata::Station>
+        getStationsInBoundingBox(const double minimumLatitude,
+                                 const double maximumLatitude,
+                                 const double minimumLongitude,
+                                 const double maximumLongitude,
+                                 const std::chrono::seconds &time) const
+    {
+        std::vector<UMetadata::Station> result;
+        const ::QuerySpan span{mTracer, "Database.getStationsInBoundingBox"};
+        auto connection = acquireConnection();
+        auto statement
+            = connection->statement(mHaveStationLocationIndex ?
+                                    ::Query::StationsInBox :
+                                    ::Query::StationsInBoxScan);
+        for (const auto &[minimumLongitudeRange, maximumLongitudeRange] :
+             ::toLongitudeRanges(minimumLongitude, maximumLongitude))
+        {
+            const ::StatementReset reset{statement};
+            auto returnCode = sqlite3_bind_double(statement, 1, minimumLatitude);
+            SQLITE_CHECK_CACHED_BIND(returnCode);
+            returnCode = sqlite3_bind_double(statement, 2, maximumLatitude);
+            SQLITE_CHECK_CACHED_BIND(returnCode);
+            returnCode = sqlite3_bind_double(statement, 3, minimumLongitudeRange);
+            SQLITE_CHECK_CACHED_BIND(returnCode);
+            returnCode = sqlite3_bind_double(statement, 4, maximumLongitudeRange);
+            SQLITE_CHECK_CACHED_BIND(returnCode);
+            returnCode
+                = sqlite3_bind_int64(statement,
+                                     5,
+                                     static_cast<sqlite3_int64> (time.count()));
+            SQLITE_CHECK_CACHED_BIND(returnCode);
+            returnCode = ::stepWithRetry(statement);
+            while (returnCode == SQLITE_ROW)
+            {
+                try
+                {
+                    const ::UnpackTimer timer;
+                    result.push_back(::unpackStationRow(statement));
+                }
+                catch (const std::exception &e)
+                {
+                    spdlog::warn("Failed to unpack row");
+                }
+                returnCode = ::profiledStep(statement);
+            }
+            if (returnCode != SQLITE_DONE)
+            {
+                spdlog::warn(
+                    "Station region query did not finish with SQLITE_DONE");
+            }
+        }
+        return result;
+    }
+    std::vector<UMetadata::Station>
+        getStationsWithinRadius(const double latitude,
+                                const double longitude,
+                                const double radius,
+                                const std::chrono::seconds &time) const
+    {
+        const ::QuerySpan span{mTracer, "Database.getStationsWithinRadius"};
+        // Find the candidates in the bounding box of the circle then
+        // compute the exact distances
+        constexpr double kilometersPerDegree{6371.0*std::numbers::pi/180.0};
+        const double dLatitude = radius/kilometersPerDegree;
+        const double minimumLatitude = std::max(-90.0, latitude - dLatitude);
+        const double maximumLatitude = std::min( 90.0, latitude + dLatitude);
+        double minimumLongitude{-180};
+        double maximumLongitude{180};
+        if (minimumLatitude > -90 && maximumLatitude < 90)
+        {
+            constexpr double toRadians{std::numbers::pi/180.0};
+            const double cosLatitude
+                = std::min(std::cos(minimumLatitude*toRadians),
+                           std::cos(maximumLatitude*toRadians));
+            const double dLongitude = dLatitude/cosLatitude;
+            if (dLongitude < 180)
+            {
+                minimumLongitude = ::lonTo180(longitude - dLongitude);
+                maximumLongitude = ::lonTo180(longitude + dLongitude);
+            }
+        }
+        auto candidates = getStationsInBoundingBox(minimumLatitude,
+                                                   maximumLatitude,
+                                                   minimumLongitude,
+                                                   maximumLongitude,
+                                                   time);
+        std::vector<UMetadata::Station> result;
+        result.reserve(candidates.size());
+        for (auto &candidate : candidates)
+        {
+            if (::haversineDistance(latitude,
+                                    longitude,
+                                    candidate.getLatitude(),
+                                    candidate.getLongitude()) <= radius)
+            {
+                result.push_back(std::move(candidate));
+            }
+        }
+        return result;
+    }
+    /// Binds the station to the cached insert statement and steps it.
+    /// @result True indicates the station was inserted.
+    [[nodiscard]] static bool insertStation(sqlite3_stmt *statement,
+                                            const UMetadata::Station &station)
+    {
+        // These statements throw
+        auto network = station.getNetwork();
+        auto name = station.getName();
+        auto description = station.getDescription();
+        const double latitude = station.getLatitude();
+        const double longitude = station.getLongitude();
+        const double elevation = station.getElevation();
+        auto startAndEndTime = station.getStartAndEndTime();
+        auto startTime = static_cast<sqlite3_int64> (startAndEndTime.first.count());
+        auto endTime = static_cast<sqlite3_int64> (startAndEndTime.second.count());
+        //double lastModified = ::getNow().count()*1.e-6;
+        auto lastModified
+             = static_cast<double> (station.getLastModified().count())*1.e-6;
+
+        const ::StatementReset reset{statement};
+        auto returnCode = sqlite3_bind_text(statement,
+                                            1,
+                                            network.data(),
+                                            static_cast<int> (network.size()),
+                                            SQLITE_STATIC);
+        SQLITE_CHECK_CACHED_BIND(returnCode);
+        returnCode = sqlite3_bind_text(statement,
+                                       2,
+                                       name.data(),
+                                       static_cast<int> (name.size()),
+                                       SQLITE_STATIC);
+        SQLITE_CHECK_CACHED_BIND(returnCode);
+        returnCode = sqlite3_bind_double(statement, 3, latitude);
+        SQLITE_CHECK_CACHED_BIND(returnCode);
+        returnCode = sqlite3_bind_double(statement, 4, longitude);
+        SQLITE_CHECK_CACHED_BIND(returnCode);
+        returnCode = sqlite3_bind_double(statement, 5, elevation);
+        SQLITE_CHECK_CACHED_BIND(returnCode);
+        returnCode = sqlite3_bind_int64(statement, 6, startTime);
+        SQLITE_CHECK_CACHED_BIND(returnCode);
+        returnCode = sqlite3_bind_int64(statement, 7, endTime);
+        SQLITE_CHECK_CACHED_BIND(returnCode);
+        returnCode = sqlite3_bind_double(statement, 8, lastModified);
+        SQLITE_CHECK_CACHED_BIND(returnCode);
+        if (description)
+        {
+            returnCode = sqlite3_bind_text(statement,
+                                           9,
+                                           description->data(),
+                                           static_cast<int> (description->size()),
+                                           SQLITE_STATIC);
+            SQLITE_CHECK_CACHED_BIND(returnCode);
+        }
+        else
+        {
+            returnCode = sqlite3_bind_null(statement, 9); 
+            SQLITE_CHECK_CACHED_BIND(returnCode);
+        }
+        // Insert it
+        returnCode = ::stepWithRetry(statement);
+        if (returnCode == SQLITE_DONE)
+        {
+            spdlog::debug("Succesfully inserted " + network + "." + name
+                        + " into station table");
+            return true;
+        }
+        spdlog::warn("Failed to insert " + network + "." + name 
+                   + std::to_string(returnCode));
+        return false;
+    }
+    void insertStation(const UMetadata::Station &station)
+    {
+        if (!mHaveReadWriteDatabase)
+        {
+            throw std::runtime_error("database must be read-write");
+        }
+        auto connection = mPool.acquire();
+        if (exists(*connection, station))
+        {
+            spdlog::warn(station.getNetwork() + "." + station.getName()
+                      +  " already exists; skipping");
+            return;
+        }
+        auto statement = connection->statement(::Query::InsertStation);
+        [[maybe_unused]] auto inserted = insertStation(statement, station);
+    }
+    /// Loads the unique keys of every station in the table.
+    [[nodiscard]] static std::unordered_set<std::string>
+        getStationKeys(::Connection &connection)
+    {
+        std::unordered_set<std::string> result;
+        auto statement = connection.statement(::Query::AllStationKeys);
+        const ::StatementReset reset{statement};
+        auto returnCode = ::stepWithRetry(statement);
+        while (returnCode == SQLITE_ROW)
+        {
+            const auto network = sqlite3_column_text(statement, 0);
+            const auto name = sqlite3_column_text(statement, 1);
+            if (network != nullptr && name != nullptr)
+            {
+                result.insert(
+                    ::toStationKey(reinterpret_cast<const char *> (network),
+                                   reinterpret_cast<const char *> (name),
+                                   sqlite3_column_int64(statement, 2)));
+            }
+            returnCode = sqlite3_step(statement);
+        }
+        if (returnCode != SQLITE_DONE)
+        {
+            throw std::runtime_error("Station key query failed with "
+                                   + std::to_string(returnCode));
+        }
+        return result;
+    }
+    /// Inserts the stations in a single transaction.  Duplicates are detected
+    /// with an in-memory set of the table's unique keys.
+    void insertStations(const std::vector<UMetadata::Station> &stations)
+    {
+        if (!mHaveReadWriteDatabase)
+        {
+            throw std::runtime_error("database must be read-write");
+        }
+        if (stations.empty()){return;}
+        const auto startTime = std::chrono::steady_clock::now();
+        size_t nInserted{0};
+        size_t nSkipped{0};
+        auto connection = mPool.acquire();
+        ::execute(connection->handle(), "BEGIN IMMEDIATE TRANSACTION");
+        try
+        {
+            auto keys = getStationKeys(*connection);
+            keys.reserve(keys.size() + stations.size());
+            auto statement = connection->statement(::Query::InsertStation);
+            for (const auto &station : stations)
+            {
+                // Like upsert, a malformed station must not abort the batch
+                try
+                {
+                    ::validateStation(station);
+                }
+                catch (const std::exception &e)
+                {
+                    spdlog::warn("Skipping station "
+                               + (station.hasNetwork() ?
+                                  station.getNetwork() : std::string {"?"})
+                               + "."
+                               + (station.hasName() ?
+                                  station.getName() : std::string {"?"})
+                               + " because " + std::string {e.what()});
+                    nSkipped = nSkipped + 1;
+                    continue;
+                }
+                auto key
+                    = ::toStationKey(station.getNetwork(),
+                                     station.getName(),
+                                     station.getStartAndEndTime().first.count());
+                if (keys.contains(key))
+                {
+                    spdlog::warn(station.getNetwork() + "." + station.getName()
+                              +  " already exists; skipping");
+                    nSkipped = nSkipped + 1;
+                    continue;
+                }
+                if (insertStation(statement, station))
+                {
+                    keys.insert(std::move(key));
+                    nInserted = nInserted + 1;
+                }
+            }
+            ::execute(connection->handle(), "COMMIT TRANSACTION");
+        }
+        catch (...)
+        {
+            try
+            {
+                ::execute(connection->handle(), "ROLLBACK TRANSACTION");
+            }
+            catch (const std::exception &e)
+            {
+                spdlog::error(e.what());
+            }
+            throw;
+        }
+        const auto duration
+            = std::chrono::duration<double>
+              (std::chrono::steady_clock::now() - startTime).count();
+        const auto rowsPerSecond
+            = duration > 0 ? static_cast<double> (nInserted)/duration : 0;
+        spdlog::info("Inserted " + std::to_string(nInserted)
+                   + " stations (skipped " + std::to_string(nSkipped)
+                   + ") in " + std::to_string(duration) + " s ("
+                   + std::to_string(static_cast<int64_t> (rowsPerSecond))
+                   + " rows/s)");
+    }
+    /// Looks up the station epoch that contains the channel's start time.
+    [[nodiscard]] static std::optional<int64_t>
+        getChannelStation(::Connection &connection,
+                          const std::string &network,
+                          const std::string &station,
+                          const int64_t startTime)
+    {
+        auto statement = connection.statement(::Query::ChannelStation);
+        const ::StatementReset reset{statement};
+        auto returnCode = sqlite3_bind_text(statement,
+                                            1,
+                                            network.data(),
+                                            static_cast<int> (network.size()),
+                                            SQLITE_STATIC);
+        SQLITE_CHECK_CACHED_BIND(returnCode);
+        returnCode = sqlite3_bind_text(statement,
+                                       2,
+                                       station.data(),
+                                       static_cast<int> (station.size()),
+                                       SQLITE_STATIC);
+        SQLITE_CHECK_CACHED_BIND(returnCode);
+        returnCode = sqlite3_bind_int64(statement, 3, startTime);
+        SQLITE_CHECK_CACHED_BIND(returnCode);
+        if (::stepWithRetry(statement) == SQLITE_ROW)
+        {
+            return sqlite3_column_int64(statement, 0);
+        }
+        return std::nullopt;
+    }
+    /// Binds the channel to the cached insert statement and steps it.
+    /// @result True indicates the channel was inserted.
+    [[nodiscard]] static bool insertChannel(::Connection &connection,
+                                            const UMetadata::Channel &channel)
+    {
+        // These statements throw
+        auto network = channel.getNetwork();
+        auto station = channel.getStation();
+        auto name = channel.getName();
+        auto locationCode = channel.getLocationCode();
+        const double latitude = channel.getLatitude();
+        const double longitude = channel.getLongitude();
+        const double elevation = channel.getElevation();
+        const double samplingRate = channel.getSamplingRate();
+        const double azimuth = channel.getAzimuth();
+        const double dip = channel.getDip();
+        auto startAndEndTime = channel.getStartAndEndTime();
+        auto startTime = static_cast<sqlite3_int64> (startAndEndTime.first.count());
+        auto endTime = static_cast<sqlite3_int64> (startAndEndTime.second.count());
+        auto lastModified
+             = static_cast<double> (channel.getLastModified().count())*1.e-6;
+        const auto nslc = network + "." + station + "." + name + "."
+                        + locationCode;
+
+        auto stationIdentifier
+            = getChannelStation(connection, network, station, startTime);
+        if (!stationIdentifier)
+        {
+            spdlog::warn("No station epoch for " + nslc + "; skipping");
+            return false;
+        }
+
+        auto statement = connection.statement(::Query::InsertChannel);
+        const ::StatementReset reset{statement};
+        auto returnCode = sqlite3_bind_int64(statement, 1, *stationIdentifier);
+        SQLITE_CHECK_CACHED_BIND(returnCode);
+        returnCode = sqlite3_bind_text(statement,
+                                       2,
+                                       name.data(),
+                                       static_cast<int> (name.size()),
+                                       SQLITE_STATIC);
+        SQLITE_CHECK_CACHED_BIND(returnCode);
+        returnCode = sqlite3_bind_text(statement,
+                                       3,
+                                       locationCode.data(),
+                                       static_cast<int> (locationCode.size()),
+                                       SQLITE_STATIC);
+        SQLITE_CHECK_CACHED_BIND(returnCode);
+        returnCode = sqlite3_bind_double(statement, 4, latitude);
+        SQLITE_CHECK_CACHED_BIND(returnCode);
+        returnCode = sqlite3_bind_double(statement, 5, longitude);
+        SQLITE_CHECK_CACHED_BIND(returnCode);
+        returnCode = sqlite3_bind_double(statement, 6, elevation);
+        SQLITE_CHECK_CACHED_BIND(returnCode);
+        returnCode = sqlite3_bind_double(statement, 7, samplingRate);
+        SQLITE_CHECK_CACHED_BIND(returnCode);
+        returnCode = sqlite3_bind_double(statement, 8, azimuth);
+        SQLITE_CHECK_CACHED_BIND(returnCode);
+        returnCode = sqlite3_bind_double(statement, 9, dip);
+        SQLITE_CHECK_CACHED_BIND(returnCode);
+        returnCode = sqlite3_bind_int64(statement, 10, startTime);
+        SQLITE_CHECK_CACHED_BIND(returnCode);
+        returnCode = sqlite3_bind_int64(statement, 11, endTime);
+        SQLITE_CHECK_CACHED_BIND(returnCode);
+        returnCode = sqlite3_bind_double(statement, 12, lastModified);
+        SQLITE_CHECK_CACHED_BIND(returnCode);
+        returnCode = ::stepWithRetry(statement);
+        if (returnCode != SQLITE_DONE)
+        {
+            spdlog::warn("Failed to insert " + nslc + " "
+                       + std::to_string(returnCode));
+            return false;
+        }
+        if (sqlite3_changes(connection.handle()) == 0)
+        {
+            spdlog::warn(nslc + " already exists; skipping");
+            return false;
+        }
+        return true;
+    }
+    /// Inserts the channels in a single transaction.  Duplicates are left to
+    /// the table's unique constraint.
+    void insertChannels(const std::vector<UMetadata::Channel> &channels)
+    {
+        if (!mHaveReadWriteDatabase)
+        {
+            throw std::runtime_error("database must be read-write");
+        }
+        if (!mHaveChannelTable)
+        {
+            throw std::runtime_error("channel table does not exist");
+        }
+        if (channels.empty()){return;}
+        const auto startTime = std::chrono::steady_clock::now();
+        size_t nInserted{0};
+        auto connection = mPool.acquire();
+        ::execute(connection->handle(), "BEGIN IMMEDIATE TRANSACTION");
+        try
+        {
+            for (const auto &channel : channels)
+            {
+                if (insertChannel(*connection, channel))
+                {
+                    nInserted = nInserted + 1;
+                }
+            }
+            ::execute(connection->handle(), "COMMIT TRANSACTION");
+        }
+        catch (...)
+        {
+            try
+            {
+                ::execute(connection->handle(), "ROLLBACK TRANSACTION");
+            }
+            catch (const std::exception &e)
+            {
+                spdlog::error(e.what());
+            }
+            throw;
+        }
+        const auto duration
+            = std::chrono::duration<double>
+              (std::chrono::steady_clock::now() - startTime).count();
+        const auto rowsPerSecond
+            = duration > 0 ? static_cast<double> (nInserted)/duration : 0;
+        spdlog::info("Inserted " + std::to_string(nInserted)
+                   + " channels (skipped "
+                   + std::to_string(channels.size() - nInserted)
+                   + ") in " + std::to_string(duration) + " s ("
+                   + std::to_string(static_cast<int64_t> (rowsPerSecond))
+                   + " rows/s)");
+    }
+    std::optional<UMetadata::Channel>
+        getActiveChannelInformation(const std::string &network,
+                                    const std::string &station,
+                                    const std::string &channel,
+                                    const std::string &locationCode) const
+    {
+        if (!mHaveChannelTable){return std::nullopt;}
+        const ::QuerySpan span{mTracer, "Database.getActiveChannelInformation"};
+        auto connection = acquireConnection();
+        auto statement = connection->statement(::Query::ActiveChannel);
+        const ::StatementReset reset{statement};
+        int index{1};
+        for (const auto &value : {&network, &station, &channel, &locationCode})
+        {
+            auto returnCode = sqlite3_bind_text(statement,
+                                                index,
+                                                value->data(),
+                                                static_cast<int> (value->size()),
+                                                SQLITE_STATIC);
+            SQLITE_CHECK_CACHED_BIND(returnCode);
+            index = index + 1;
+        }
+        if (::stepWithRetry(statement) == SQLITE_ROW)
+        {
+            try
+            {
+                const ::UnpackTimer timer;
+                return ::unpackChannelRow(statement);
+            }
+            catch (const std::exception &e)
+            {
+                spdlog::warn("Failed to unpack row for "
+                           + network + "." + station + "." + channel + "."
+                           + locationCode);
+            }
+        }
+        return std::nullopt;
+    }
+    std::vector<UMetadata::Channel>
+        getChannelsActiveAt(const std::chrono::seconds &time) const
+    {
+        std::vector<UMetadata::Channel> result;
+        stepChannelsActiveAt(time,
+                             [&result](sqlite3_stmt *statement)
+                             {
+                                 try
+                                 {
+                                     result.push_back(
+                                         ::unpackChannelRow(statement));
+                                 }
+                                 catch (const std::exception &e)
+                                 {
+                                     spdlog::warn("Failed to unpack row");
+                                 }
+                             });
+        return result;
+    }
+    void appendChannelsActiveAt(
+        const std::chrono::seconds &time,
+        UMetadataAPI::V1::ChannelsResponse *response) const
+    {
+        stepChannelsActiveAt(time,
+                             [response](sqlite3_stmt *statement)
+                             {
+                                 ::unpackChannelRow(statement,
+                                                    response->add_channels());
+                             });
+    }
+    /// Runs the channel active-at query and hands each row to the callback.
+    void stepChannelsActiveAt(
+        const std::chrono::seconds &time,
+        const std::function<void (sqlite3_stmt *)> &onRow) const
+    {
+        if (!mHaveChannelTable){return;}
+        const ::QuerySpan span{mTracer, "Database.getChannelsActiveAt"};
+        auto connection = acquireConnection();
+        auto statement
+            = connection->statement(mHaveChannelEpochIndex ?
+                                    ::Query::ChannelsActiveAt :
+                                    ::Query::ChannelsActiveAtScan);
+        const ::StatementReset reset{statement};
+        auto returnCode
+            = sqlite3_bind_int64(statement,
+                                 1,
+                                 static_cast<sqlite3_int64> (time.count()));
+        SQLITE_CHECK_CACHED_BIND(returnCode);
+
+        returnCode = ::stepWithRetry(statement);
+        while (returnCode == SQLITE_ROW)
+        {
+            {
+                const ::UnpackTimer timer;
+                onRow(statement);
+            }
+            returnCode = ::profiledStep(statement);
+        }
+        // A partial result must not be mistaken for the active set
+        if (returnCode != SQLITE_DONE)
+        {
+            throw std::runtime_error("Channel epoch query failed with "
+                                   + std::to_string(returnCode));
+        }
+    }
+    /// The data version changes whenever another connection commits to the
+    /// database.  It is only comparable between calls on the same connection
+    /// so a dedicated connection, which never writes, is used.
+    [[nodiscard]] int64_t getDataVersion() const
+    {
+        const std::lock_guard<std::mutex> lock(mMonitorMutex);
+        if (!mMonitor)
+        {
+            mMonitor
+                = std::make_unique<::Connection>
+                  (openConnection(mHaveReadWriteDatabase ?
+                                  SQLITE_OPEN_READWRITE :
+                                  SQLITE_OPEN_READONLY));
+        }
+        auto statement = mMonitor->statement(::Query::DataVersion);
+        const ::StatementReset reset{statement};
+        if (::stepWithRetry(statement) != SQLITE_ROW)
+        {
+            throw std::runtime_error("Failed to query data version");
+        }
+        return sqlite3_column_int64(statement, 0);
+    }
+    /// Station and channel epochs both change what is active.
+    [[nodiscard]] std::optional<std::chrono::seconds>
+        getNextEpochBoundary(const std::chrono::seconds &time) const
+    {
+        const ::QuerySpan span{mTracer, "Database.getNextEpochBoundary"};
+        auto connection = acquireConnection();
+        auto result
+            = getNextEpochBoundary(*connection,
+                                   ::Query::NextStationEpochBoundary,
+                                   time);
+        if (mHaveChannelTable)
+        {
+            auto channelBoundary
+                = getNextEpochBoundary(*connection,
+                                       ::Query::NextChannelEpochBoundary,
+                                       time);
+            if (channelBoundary && (!result || *channelBoundary < *result))
+            {
+                result = channelBoundary;
             }
         }
-        returnCode = sqlite3_finalize(statement);
-        SQLITE_CHECK_FINALIZE(returnCode);
-        return found ? std::optional<UMetadata::Station> {std::move(station)}
-                     : std::nullopt;
+        return result;
     }
-    std::vector<UMetadata::Station> getAllActiveStations() const
+    [[nodiscard]] static std::optional<std::chrono::seconds>
+        getNextEpochBoundary(::Connection &connection,
+                             const ::Query query,
+                             const std::chrono::seconds &time)
     {
-        if (!mDatabaseHandle)
-        {              
-            throw std::runtime_error("database not initialized");
+        auto statement = connection.statement(query);
+        const ::StatementReset reset{statement};
+        auto returnCode
+            = sqlite3_bind_int64(statement,
+                                 1,
+                                 static_cast<sqlite3_int64> (time.count()));
+        SQLITE_CHECK_CACHED_BIND(returnCode);
+        returnCode = ::stepWithRetry(statement);
+        if (returnCode != SQLITE_ROW)
+        {
+            throw std::runtime_error("Epoch boundary query failed with "
+                                   + std::to_string(returnCode));
         }
-        const std::string_view sql{
-R"""(
-SELECT network, name, description, latitude, longitude, elevation, start_time, end_time, last_modified FROM station WHERE
-  unixepoch(CURRENT_TIMESTAMP) >= start_time AND unixepoch(CURRENT_TIMESTAMP) <= end_time
-)"""};
-        sqlite3_stmt *statement{nullptr};
-        auto returnCode = sqlite3_prepare_v2(mDatabaseHandle,
-                                             sql.data(),
-                                             -1,
-                                             &statement,
-                                             nullptr);
-        SQLITE_CHECK_PREPARE(returnCode, statement);
-
-        std::vector<UMetadata::Station> result;
-        result.reserve(1024);
-        returnCode = SQLITE_ROW;
-        while (returnCode == SQLITE_ROW)
+        if (sqlite3_column_type(statement, 0) == SQLITE_NULL)
         {
-            returnCode = sqlite3_step(statement);
-            if (returnCode == SQLITE_ROW)
+            return std::nullopt;
+        }
+        return std::chrono::seconds {sqlite3_column_int64(statement, 0)};
+    }
+    /// Merges the sorted incoming stations against the table in key order.
+    /// @result The stations that must be inserted or updated.
+    [[nodiscard]] static std::vector<const UMetadata::Station *>
+        diffStations(::Connection &connection,
+                     const std::vector<IncomingStation> &incoming,
+                     Database::UpsertSummary &summary)
+    {
+        std::vector<const UMetadata::Station *> delta;
+        auto statement = connection.statement(::Query::AllStationsByKey);
+        const ::StatementReset reset{statement};
+        UMetadata::Station current;
+        auto returnCode = ::stepWithRetry(statement);
+        auto next = incoming.cbegin();
+        while (next != incoming.cend())
+        {
+            if (returnCode != SQLITE_ROW)
             {
-                try
+                // Table is exhausted so the rest are new
+                for (; next != incoming.cend(); ++next)
+                {
+                    delta.push_back(next->station);
+                    summary.inserted = summary.inserted + 1;
+                }
+                break;
+            }
+            ::unpackStationRow(statement, current);
+            const IncomingStation row{current.getNetwork(),
+                                      current.getName(),
+                                      current.getStartAndEndTime().first.count(),
+                                      &current};
+            if (row.key() < next->key())
+            {
+                returnCode = sqlite3_step(statement);
+                continue;
+            }
+            if (next->key() < row.key())
+            {
+                delta.push_back(next->station);
+                summary.inserted = summary.inserted + 1;
+                ++next;
+                continue;
+            }
+            // Same epoch - update only if it is newer and differs
+            const auto &station = *next->station;
+            if (station.getLastModified() > current.getLastModified() &&
+                ::hasChanged(current, station))
+            {
+                delta.push_back(next->station);
+                if (::isClosure(current, station))
                 {
-                    result.push_back(std::move(::unpackStationRow(statement)));
+                    summary.closed = summary.closed + 1;
                 }
-                catch (const std::exception &e) 
+                else
                 {
-                    spdlog::warn("Failed to unpack row");
+                    summary.changed = summary.changed + 1;
                 }
             }
             else
             {
-                if (returnCode != SQLITE_DONE)
-                {
-                    spdlog::warn(
-                       "Current station query did not finish with SQLITE_DONE");
-                }
+                summary.unchanged = summary.unchanged + 1;
             }
+            ++next;
+            returnCode = sqlite3_step(statement);
         }
-        returnCode = sqlite3_finalize(statement);
-        SQLITE_CHECK_FINALIZE(returnCode);
-        return result;
+        if (returnCode != SQLITE_ROW && returnCode != SQLITE_DONE)
+        {
+            throw std::runtime_error("Station diff query failed with "
+                                   + std::to_string(returnCode));
+        }
+        return delta;
     }
-    void insertStation(const UMetadata::Station &station)
+    /// Reconciles the stations with the table.  The incoming stations are
+    /// sorted on the table's unique key and merged against the table in key
+    /// order to find the new and modified epochs.  Only that delta is then
+    /// written.
+    Database::UpsertSummary
+        upsertStations(const std::vector<UMetadata::Station> &stations)
     {
-        if (!mDatabaseHandle)
-        {          
-            throw std::runtime_error("database not initialized");
-        }   
         if (!mHaveReadWriteDatabase)
         {
             throw std::runtime_error("database must be read-write");
         }
-        if (exists(station))
-        {
-            spdlog::warn(station.getNetwork() + "." + station.getName()
-                      +  " already exists; skipping");
-            return;
-        }
-        // These statements throw
-        auto network = station.getNetwork();
-        auto name = station.getName();
-        auto description = station.getDescription();
-        const double latitude = station.getLatitude();
-        const double longitude = station.getLongitude();
-        const double elevation = station.getElevation();
-        auto startAndEndTime = station.getStartAndEndTime();
-        auto startTime = static_cast<sqlite3_int64> (startAndEndTime.first.count());
-        auto endTime = static_cast<sqlite3_int64> (startAndEndTime.second.count());
-        //double lastModified = ::getNow().count()*1.e-6;
-        auto lastModified
-             = static_cast<double> (station.getLastModified().count())*1.e-6;
-
-        const std::string_view sql{
-R"""(
-INSERT INTO station (network, name, latitude, longitude, elevation, start_time, end_time, last_modified, description)
-  VALUES (?1, ?2, ?3, ?4, ?5, ?6, ?7, ?8, ?9)
-)"""
-};
-        sqlite3_stmt *statement{nullptr};
-        auto returnCode = sqlite3_prepare_v2(mDatabaseHandle,
-                                             sql.data(),
-                                             -1,
-                                             &statement,
-                                             nullptr);
-        SQLITE_CHECK_PREPARE(returnCode, statement);
-        returnCode = sqlite3_bind_text(statement,
-                                       1,
-                                       network.data(),
-                                       static_cast<int> (network.size()),
-                                       SQLITE_STATIC);
-        SQLITE_CHECK_BIND(returnCode, statement);
-        returnCode = sqlite3_bind_text(statement,
-                                       2,
-                                       name.data(),
-                                       static_cast<int> (name.size()),
-                                       SQLITE_STATIC);
-        SQLITE_CHECK_BIND(returnCode, statement);
-        returnCode = sqlite3_bind_double(statement, 3, latitude);
-        SQLITE_CHECK_BIND(returnCode, statement);
-        returnCode = sqlite3_bind_double(statement, 4, longitude);
-        SQLITE_CHECK_BIND(returnCode, statement);
-        returnCode = sqlite3_bind_double(statement, 5, elevation);
-        SQLITE_CHECK_BIND(returnCode, statement); 
-        returnCode = sqlite3_bind_int64(statement, 6, startTime);
-        SQLITE_CHECK_BIND(returnCode, statement);
-        returnCode = sqlite3_bind_int64(statement, 7, endTime);
-        SQLITE_CHECK_BIND(returnCode, statement);
-        returnCode = sqlite3_bind_double(statement, 8, lastModified);
-        SQLITE_CHECK_BIND(returnCode, statement);
-        if (description)
+        Database::UpsertSummary summary;
+        if (stations.empty()){return summary;}
+        const auto startTime = std::chrono::steady_clock::now();
+        // Order the stations on (network, name, start time).  When the same
+        // epoch appears more than once the most recently modified one wins.
+        // Malformed stations are dropped here, before the transaction, so
+        // that one bad row does not abort the reconciliation
+        std::vector<IncomingStation> incoming;
+        incoming.reserve(stations.size());
+        for (const auto &station : stations)
         {
-            returnCode = sqlite3_bind_text(statement,
-                                           9,
-                                           description->data(),
-                                           static_cast<int> (description->size()),
-                                           SQLITE_STATIC);
-            SQLITE_CHECK_BIND(returnCode, statement);
+            try
+            {
+                ::validateStation(station);
+            }
+            catch (const std::exception &e)
+            {
+                spdlog::warn("Skipping station "
+                           + (station.hasNetwork() ?
+                              station.getNetwork() : std::string {"?"})
+                           + "."
+                           + (station.hasName() ?
+                              station.getName() : std::string {"?"})
+                           + " because " + std::string {e.what()});
+                summary.skipped = summary.skipped + 1;
+                continue;
+            }
+            incoming.push_back(
+                IncomingStation {station.getNetwork(),
+                                 station.getName(),
+                                 station.getStartAndEndTime().first.count(),
+                                 &station});
         }
-        else
+        std::sort(incoming.begin(), incoming.end(),
+                  [](const IncomingStation &lhs, const IncomingStation &rhs)
+                  {
+                      if (lhs.key() != rhs.key()){return lhs.key() < rhs.key();}
+                      return lhs.station->getLastModified() >
+                             rhs.station->getLastModified();
+                  });
+        incoming.erase(std::unique(incoming.begin(), incoming.end(),
+                                   [](const IncomingStation &lhs,
+                                      const IncomingStation &rhs)
+                                   {
+                                       return lhs.key() == rhs.key();
+                                   }),
+                       incoming.end());
+        auto connection = mPool.acquire();
+        ::execute(connection->handle(), "BEGIN IMMEDIATE TRANSACTION");
+        try
         {
-            returnCode = sqlite3_bind_null(statement, 9); 
-            SQLITE_CHECK_BIND(returnCode, statement);
+            auto delta = diffStations(*connection, incoming, summary);
+            // Apply the delta
+            auto statement = connection->statement(::Query::UpsertStation);
+            for (const auto &station : delta)
+            {
+                if (!insertStation(statement, *station))
+                {
+                    throw std::runtime_error("Failed to upsert "
+                                           + station->getNetwork() + "."
+                                           + station->getName());
+                }
+            }
+            ::execute(connection->handle(), "COMMIT TRANSACTION");
         }
-        // Insert it
-        returnCode = sqlite3_step(statement);
-        if (returnCode == SQLITE_DONE)
+        catch (...)
         {
-            spdlog::debug("Succesfully inserted " + network + "." + name
-                        + " into station table");
+            try
+            {
+                ::execute(connection->handle(), "ROLLBACK TRANSACTION");
+            }
+            catch (const std::exception &e)
+            {
+                spdlog::error(e.what());
+            }
+            throw;
         }
-        else
+        const auto duration
+            = std::chrono::duration<double>
+              (std::chrono::steady_clock::now() - startTime).count();
+        spdlog::info("Upserted stations: " + std::to_string(summary.inserted)
+                   + " inserted, " + std::to_string(summary.changed)
+                   + " changed, " + std::to_string(summary.closed)
+                   + " closed, " + std::to_string(summary.unchanged)
+                   + " unchanged, " + std::to_string(summary.skipped)
+                   + " skipped in " + std::to_string(duration) + " s");
+        return summary;
+    }
+    /// Queues work on the asynchronous query threads, starting them with
+    /// their own connections if this is the first asynchronous query.
+    void submit(std::function<void ()> &&work) const
+    {
+        const std::lock_guard<std::mutex> lock(mAsyncMutex);
+        if (mAsyncClosed || !mPool.isOpen())
         {
-            spdlog::warn("Failed to insert " + network + "." + name 
-                       + std::to_string(returnCode));
+            throw std::runtime_error("Database is not open");
         }
-        returnCode = sqlite3_finalize(statement);
-        if (returnCode != SQLITE_OK)
+        if (!mAsyncExecutor)
         {
-            spdlog::warn("Failed to finalize insert station table stmt");
+            mAsyncExecutor
+                = std::make_unique<::AsyncQueryExecutor>
+                  (this,
+                   [this]()
+                   {
+                       return openConnection(SQLITE_OPEN_READONLY);
+                   },
+                   mOptions.getAsyncQueryThreads());
         }
+        mAsyncExecutor->submit(std::move(work));
     }
     void close()
     {
-        auto returnCode = SQLITE_OK;
+        // Queued asynchronous queries still need the database.  Coroutines
+        // resumed while they drain cannot start new queries, otherwise a
+        // new executor would outlive the close.
+        std::unique_ptr<::AsyncQueryExecutor> asyncExecutor{nullptr};
+        {
+            const std::lock_guard<std::mutex> lock(mAsyncMutex);
+            mAsyncClosed = true;
+            asyncExecutor = std::move(mAsyncExecutor);
+        }
+        asyncExecutor.reset();
         if (mHaveReadOnlyDatabase)
         {
             spdlog::info("Closing read-only database " + mURI);
-            returnCode = sqlite3_close(mDatabaseHandle);
-            if (returnCode != SQLITE_OK)
-            {
-                spdlog::warn("Failed to close read-only sqlite3 database "
-                           + mURI);
-            }
             mHaveReadOnlyDatabase = false;
         }
         if (mHaveReadWriteDatabase)
         {
             spdlog::info("Closing read-write database " + mURI);
-            returnCode = sqlite3_close(mDatabaseHandle);
-            if (returnCode != SQLITE_OK)
-            {
-                spdlog::warn("Failed to close read-write sqlite3 database " 
-                           + mURI);
-            }
             mHaveReadWriteDatabase = false;
         }
+        {
+            const std::lock_guard<std::mutex> lock(mMonitorMutex);
+            mMonitor.reset();
+        }
+        mPool.close();
+        // The in-memory database is freed when its last connection closes
+        if (mInMemoryHandle)
+        {
+            sqlite3_close(mInMemoryHandle);
+            mInMemoryHandle = nullptr;
+        }
     }
     ~DatabaseImpl()
     {
         close();
     }
+    /// Leases a connection.  The wait for an idle connection is traced
+    /// since it is where concurrent queries queue.
+    [[nodiscard]] ::ConnectionPool::Lease acquireConnection() const
+    {
+#ifdef WITH_TRACING
+        auto span = mTracer->StartSpan("ConnectionPool.acquire");
+#endif
+        // The asynchronous query threads have connections of their own
+        auto pool = ::AsyncQueryExecutor::getThreadPool(this);
+        auto lease = pool ? pool->acquire() : mPool.acquire();
+#ifdef WITH_TRACING
+        span->End();
+#endif
+        return lease;
+    }
 //private:
-    mutable sqlite3 *mDatabaseHandle{nullptr};
+    mutable ::ConnectionPool mPool;
+    mutable std::mutex mMonitorMutex;
+    mutable std::unique_ptr<::Connection> mMonitor{nullptr};
+    mutable std::mutex mAsyncMutex;
+    mutable std::unique_ptr<::AsyncQueryExecutor> mAsyncExecutor{nullptr};
+    bool mAsyncClosed{false};
+    DatabaseOptions mOptions;
     std::string mURI;
+    sqlite3 *mInMemoryHandle{nullptr};
     bool mHaveReadOnlyDatabase{false};
     bool mHaveReadWriteDatabase{false};
+    bool mHaveStationEpochIndex{false};
+    bool mHaveStationLocationIndex{false};
+    bool mHaveChannelTable{false};
+    bool mHaveChannelEpochIndex{false};
+    ::TracerHandle mTracer{::getLibraryTracer("uMetadataDatabase")};
 };
 
 /// Constructor
@@ -667,16 +2765,21 @@ Database::Database() :
 /// Constructor
 Database::Database(const std::filesystem::path &fileName,
                    const bool readOnly) :
-    pImpl(std::make_unique<DatabaseImpl> (fileName, readOnly))
+    Database(fileName, readOnly, DatabaseOptions {})
+{
+}
+
+/// Constructor with options
+Database::Database(const std::filesystem::path &fileName,
+                   const bool readOnly,
+                   const DatabaseOptions &options) :
+    pImpl(std::make_unique<DatabaseImpl> (fileName, readOnly, options))
 {
 }
 
 void Database::insert(const std::vector<Station> &stations)
 {
-    for (const auto &station : stations)
-    {
-        insert(station);
-    }
+    pImpl->insertStations(stations);
 }
 
 void Database::insert(const Station &station)
@@ -687,7 +2790,200 @@ void Database::insert(const Station &station)
 
 std::vector<UMetadata::Station> Database::getAllActiveStations() const
 {
-    return pImpl->getAllActiveStations();
+    auto now = std::chrono::duration_cast<std::chrono::seconds>
+               (std::chrono::system_clock::now().time_since_epoch());
+    return pImpl->getStationsActiveAt(now);
+}
+
+void Database::forEachActiveStation(
+    const std::function<void (const Station &)> &visitor) const
+{
+    auto now = std::chrono::duration_cast<std::chrono::seconds>
+               (std::chrono::system_clock::now().time_since_epoch());
+    forEachStationActiveAt(now, visitor);
+}
+
+void Database::forEachStationActiveAt(
+    const std::chrono::seconds &time,
+    const std::function<void (const Station &)> &visitor) const
+{
+    if (!visitor){throw std::invalid_argument("Visitor is not callable");}
+    pImpl->visitStationsActiveAt(time, visitor);
+}
+
+void Database::appendActiveStations(
+    UMetadataAPI::V1::StationsResponse *response) const
+{
+    auto now = std::chrono::duration_cast<std::chrono::seconds>
+               (std::chrono::system_clock::now().time_since_epoch());
+    appendStationsActiveAt(now, response);
+}
+
+void Database::appendStationsActiveAt(
+    const std::chrono::seconds &time,
+    UMetadataAPI::V1::StationsResponse *response) const
+{
+    if (response == nullptr)
+    {
+        throw std::invalid_argument("Response is NULL");
+    }
+    pImpl->appendStationsActiveAt(time, response);
+}
+
+/// Inserts channels
+void Database::insert(const std::vector<UMetadata::Channel> &channels)
+{
+    pImpl->insertChannels(channels);
+}
+
+void Database::insert(const UMetadata::Channel &channel)
+{
+    pImpl->insertChannels(std::vector<UMetadata::Channel> {channel});
+}
+
+std::optional<UMetadata::Channel> Database::getActiveChannelInformation(
+    const std::string &networkIn,
+    const std::string &stationIn,
+    const std::string &channelIn,
+    const std::string &locationCodeIn) const
+{
+    auto network = ::transformString(networkIn);
+    auto station = ::transformString(stationIn);
+    auto channel = ::transformString(channelIn);
+    auto locationCode = ::transformString(locationCodeIn);
+    if (network.empty()){throw std::invalid_argument("Network is empty");}
+    if (station.empty()){throw std::invalid_argument("Station is empty");}
+    if (channel.empty()){throw std::invalid_argument("Channel is empty");}
+    // Channels without a location code are stored with --
+    if (locationCode.empty()){locationCode = "--";}
+    return pImpl->getActiveChannelInformation(network,
+                                              station,
+                                              channel,
+                                              locationCode);
+}
+
+std::vector<UMetadata::Channel> Database::getAllActiveChannels() const
+{
+    auto now = std::chrono::duration_cast<std::chrono::seconds>
+               (std::chrono::system_clock::now().time_since_epoch());
+    return pImpl->getChannelsActiveAt(now);
+}
+
+std::vector<UMetadata::Channel> Database::getChannelsActiveAt(
+    const std::chrono::seconds &time) const
+{
+    return pImpl->getChannelsActiveAt(time);
+}
+
+void Database::appendActiveChannels(
+    UMetadataAPI::V1::ChannelsResponse *response) const
+{
+    auto now = std::chrono::duration_cast<std::chrono::seconds>
+               (std::chrono::system_clock::now().time_since_epoch());
+    appendChannelsActiveAt(now, response);
+}
+
+void Database::appendChannelsActiveAt(
+    const std::chrono::seconds &time,
+    UMetadataAPI::V1::ChannelsResponse *response) const
+{
+    if (response == nullptr)
+    {
+        throw std::invalid_argument("Response is NULL");
+    }
+    pImpl->appendChannelsActiveAt(time, response);
+}
+
+/// Toggles query profiling
+void Database::setQueryProfiling(const bool enabled) noexcept
+{
+    ::queryProfiling.store(enabled, std::memory_order_relaxed);
+}
+
+bool Database::isQueryProfiling() noexcept
+{
+    return ::queryProfiling.load(std::memory_order_relaxed);
+}
+
+/// Takes the thread's query profile
+Database::QueryProfile Database::takeQueryProfile() noexcept
+{
+    auto result = threadQueryProfile;
+    threadQueryProfile = QueryProfile {};
+    return result;
+}
+
+int64_t Database::getDataVersion() const
+{
+    return pImpl->getDataVersion();
+}
+
+std::optional<std::chrono::seconds> Database::getNextEpochBoundary(
+    const std::chrono::seconds &time) const
+{
+    return pImpl->getNextEpochBoundary(time);
+}
+
+Database::UpsertSummary Database::upsert(
+    const std::vector<UMetadata::Station> &stations)
+{
+    return pImpl->upsertStations(stations);
+}
+
+std::vector<UMetadata::Station> Database::getStationsActiveAt(
+    const std::chrono::seconds &time) const
+{
+    return pImpl->getStationsActiveAt(time);
+}
+
+std::vector<UMetadata::Station> Database::getActiveStationsInBoundingBox(
+    const double minimumLatitude, const double maximumLatitude,
+    const double minimumLongitude, const double maximumLongitude) const
+{
+    if (minimumLatitude < -90 || maximumLatitude > 90)
+    {
+        throw std::invalid_argument("Latitudes must be in range [-90,90]");
+    }
+    if (minimumLatitude > maximumLatitude)
+    {
+        throw std::invalid_argument(
+           "Minimum latitude cannot exceed maximum latitude");
+    }
+    auto now = std::chrono::duration_cast<std::chrono::seconds>
+               (std::chrono::system_clock::now().time_since_epoch());
+    // Full circle
+    if (maximumLongitude - minimumLongitude >= 360)
+    {
+        return pImpl->getStationsInBoundingBox(minimumLatitude,
+                                               maximumLatitude,
+                                               -180,
+                                               180,
+                                               now);
+    }
+    return pImpl->getStationsInBoundingBox(minimumLatitude,
+                                           maximumLatitude,
+                                           ::lonTo180(minimumLongitude),
+                                           ::lonTo180(maximumLongitude),
+                                           now);
+}
+
+std::vector<UMetadata::Station> Database::getActiveStationsWithinRadius(
+    const double latitude, const double longitude, const double radius) const
+{
+    if (latitude < -90 || latitude > 90)
+    {
+        throw std::invalid_argument("Latitude must be in range [-90,90]");
+    }
+    if (radius < 0)
+    {
+        throw std::invalid_argument("Radius must be non-negative");
+    }
+    auto now = std::chrono::duration_cast<std::chrono::seconds>
+               (std::chrono::system_clock::now().time_since_epoch());
+    return pImpl->getStationsWithinRadius(latitude,
+                                          ::lonTo180(longitude),
+                                          radius,
+                                          now);
 }
 
 std::optional<UMetadata::Station> Database::getActiveStationInformation(
@@ -700,6 +2996,87 @@ std::optional<UMetadata::Station> Database::getActiveStationInformation(
     return pImpl->getActiveStationInformation(network, name);
 }
 
+/// Asynchronous queries
+Database::Awaitable<std::vector<UMetadata::Station>>
+    Database::getAllActiveStationsAsync() const
+{
+    return {this, [this]() {return getAllActiveStations();}};
+}
+
+Database::Awaitable<std::vector<UMetadata::Station>>
+    Database::getStationsActiveAtAsync(const std::chrono::seconds &time) const
+{
+    return {this, [this, time]() {return getStationsActiveAt(time);}};
+}
+
+Database::Awaitable<std::optional<UMetadata::Station>>
+    Database::getActiveStationInformationAsync(const std::string &network,
+                                               const std::string &name) const
+{
+    return {this,
+            [this, network, name]()
+            {
+                return getActiveStationInformation(network, name);
+            }};
+}
+
+Database::Awaitable<std::vector<UMetadata::Station>>
+    Database::getActiveStationsInBoundingBoxAsync(
+        const double minimumLatitude, const double maximumLatitude,
+        const double minimumLongitude, const double maximumLongitude) const
+{
+    return {this,
+            [=, this]()
+            {
+                return getActiveStationsInBoundingBox(minimumLatitude,
+                                                      maximumLatitude,
+                                                      minimumLongitude,
+                                                      maximumLongitude);
+            }};
+}
+
+Database::Awaitable<std::vector<UMetadata::Station>>
+    Database::getActiveStationsWithinRadiusAsync(
+        const double latitude, const double longitude,
+        const double radius) const
+{
+    return {this,
+            [=, this]()
+            {
+                return getActiveStationsWithinRadius(latitude,
+                                                     longitude,
+                                                     radius);
+            }};
+}
+
+Database::Awaitable<std::vector<UMetadata::Channel>>
+    Database::getAllActiveChannelsAsync() const
+{
+    return {this, [this]() {return getAllActiveChannels();}};
+}
+
+Database::Awaitable<std::optional<UMetadata::Channel>>
+    Database::getActiveChannelInformationAsync(
+        const std::string &network,
+        const std::string &station,
+        const std::string &channel,
+        const std::string &locationCode) const
+{
+    return {this,
+            [=, this]()
+            {
+                return getActiveChannelInformation(network,
+                                                   station,
+                                                   channel,
+                                                   locationCode);
+            }};
+}
+
+void Database::submit(std::function<void ()> &&work) const
+{
+    pImpl->submit(std::move(work));
+}
+
 /// Destructor
 Database::~Database() = default;
 
@@ -0,0 +1,225 @@
+#ifndef DATABASE_EXECUTOR_HPP
+#define DATABASE_EXECUTOR_HPP
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <grpcpp/support/status.h>
+#include <spdlog/spdlog.h>
+namespace
+{
+
+/// @brief The cost of an RPC.  Point lookups are cheap and latency
+///        sensitive so they are served ahead of full-inventory dumps.
+enum class RequestClass
+{
+    Lookup,
+    Inventory
+};
+
+/// @brief Runs blocking database work off of gRPC's callback threads so
+///        that a slow query cannot stall unrelated calls.  The queue is
+///        bounded so that, when the database falls behind, new work is
+///        turned away rather than queued without limit.  Lookups are run
+///        before inventories and, when there is more than one worker,
+///        inventories never occupy every worker.
+class DatabaseExecutor
+{
+public:
+    /// @param[in] nThreads           The number of worker threads.
+    /// @param[in] maximumQueueDepth  The most work that can await a worker.
+    /// @throws std::invalid_argument if either is not positive.
+    DatabaseExecutor(const int nThreads, const size_t maximumQueueDepth) :
+        mMaximumQueueDepth(maximumQueueDepth),
+        mMaximumRunningInventories(std::max(1, nThreads - 1))
+    {
+        if (nThreads < 1)
+        {
+            throw std::invalid_argument("Number of threads must be positive");
+        }
+        if (maximumQueueDepth < 1)
+        {
+            throw std::invalid_argument("Maximum queue depth must be positive");
+        }
+        mThreads.reserve(static_cast<size_t> (nThreads));
+        for (int i = 0; i < nThreads; ++i)
+        {
+            mThreads.emplace_back(&DatabaseExecutor::run, this);
+        }
+        spdlog::info("Running database work on "
+                   + std::to_string(nThreads) + " threads with at most "
+                   + std::to_string(maximumQueueDepth) + " queued");
+    }
+    /// Work that is already queued is run before the workers exit.
+    ~DatabaseExecutor()
+    {
+        {
+            const std::lock_guard<std::mutex> lock(mMutex);
+            mKeepRunning = false;
+        }
+        mConditionVariable.notify_all();
+        for (auto &thread : mThreads)
+        {
+            if (thread.joinable()){thread.join();}
+        }
+    }
+    DatabaseExecutor(const DatabaseExecutor &) = delete;
+    DatabaseExecutor& operator=(const DatabaseExecutor &) = delete;
+    /// @brief Queues the work.
+    /// @param[in] requestClass  Determines the order in which work is run.
+    /// @result False if the queue is full in which case the work was not
+    ///         queued.
+    [[nodiscard]] bool submit(std::function<void ()> work,
+                              const ::RequestClass requestClass)
+    {
+        {
+            const std::lock_guard<std::mutex> lock(mMutex);
+            if (mLookups.size() + mInventories.size() >= mMaximumQueueDepth)
+            {
+                return false;
+            }
+            if (requestClass == ::RequestClass::Lookup)
+            {
+                mLookups.push_back(std::move(work));
+            }
+            else
+            {
+                mInventories.push_back(std::move(work));
+            }
+        }
+        mConditionVariable.notify_one();
+        return true;
+    }
+private:
+    /// @note The mutex must be held.
+    [[nodiscard]] bool canRunInventory() const noexcept
+    {
+        return !mInventories.empty() &&
+               mRunningInventories < mMaximumRunningInventories;
+    }
+    void run()
+    {
+        while (true)
+        {
+            std::function<void ()> work;
+            bool isInventory{false};
+            {
+                std::unique_lock<std::mutex> lock(mMutex);
+                mConditionVariable.wait(lock, [this]()
+                                        {
+                                            return !mKeepRunning ||
+                                                   !mLookups.empty() ||
+                                                   canRunInventory();
+                                        });
+                if (!mLookups.empty())
+                {
+                    work = std::move(mLookups.front());
+                    mLookups.pop_front();
+                }
+                else if (!mInventories.empty())
+                {
+                    // When shutting down the reserved worker may drain these
+                    work = std::move(mInventories.front());
+                    mInventories.pop_front();
+                    isInventory = true;
+                    ++mRunningInventories;
+                }
+                else
+                {
+                    return;
+                }
+            }
+            try
+            {
+                work();
+            }
+            catch (const std::exception &e)
+            {
+                spdlog::error("Database work failed because "
+                            + std::string {e.what()});
+            }
+            if (isInventory)
+            {
+                {
+                    const std::lock_guard<std::mutex> lock(mMutex);
+                    --mRunningInventories;
+                }
+                // A worker may be waiting for an inventory slot
+                mConditionVariable.notify_one();
+            }
+        }
+    }
+    std::mutex mMutex;
+    std::condition_variable mConditionVariable;
+    std::deque<std::function<void ()>> mLookups;
+    std::deque<std::function<void ()>> mInventories;
+    std::vector<std::thread> mThreads;
+    size_t mMaximumQueueDepth{0};
+    int mMaximumRunningInventories{1};
+    int mRunningInventories{0};
+    bool mKeepRunning{true};
+};
+
+/// @brief Runs a call's database work on the executor.  If the caller has
+///        given up by the time a worker is free then the work is skipped and
+///        the call is finished as CANCELLED.  Work that throws finishes the
+///        call as UNKNOWN.
+/// @param[in] isCancelled  True indicates the caller gave up, e.g., its
+///                         deadline passed.  This is checked on the worker.
+/// @param[in] work         Fills in the response and returns the call's
+///                         status.  This is run on the worker.
+/// @param[in] finish       Receives the call's status exactly once.
+/// @result False if the queue was full.  In this case the work was not
+///         queued and finish was called with RESOURCE_EXHAUSTED on the
+///         calling thread so that the client can back off.
+[[maybe_unused]]
+bool runOnExecutor(::DatabaseExecutor &executor,
+                   const ::RequestClass requestClass,
+                   std::function<bool ()> isCancelled,
+                   std::function<grpc::Status ()> work,
+                   std::function<void (const grpc::Status &)> finish)
+{
+    auto onFinish
+        = std::make_shared<std::function<void (const grpc::Status &)>>
+          (std::move(finish));
+    const auto accepted
+        = executor.submit([isCancelled = std::move(isCancelled),
+                           work = std::move(work),
+                           onFinish]()
+          {
+              grpc::Status status{grpc::Status::CANCELLED};
+              if (!isCancelled())
+              {
+                  try
+                  {
+                      status = work();
+                  }
+                  catch (const std::exception &e)
+                  {
+                      spdlog::warn("Database work failed because "
+                                 + std::string {e.what()});
+                      status = grpc::Status{grpc::StatusCode::UNKNOWN,
+                                            "Server-side query failed"};
+                  }
+              }
+              (*onFinish)(status);
+          },
+          requestClass);
+    if (!accepted)
+    {
+        (*onFinish)(grpc::Status{grpc::StatusCode::RESOURCE_EXHAUSTED,
+                                 "Database work queue is full"});
+    }
+    return accepted;
+}
+
+}
+#endif
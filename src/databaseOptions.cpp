@@ -0,0 +1,157 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include "uMetadata/databaseOptions.hpp"
+
+using namespace UMetadata;
+
+class DatabaseOptions::DatabaseOptionsImpl
+{
+public:
+    std::chrono::milliseconds mBusyTimeout{5000};
+    int mReadConnectionPoolSize{
+        std::max(1, static_cast<int> (std::thread::hardware_concurrency()))};
+    int mAsyncQueryThreads{2};
+    int64_t mMemoryMapSize{256*1024*1024};
+    int64_t mCacheSize{0};
+    DatabaseOptions::JournalMode mJournalMode{DatabaseOptions::JournalMode::WAL};
+    DatabaseOptions::ServingMode mServingMode{DatabaseOptions::ServingMode::File};
+};
+
+/// Constructor
+DatabaseOptions::DatabaseOptions() :
+    pImpl(std::make_unique<DatabaseOptionsImpl> ())
+{
+}
+
+/// Copy constructor
+DatabaseOptions::DatabaseOptions(const DatabaseOptions &options)
+{
+    *this = options;
+}
+
+/// Move constructor
+DatabaseOptions::DatabaseOptions(DatabaseOptions &&options) noexcept
+{
+    *this = std::move(options);
+}
+
+/// Copy assignment
+DatabaseOptions& DatabaseOptions::operator=(const DatabaseOptions &options)
+{
+    if (&options == this){return *this;}
+    pImpl = std::make_unique<DatabaseOptionsImpl> (*options.pImpl);
+    return *this;
+}
+
+/// Move assignment
+DatabaseOptions& DatabaseOptions::operator=(DatabaseOptions &&options) noexcept
+{
+    if (&options == this){return *this;}
+    pImpl = std::move(options.pImpl);
+    return *this;
+}
+
+/// Destructor
+DatabaseOptions::~DatabaseOptions() = default;
+
+/// Journal mode
+void DatabaseOptions::setJournalMode(const JournalMode mode) noexcept
+{
+    pImpl->mJournalMode = mode;
+}
+
+DatabaseOptions::JournalMode DatabaseOptions::getJournalMode() const noexcept
+{
+    return pImpl->mJournalMode;
+}
+
+/// Busy timeout
+void DatabaseOptions::setBusyTimeout(const std::chrono::milliseconds &timeout)
+{
+    if (timeout.count() < 0)
+    {
+        throw std::invalid_argument("Busy timeout must be non-negative");
+    }
+    pImpl->mBusyTimeout = timeout;
+}
+
+std::chrono::milliseconds DatabaseOptions::getBusyTimeout() const noexcept
+{
+    return pImpl->mBusyTimeout;
+}
+
+/// Read connection pool size
+void DatabaseOptions::setReadConnectionPoolSize(const int poolSize)
+{
+    if (poolSize < 1)
+    {
+        throw std::invalid_argument("Pool size must be positive");
+    }
+    pImpl->mReadConnectionPoolSize = poolSize;
+}
+
+int DatabaseOptions::getReadConnectionPoolSize() const noexcept
+{
+    return pImpl->mReadConnectionPoolSize;
+}
+
+/// Asynchronous query threads
+void DatabaseOptions::setAsyncQueryThreads(const int nThreads)
+{
+    if (nThreads < 1)
+    {
+        throw std::invalid_argument("Number of threads must be positive");
+    }
+    pImpl->mAsyncQueryThreads = nThreads;
+}
+
+int DatabaseOptions::getAsyncQueryThreads() const noexcept
+{
+    return pImpl->mAsyncQueryThreads;
+}
+
+/// Serving mode
+void DatabaseOptions::setServingMode(const ServingMode mode) noexcept
+{
+    pImpl->mServingMode = mode;
+}
+
+DatabaseOptions::ServingMode DatabaseOptions::getServingMode() const noexcept
+{
+    return pImpl->mServingMode;
+}
+
+/// Memory map size
+void DatabaseOptions::setMemoryMapSize(const int64_t memoryMapSize)
+{
+    if (memoryMapSize <= 0)
+    {
+        throw std::invalid_argument("Memory map size must be positive");
+    }
+    pImpl->mMemoryMapSize = memoryMapSize;
+}
+
+int64_t DatabaseOptions::getMemoryMapSize() const noexcept
+{
+    return pImpl->mMemoryMapSize;
+}
+
+/// Page cache size
+void DatabaseOptions::setCacheSize(const int64_t cacheSize)
+{
+    if (cacheSize < 0)
+    {
+        throw std::invalid_argument("Cache size must be non-negative");
+    }
+    pImpl->mCacheSize = cacheSize;
+}
+
+int64_t DatabaseOptions::getCacheSize() const noexcept
+{
+    return pImpl->mCacheSize;
+}
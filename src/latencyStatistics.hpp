@@ -0,0 +1,307 @@
+#ifndef LATENCY_STATISTICS_HPP
+#define LATENCY_STATISTICS_HPP
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "uMetadataAPI/v1/server_statistics_response.pb.h"
+namespace
+{
+
+/// @brief A log-linear latency histogram in the spirit of HdrHistogram.
+///        Times below 128 ns are exact and longer times are binned to within
+///        1/64 of their value, so percentiles are accurate to about 2%.
+///        There is a single writer but any thread may read concurrently.
+class LatencyHistogram
+{
+public:
+    /// @brief Records a time.  Only the owning thread may call this.
+    void record(const std::chrono::nanoseconds &time) noexcept
+    {
+        const auto value
+            = std::min(static_cast<uint64_t> (std::max<int64_t> (time.count(),
+                                                                 0)),
+                       MAXIMUM_VALUE);
+        auto &count = mCounts[toIndex(value)];
+        // There is one writer so a read-modify-write needs no lock prefix
+        count.store(count.load(std::memory_order_relaxed) + 1,
+                    std::memory_order_relaxed);
+        mTotal.store(mTotal.load(std::memory_order_relaxed) + value,
+                     std::memory_order_relaxed);
+        if (value > mMaximum.load(std::memory_order_relaxed))
+        {
+            mMaximum.store(value, std::memory_order_relaxed);
+        }
+    }
+    /// @brief Adds this histogram's counts to the given totals.
+    void addTo(std::vector<uint64_t> &counts,
+               uint64_t &total,
+               uint64_t &maximum) const
+    {
+        counts.resize(NUMBER_OF_BINS, 0);
+        for (size_t i = 0; i < NUMBER_OF_BINS; ++i)
+        {
+            counts[i] = counts[i] + mCounts[i].load(std::memory_order_relaxed);
+        }
+        total = total + mTotal.load(std::memory_order_relaxed);
+        maximum = std::max(maximum, mMaximum.load(std::memory_order_relaxed));
+    }
+    /// @result The time in ns represented by a bin, i.e., its midpoint.
+    [[nodiscard]] static double toValue(const size_t index) noexcept
+    {
+        if (index < SUB_BINS){return static_cast<double> (index);}
+        const auto exponent = index/HALF_SUB_BINS - 1;
+        const auto mantissa = index - exponent*HALF_SUB_BINS;
+        const auto lowest = static_cast<double> (mantissa << exponent);
+        return lowest + static_cast<double> ((uint64_t {1} << exponent) - 1)/2;
+    }
+    /// @result The time in ns at the given percentile of the merged counts.
+    [[nodiscard]] static double getPercentile(const std::vector<uint64_t> &counts,
+                                              const uint64_t nSamples,
+                                              const double percentile) noexcept
+    {
+        if (nSamples == 0){return 0;}
+        const auto target
+            = std::max<uint64_t> (1,
+                 static_cast<uint64_t>
+                 (std::ceil(percentile/100*static_cast<double> (nSamples))));
+        uint64_t cumulative{0};
+        for (size_t i = 0; i < counts.size(); ++i)
+        {
+            cumulative = cumulative + counts[i];
+            if (cumulative >= target){return toValue(i);}
+        }
+        return toValue(counts.size() - 1);
+    }
+private:
+    [[nodiscard]] static size_t toIndex(const uint64_t value) noexcept
+    {
+        if (value < SUB_BINS){return static_cast<size_t> (value);}
+        const auto exponent
+            = static_cast<size_t> (std::bit_width(value)) - SUB_BIN_BITS;
+        return exponent*HALF_SUB_BINS
+             + static_cast<size_t> (value >> exponent);
+    }
+    static constexpr size_t SUB_BIN_BITS{7};
+    static constexpr size_t SUB_BINS{size_t {1} << SUB_BIN_BITS};
+    static constexpr size_t HALF_SUB_BINS{SUB_BINS/2};
+    /// About 18 minutes
+    static constexpr size_t MAXIMUM_BITS{40};
+    static constexpr uint64_t MAXIMUM_VALUE{(uint64_t {1} << MAXIMUM_BITS) - 1};
+    static constexpr size_t NUMBER_OF_BINS{
+        (MAXIMUM_BITS - SUB_BIN_BITS + 2)*HALF_SUB_BINS};
+    std::array<std::atomic<uint64_t>, NUMBER_OF_BINS> mCounts{};
+    std::atomic<uint64_t> mTotal{0};
+    std::atomic<uint64_t> mMaximum{0};
+};
+
+/// The operations whose stages are measured.  These are the RPCs and the
+/// snapshot rebuilds that happen off of the request path.
+enum class Operation : size_t
+{
+    GetAllActiveStations = 0,
+    GetAllActiveStationsPaged,
+    GetActiveStation,
+    GetActiveStations,
+    WatchActiveStations,
+    GetActiveStationsInBoundingBox,
+    GetActiveStationsWithinRadius,
+    GetAllActiveChannels,
+    GetActiveChannel,
+    GetServerStatistics,
+    ActiveStationsSnapshot,
+    ActiveStationProjection,
+    ActiveChannelsSnapshot,
+    ActiveChannelProjection
+};
+constexpr std::array<std::string_view, 14> OPERATION_NAMES
+{
+    "GetAllActiveStations",
+    "GetAllActiveStationsPaged",
+    "GetActiveStation",
+    "GetActiveStations",
+    "WatchActiveStations",
+    "GetActiveStationsInBoundingBox",
+    "GetActiveStationsWithinRadius",
+    "GetAllActiveChannels",
+    "GetActiveChannel",
+    "GetServerStatistics",
+    "ActiveStationsSnapshot",
+    "ActiveStationProjection",
+    "ActiveChannelsSnapshot",
+    "ActiveChannelProjection"
+};
+
+/// The stages of an operation.
+enum class Stage : size_t
+{
+    Total = 0,
+    SQLiteStep,
+    RowUnpack,
+    ToProtobuf,
+    Serialization
+};
+constexpr std::array<std::string_view, 5> STAGE_NAMES
+{
+    "total",
+    "sqlite_step",
+    "row_unpack",
+    "to_protobuf",
+    "serialization"
+};
+
+/// @result The operation corresponding to an RPC's method name or
+///         std::nullopt if the method is not measured.
+[[maybe_unused]] [[nodiscard]] std::optional<::Operation>
+    toOperation(const std::string_view &method) noexcept
+{
+    for (size_t i = 0; i < OPERATION_NAMES.size(); ++i)
+    {
+        if (OPERATION_NAMES[i] == method){return static_cast<::Operation> (i);}
+    }
+    return std::nullopt;
+}
+
+/// @brief Holds the stage latencies of every operation.  Each thread records
+///        into its own histograms so recording never takes a lock or
+///        contends for a cache line; only reporting visits every thread.
+class LatencyStatistics
+{
+public:
+    /// @result The process's statistics.  These are never destroyed since
+    ///         gRPC's threads, which record into them, can outlive the
+    ///         server.
+    [[nodiscard]] static LatencyStatistics &getInstance()
+    {
+        static auto instance = new LatencyStatistics();
+        return *instance;
+    }
+    /// @brief Records the time spent in a stage of an operation.
+    void record(const ::Operation operation,
+                const ::Stage stage,
+                const std::chrono::nanoseconds &time)
+    {
+        auto &histogram
+            = getThreadSlot().histograms[
+                 static_cast<size_t> (operation)*STAGE_NAMES.size()
+               + static_cast<size_t> (stage)];
+        auto pointer = histogram.load(std::memory_order_acquire);
+        if (pointer == nullptr)
+        {
+            // Only this thread writes the slot so there is no race
+            pointer = new ::LatencyHistogram();
+            histogram.store(pointer, std::memory_order_release);
+        }
+        pointer->record(time);
+    }
+    /// @brief Merges every thread's histograms into the response.
+    void fill(UMetadataAPI::V1::ServerStatisticsResponse *response) const
+    {
+        response->mutable_start_time()->set_seconds(
+            std::chrono::duration_cast<std::chrono::seconds>
+            (mStartTime.time_since_epoch()).count());
+        const std::lock_guard<std::mutex> lock(mSlotsMutex);
+        for (size_t operation = 0;
+             operation < OPERATION_NAMES.size();
+             ++operation)
+        {
+            UMetadataAPI::V1::OperationStatistics statistics;
+            for (size_t stage = 0; stage < STAGE_NAMES.size(); ++stage)
+            {
+                std::vector<uint64_t> counts;
+                uint64_t total{0};
+                uint64_t maximum{0};
+                for (const auto &slot : mSlots)
+                {
+                    auto histogram
+                        = slot->histograms[operation*STAGE_NAMES.size()
+                                         + stage].load(
+                             std::memory_order_acquire);
+                    if (histogram){histogram->addTo(counts, total, maximum);}
+                }
+                const auto nSamples
+                    = std::accumulate(counts.begin(), counts.end(),
+                                      uint64_t {0});
+                if (nSamples == 0){continue;}
+                constexpr double toMicroseconds{1.e-3};
+                auto latency = statistics.add_stages();
+                latency->set_stage(std::string {STAGE_NAMES[stage]});
+                latency->set_count(nSamples);
+                latency->set_mean(toMicroseconds*static_cast<double> (total)
+                                 /static_cast<double> (nSamples));
+                latency->set_p50(toMicroseconds
+                    *::LatencyHistogram::getPercentile(counts, nSamples, 50));
+                latency->set_p99(toMicroseconds
+                    *::LatencyHistogram::getPercentile(counts, nSamples, 99));
+                latency->set_p999(toMicroseconds
+                    *::LatencyHistogram::getPercentile(counts, nSamples, 99.9));
+                latency->set_maximum(toMicroseconds
+                                    *static_cast<double> (maximum));
+            }
+            if (statistics.stages().empty()){continue;}
+            statistics.set_operation(std::string {OPERATION_NAMES[operation]});
+            *response->add_operations() = std::move(statistics);
+        }
+    }
+private:
+    LatencyStatistics() = default;
+    struct ThreadSlot
+    {
+        ~ThreadSlot()
+        {
+            for (auto &histogram : histograms)
+            {
+                delete histogram.load(std::memory_order_acquire);
+            }
+        }
+        std::array<std::atomic<::LatencyHistogram *>,
+                   OPERATION_NAMES.size()*STAGE_NAMES.size()> histograms{};
+        std::atomic<bool> inUse{false};
+    };
+    /// Returns the slot to the pool when its thread exits so a replacement
+    /// thread picks up, rather than duplicates, its histograms.
+    struct SlotLease
+    {
+        ~SlotLease()
+        {
+            if (slot){slot->inUse.store(false, std::memory_order_release);}
+        }
+        ThreadSlot *slot{nullptr};
+    };
+    [[nodiscard]] ThreadSlot &getThreadSlot()
+    {
+        thread_local SlotLease lease;
+        if (lease.slot){return *lease.slot;}
+        const std::lock_guard<std::mutex> lock(mSlotsMutex);
+        for (auto &slot : mSlots)
+        {
+            bool expected{false};
+            if (slot->inUse.compare_exchange_strong(expected, true))
+            {
+                lease.slot = slot.get();
+                return *lease.slot;
+            }
+        }
+        mSlots.push_back(std::make_unique<ThreadSlot> ());
+        mSlots.back()->inUse.store(true);
+        lease.slot = mSlots.back().get();
+        return *lease.slot;
+    }
+    mutable std::mutex mSlotsMutex;
+    std::vector<std::unique_ptr<ThreadSlot>> mSlots;
+    std::chrono::system_clock::time_point mStartTime{
+        std::chrono::system_clock::now()};
+};
+
+}
+#endif
@@ -0,0 +1,272 @@
+#ifndef METRICS_HPP
+#define METRICS_HPP
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <opentelemetry/context/context.h>
+#include <opentelemetry/metrics/provider.h>
+#include <opentelemetry/sdk/metrics/export/periodic_exporting_metric_reader_factory.h>
+#include <opentelemetry/sdk/metrics/meter_provider.h>
+#include <opentelemetry/sdk/metrics/meter_provider_factory.h>
+#include <opentelemetry/sdk/metrics/push_metric_exporter.h>
+#include "uMetadata/version.hpp"
+namespace
+{
+
+/// @result The service and method of an RPC's full name, which is of the
+///         form /package.Service/Method.
+[[maybe_unused]] [[nodiscard]]
+std::pair<std::string, std::string> splitMethodName(const std::string_view &fullName)
+{
+    const auto slash = fullName.rfind('/');
+    std::string service{fullName.substr(0, slash)};
+    if (!service.empty() && service.front() == '/')
+    {
+        service.erase(0, 1);
+    }
+    std::string method;
+    if (slash != std::string_view::npos)
+    {
+        method = std::string {fullName.substr(slash + 1)};
+    }
+    return std::pair {std::move(service), std::move(method)};
+}
+
+/// @brief Counts the lookups served by a cache.  These are incremented on the
+///        request path so they are plain atomics which the metric reader
+///        observes when it collects.
+struct CacheStatistics
+{
+    std::atomic<int64_t> hits{0};
+    std::atomic<int64_t> misses{0};
+};
+
+/// @brief The server's OpenTelemetry instruments.  These are created from the
+///        global meter provider so, if metrics are not exported, recording
+///        is a no-op.
+class Metrics
+{
+public:
+    /// @param[in] name  The instrumentation scope, i.e., the application.
+    explicit Metrics(const std::string &name)
+    {
+        auto meter
+            = opentelemetry::metrics::Provider::GetMeterProvider()->GetMeter(
+                 name, UMetadata::Version::getVersion());
+        mRPCDuration
+            = meter->CreateDoubleHistogram("rpc.server.duration",
+                                           "Time to handle an RPC",
+                                           "ms");
+        mActiveRequests
+            = meter->CreateInt64UpDownCounter("umetadata.rpc.active_requests",
+                                              "RPCs in progress",
+                                              "{request}");
+        mResponseBytes
+            = meter->CreateUInt64Counter("umetadata.rpc.response.size",
+                                         "Serialized bytes sent in responses",
+                                         "By");
+        mRows
+            = meter->CreateUInt64Counter("umetadata.rpc.rows",
+                                         "Stations or channels returned",
+                                         "{row}");
+        mQueryDuration
+            = meter->CreateDoubleHistogram("umetadata.db.query.duration",
+                                           "Time spent in SQLite",
+                                           "ms");
+        mSerializationDuration
+            = meter->CreateDoubleHistogram("umetadata.serialization.duration",
+                                           "Time spent serializing protobufs",
+                                           "ms");
+        mRejectedRequests
+            = meter->CreateUInt64Counter("umetadata.rpc.rejected",
+                                         "RPCs rejected by admission control",
+                                         "{request}");
+        mQueueDuration
+            = meter->CreateDoubleHistogram("umetadata.db.queue.duration",
+                                           "Time waiting for a database worker",
+                                           "ms");
+        mCacheLookups
+            = meter->CreateInt64ObservableCounter(
+                 "umetadata.cache.lookups",
+                 "Lookups served by, or missing, a cache",
+                 "{lookup}");
+        if (mCacheLookups)
+        {
+            mCacheLookups->AddCallback(&Metrics::observeCaches, this);
+        }
+    }
+    ~Metrics()
+    {
+        if (mCacheLookups)
+        {
+            mCacheLookups->RemoveCallback(&Metrics::observeCaches, this);
+        }
+    }
+    Metrics(const Metrics &) = delete;
+    Metrics& operator=(const Metrics &) = delete;
+    void recordRPC(const std::string_view &service,
+                   const std::string_view &method,
+                   const int statusCode,
+                   const double milliseconds)
+    {
+        mRPCDuration->Record(milliseconds,
+                             {{"rpc.service", service},
+                              {"rpc.method", method},
+                              {"rpc.grpc.status_code",
+                               static_cast<int64_t> (statusCode)}},
+                             opentelemetry::context::Context {});
+    }
+    void addActiveRequests(const std::string_view &method,
+                           const int64_t change)
+    {
+        mActiveRequests->Add(change, {{"rpc.method", method}});
+    }
+    void addResponseBytes(const std::string_view &method,
+                          const uint64_t bytes)
+    {
+        mResponseBytes->Add(bytes, {{"rpc.method", method}});
+    }
+    void addRows(const std::string_view &method, const size_t rows)
+    {
+        mRows->Add(static_cast<uint64_t> (rows), {{"rpc.method", method}});
+    }
+    /// @param[in] operation  The RPC or snapshot that issued the query.
+    void recordQuery(const std::string_view &operation,
+                     const double milliseconds)
+    {
+        mQueryDuration->Record(milliseconds,
+                               {{"operation", operation}},
+                               opentelemetry::context::Context {});
+    }
+    /// @param[in] reason  Why the RPC was rejected, e.g., concurrency.
+    void addRejectedRequest(const std::string_view &method,
+                            const std::string_view &reason)
+    {
+        mRejectedRequests->Add(1, {{"rpc.method", method},
+                                   {"reason", reason}});
+    }
+    void recordQueueTime(const std::string_view &method,
+                         const double milliseconds)
+    {
+        mQueueDuration->Record(milliseconds,
+                               {{"rpc.method", method}},
+                               opentelemetry::context::Context {});
+    }
+    /// @param[in] operation  The RPC or snapshot that was serialized.
+    void recordSerialization(const std::string_view &operation,
+                             const double milliseconds)
+    {
+        mSerializationDuration->Record(milliseconds,
+                                       {{"operation", operation}},
+                                       opentelemetry::context::Context {});
+    }
+    /// @brief Reports the cache's lookups until it is removed.
+    void addCache(const std::string &name, const CacheStatistics *statistics)
+    {
+        const std::lock_guard<std::mutex> lock(mCachesMutex);
+        mCaches.emplace_back(name, statistics);
+    }
+    void removeCache(const CacheStatistics *statistics)
+    {
+        const std::lock_guard<std::mutex> lock(mCachesMutex);
+        std::erase_if(mCaches,
+                      [statistics](const auto &cache)
+                      {
+                          return cache.second == statistics;
+                      });
+    }
+private:
+    static void observeCaches(opentelemetry::metrics::ObserverResult result,
+                              void *state)
+    {
+        auto metrics = static_cast<Metrics *> (state);
+        auto observer
+            = opentelemetry::nostd::get<
+                 opentelemetry::nostd::shared_ptr<
+                    opentelemetry::metrics::ObserverResultT<int64_t>>>
+              (result);
+        const std::lock_guard<std::mutex> lock(metrics->mCachesMutex);
+        for (const auto &[name, statistics] : metrics->mCaches)
+        {
+            observer->Observe(
+                statistics->hits.load(std::memory_order_relaxed),
+                {{"cache", std::string_view {name}}, {"result", "hit"}});
+            observer->Observe(
+                statistics->misses.load(std::memory_order_relaxed),
+                {{"cache", std::string_view {name}}, {"result", "miss"}});
+        }
+    }
+    opentelemetry::nostd::unique_ptr<opentelemetry::metrics::Histogram<double>>
+        mRPCDuration;
+    opentelemetry::nostd::unique_ptr<
+        opentelemetry::metrics::UpDownCounter<int64_t>> mActiveRequests;
+    opentelemetry::nostd::unique_ptr<opentelemetry::metrics::Counter<uint64_t>>
+        mResponseBytes;
+    opentelemetry::nostd::unique_ptr<opentelemetry::metrics::Counter<uint64_t>>
+        mRows;
+    opentelemetry::nostd::unique_ptr<opentelemetry::metrics::Histogram<double>>
+        mQueryDuration;
+    opentelemetry::nostd::unique_ptr<opentelemetry::metrics::Histogram<double>>
+        mSerializationDuration;
+    opentelemetry::nostd::unique_ptr<opentelemetry::metrics::Counter<uint64_t>>
+        mRejectedRequests;
+    opentelemetry::nostd::unique_ptr<opentelemetry::metrics::Histogram<double>>
+        mQueueDuration;
+    opentelemetry::nostd::shared_ptr<
+        opentelemetry::metrics::ObservableInstrument> mCacheLookups;
+    std::mutex mCachesMutex;
+    std::vector<std::pair<std::string, const CacheStatistics *>> mCaches;
+};
+
+/// @brief Installs a meter provider that periodically pushes the metrics to
+///        an exporter, e.g., an OTLP/HTTP collector, for as long as this
+///        lives.  Instruments must be created after this to be exported.
+class MetricsExporter
+{
+public:
+    MetricsExporter(
+        std::unique_ptr<opentelemetry::sdk::metrics::PushMetricExporter> exporter,
+        const std::chrono::milliseconds &exportInterval,
+        const std::chrono::milliseconds &exportTimeout)
+    {
+        opentelemetry::sdk::metrics::PeriodicExportingMetricReaderOptions
+            readerOptions;
+        readerOptions.export_interval_millis = exportInterval;
+        readerOptions.export_timeout_millis = exportTimeout;
+        auto reader
+            = opentelemetry::sdk::metrics::PeriodicExportingMetricReaderFactory::
+              Create(std::move(exporter), readerOptions);
+        auto provider
+            = opentelemetry::sdk::metrics::MeterProviderFactory::Create();
+        static_cast<opentelemetry::sdk::metrics::MeterProvider *>
+           (provider.get())->AddMetricReader(std::move(reader));
+        mProvider = std::move(provider);
+        opentelemetry::metrics::Provider::SetMeterProvider(mProvider);
+    }
+    /// The provider flushes the last metrics when it is released.
+    ~MetricsExporter()
+    {
+        std::shared_ptr<opentelemetry::metrics::MeterProvider> none;
+        opentelemetry::metrics::Provider::SetMeterProvider(none);
+    }
+    /// @brief Exports the metrics recorded so far now rather than waiting
+    ///        for the next export interval.
+    bool forceFlush()
+    {
+        return static_cast<opentelemetry::sdk::metrics::MeterProvider *>
+               (mProvider.get())->ForceFlush();
+    }
+    MetricsExporter(const MetricsExporter &) = delete;
+    MetricsExporter& operator=(const MetricsExporter &) = delete;
+private:
+    std::shared_ptr<opentelemetry::metrics::MeterProvider> mProvider;
+};
+
+}
+#endif
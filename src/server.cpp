@@ -1,19 +1,63 @@
 #include <iostream>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cctype>
+#include <chrono>
 #include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
 #include <exception>
 #include <fstream>
+#include <functional>
+#include <initializer_list>
 #include <limits>
+#include <map>
 #include <memory>
 #include <mutex>
+#include <numeric>
+#include <optional>
+#include <set>
 #include <sstream>
 #include <stdexcept>
+#include <string_view>
 #include <thread>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 #include <spdlog/spdlog.h>
 #include <sqlite3.h>
 #include <grpcpp/grpcpp.h>
+#include <grpcpp/support/message_allocator.h>
+#include <grpcpp/support/server_interceptor.h>
+#include <google/protobuf/arena.h>
+#include <google/protobuf/field_mask.pb.h>
 #include <grpcpp/health_check_service_interface.h>
 #include <grpcpp/ext/proto_server_reflection_plugin.h>
 //#include <grpcpp/ext/otel_plugin.h>
+#include <opentelemetry/exporters/otlp/otlp_http_metric_exporter_factory.h>
+#include <opentelemetry/exporters/otlp/otlp_http_metric_exporter_options.h>
+#include <opentelemetry/exporters/otlp/otlp_http_exporter_factory.h>
+#include <opentelemetry/exporters/otlp/otlp_http_exporter_options.h>
+#include <opentelemetry/metrics/provider.h>
+#include <opentelemetry/context/runtime_context.h>
+#include <opentelemetry/sdk/resource/resource.h>
+#include <opentelemetry/sdk/trace/batch_span_processor_factory.h>
+#include <opentelemetry/sdk/trace/batch_span_processor_options.h>
+#include <opentelemetry/sdk/trace/samplers/parent_factory.h>
+#include <opentelemetry/sdk/trace/samplers/trace_id_ratio_factory.h>
+#include <opentelemetry/sdk/trace/tracer_provider_factory.h>
+#include <opentelemetry/trace/context.h>
+#include <opentelemetry/trace/propagation/http_trace_context.h>
+#include <opentelemetry/trace/provider.h>
+#include <opentelemetry/trace/scope.h>
+#include <opentelemetry/trace/tracer.h>
+#include <opentelemetry/sdk/metrics/export/periodic_exporting_metric_reader_factory.h>
+#include <opentelemetry/sdk/metrics/meter_provider.h>
+#include <opentelemetry/sdk/metrics/meter_provider_factory.h>
 #include <boost/program_options.hpp>
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/ini_parser.hpp>
@@ -22,9 +66,21 @@
 #include <spdlog/sinks/stdout_color_sinks.h>
 #include "uMetadata/station.hpp"
 #include "uMetadata/database.hpp"
+#include "uMetadata/version.hpp"
+#include "uMetadata/databaseOptions.hpp"
+#include "uMetadata/channel.hpp"
 #include "uMetadataAPI/v1/station_information_service.grpc.pb.h"
+#include "uMetadataAPI/v1/channel_information_service.grpc.pb.h"
+#include "uMetadataAPI/v1/server_statistics_service.grpc.pb.h"
+#include "latencyStatistics.hpp"
+#include "activeStationsSnapshot.hpp"
+#include "activeChannelsSnapshot.hpp"
+#include "metrics.hpp"
+#include "databaseExecutor.hpp"
+#include "admissionController.hpp"
 
 #include "data/utah.hpp"
+#include "data/utahChannels.hpp"
 #include "data/ynp.hpp"
 
 
@@ -37,13 +93,570 @@ struct ProgramOptions
 {
     std::string applicationName{APPLICATION_NAME};
     std::filesystem::path sqlite3Database{"metadata.sqlite3"};
+    UMetadata::DatabaseOptions databaseOptions;
+    std::chrono::milliseconds changePollInterval{1000};
+    // The threads that run queries off of gRPC's threads.  If 0 then this
+    // is the number of read connections.
+    int databaseWorkerThreads{0};
+    // Queries beyond this many waiting for a worker are rejected.
+    size_t maximumQueuedQueries{1024};
     std::filesystem::path grpcServerKey; // e.g., localhost.key
     std::filesystem::path grpcServerCertificate; // e.g., localhost.crt
     std::string grpcHost{"0.0.0.0"};
     uint16_t grpcPort{50000};
+    // Calls to each point lookup RPC, e.g., GetActiveStation, beyond this
+    // many in flight are rejected.
+    int maximumConcurrentLookups{256};
+    // Calls to each full-inventory RPC, e.g., GetAllActiveStations, beyond
+    // this many in flight are rejected.
+    int maximumConcurrentInventories{16};
+    // Calls that wait longer than this for a database worker are rejected
+    // rather than run.
+    std::chrono::milliseconds lookupQueueBudget{250};
+    std::chrono::milliseconds inventoryQueueBudget{2000};
     int verbosity{3};
     bool grpcEnableReflection{false};
 bool isUtah{true};
+    // The OTLP/HTTP metrics collector, e.g.,
+    // http://localhost:4318/v1/metrics.  If empty then metrics are not
+    // exported.
+    std::string otelHTTPMetricsURL;
+    std::chrono::milliseconds otelHTTPMetricsExportInterval{5000};
+    std::chrono::milliseconds otelHTTPMetricsExportTimeout{500};
+    // The OTLP/HTTP traces collector, e.g., http://localhost:4318/v1/traces.
+    // If empty then requests are not traced.
+    std::string otelHTTPTracesURL;
+    // The fraction of the traces that start here which are sampled.
+    double otelHTTPTracesSamplingRatio{0.01};
+    // If true then a request whose caller sampled its trace is always
+    // traced.  Otherwise the ratio applies to every request.
+    bool otelHTTPTracesRespectParentSampling{true};
+    std::chrono::milliseconds otelHTTPTracesScheduleDelay{5000};
+    // Spans are dropped, not waited on, when this many await export.
+    size_t otelHTTPTracesMaximumQueueSize{2048};
+};
+
+/// True while a TracesExporter is installed.  Until then, the caller's trace
+/// context is not read since the no-op tracer would ignore it.
+std::atomic<bool> tracingEnabled{false};
+
+/// @result The tracer of the installed tracer provider.  This is a no-op
+///         unless tracing is enabled.
+[[nodiscard]] opentelemetry::nostd::shared_ptr<opentelemetry::trace::Tracer>
+    getTracer()
+{
+    return opentelemetry::trace::Provider::GetTracerProvider()
+          ->GetTracer(APPLICATION_NAME, UMetadata::Version::getVersion());
+}
+
+/// @brief Records the status of an RPC on its span.
+void setSpanStatus(opentelemetry::trace::Span &span,
+                   const grpc::Status &status) noexcept
+{
+    span.SetAttribute("rpc.grpc.status_code",
+                      static_cast<int> (status.error_code()));
+    if (!status.ok())
+    {
+        span.SetStatus(opentelemetry::trace::StatusCode::kError,
+                       status.error_message());
+    }
+}
+
+/// @brief Makes a span the thread's active span, so that spans started
+///        while it lives are its children, and ends it on destruction.
+class ScopedSpan
+{
+public:
+    explicit ScopedSpan(
+        opentelemetry::nostd::shared_ptr<opentelemetry::trace::Span> span) :
+        mSpan(std::move(span)),
+        mScope(mSpan)
+    {
+    }
+    ScopedSpan(opentelemetry::trace::Tracer &tracer,
+               const std::string_view &name) :
+        ScopedSpan(tracer.StartSpan(name))
+    {
+    }
+    ~ScopedSpan()
+    {
+        if (mSpan){mSpan->End();}
+    }
+    ScopedSpan(const ScopedSpan &) = delete;
+    ScopedSpan& operator=(const ScopedSpan &) = delete;
+    /// @brief Records the status of the RPC on the span.
+    void setStatus(const grpc::Status &status) noexcept
+    {
+        ::setSpanStatus(*mSpan, status);
+    }
+    /// @brief Records a failure on the span.
+    void setError(const std::string_view &message) noexcept
+    {
+        mSpan->SetStatus(opentelemetry::trace::StatusCode::kError, message);
+    }
+    /// @brief Hands the span to a streaming reactor which will end it when
+    ///        the stream is done.
+    [[nodiscard]] opentelemetry::nostd::shared_ptr<opentelemetry::trace::Span>
+        release() noexcept
+    {
+        return std::exchange(mSpan, {});
+    }
+private:
+    opentelemetry::nostd::shared_ptr<opentelemetry::trace::Span> mSpan;
+    opentelemetry::trace::Scope mScope;
+};
+
+/// @brief Reads the W3C trace context headers from a request's metadata.
+class ServerContextCarrier :
+    public opentelemetry::context::propagation::TextMapCarrier
+{
+public:
+    explicit ServerContextCarrier(
+        const std::multimap<grpc::string_ref, grpc::string_ref> &metadata) :
+        mMetadata(metadata)
+    {
+    }
+    opentelemetry::nostd::string_view Get(
+        opentelemetry::nostd::string_view key) const noexcept override
+    {
+        auto value = mMetadata.find(grpc::string_ref {key.data(), key.size()});
+        if (value == mMetadata.end()){return "";}
+        return {value->second.data(), value->second.size()};
+    }
+    void Set(opentelemetry::nostd::string_view,
+             opentelemetry::nostd::string_view) noexcept override
+    {
+    }
+private:
+    const std::multimap<grpc::string_ref, grpc::string_ref> &mMetadata;
+};
+
+/// @brief Starts the server's span for an RPC.  If traces are exported and
+///        the caller sent its trace context then the span joins the caller's
+///        trace.
+/// @param[in] method  The full method name, e.g.,
+///                    UMetadataAPI.V1.StationInformation/GetActiveStation.
+[[nodiscard]] opentelemetry::nostd::shared_ptr<opentelemetry::trace::Span>
+    startServerSpan(opentelemetry::trace::Tracer &tracer,
+                    const grpc::CallbackServerContext *context,
+                    const std::string_view &method)
+{
+    if (!tracingEnabled.load(std::memory_order_relaxed))
+    {
+        return tracer.StartSpan(method);
+    }
+    const ::ServerContextCarrier carrier{context->client_metadata()};
+    auto current = opentelemetry::context::RuntimeContext::GetCurrent();
+    opentelemetry::trace::propagation::HttpTraceContext propagator;
+    auto parent = propagator.Extract(carrier, current);
+    opentelemetry::trace::StartSpanOptions options;
+    options.kind = opentelemetry::trace::SpanKind::kServer;
+    options.parent = opentelemetry::trace::GetSpan(parent)->GetContext();
+    const auto slash = method.find('/');
+    return tracer.StartSpan(method,
+                            {{"rpc.system", "grpc"},
+                             {"rpc.service", method.substr(0, slash)},
+                             {"rpc.method", method.substr(slash + 1)}},
+                            options);
+}
+
+/// @brief Finishes a unary call and records its status on the call's span.
+grpc::ServerUnaryReactor *finish(grpc::CallbackServerContext *context,
+                                 ::ScopedSpan &span,
+                                 const grpc::Status &status)
+{
+    span.setStatus(status);
+    auto reactor = context->DefaultReactor();
+    reactor->Finish(status);
+    return reactor;
+}
+
+/// Ends a server-streaming call that failed before anything was written.
+template<typename Response>
+class FailedWriteReactor final : public grpc::ServerWriteReactor<Response>
+{
+public:
+    explicit FailedWriteReactor(const grpc::Status &status)
+    {
+        this->Finish(status);
+    }
+    void OnDone() override
+    {
+        delete this;
+    }
+};
+
+/// @brief Parses a request received by a raw (ByteBuffer) handler.
+/// @result True if the request was parsed.
+[[nodiscard]] bool parseRawRequest(const grpc::ByteBuffer &buffer,
+                                   google::protobuf::MessageLite *request)
+{
+    // The requests served this way are tiny so the copy is cheap
+    std::vector<grpc::Slice> slices;
+    std::string bytes;
+    if (buffer.Dump(&slices).ok())
+    {
+        for (const auto &slice : slices)
+        {
+            bytes.append(reinterpret_cast<const char *> (slice.begin()),
+                         slice.size());
+        }
+    }
+    return request->ParseFromString(bytes);
+}
+
+/// @brief Hands gRPC a pre-serialized response without copying it.  The
+///        bytes are kept alive until gRPC is done sending them.
+void setRawResponse(const std::shared_ptr<const std::string> &bytes,
+                    grpc::ByteBuffer *response)
+{
+    auto owner = new std::shared_ptr<const std::string> (bytes);
+    grpc::Slice slice{const_cast<char *> (bytes->data()),
+                      bytes->size(),
+                      [](void *userData)
+                      {
+                          delete static_cast
+                             <std::shared_ptr<const std::string> *>
+                             (userData);
+                      },
+                      owner};
+    grpc::ByteBuffer buffer{&slice, 1};
+    response->Swap(&buffer);
+}
+
+/// Allocates a call's request and response on a single protobuf arena so
+/// that building a large response does not pay for a heap allocation per
+/// message.  The arena is released when gRPC is done with the call.
+template<typename Request, typename Response>
+class ArenaMessageAllocator :
+    public grpc::MessageAllocator<Request, Response>
+{
+public:
+    explicit ArenaMessageAllocator(const size_t initialBlockSize) :
+        mInitialBlockSize(initialBlockSize)
+    {
+    }
+    grpc::MessageHolder<Request, Response> *AllocateMessages() override
+    {
+        return new MessageHolder(mInitialBlockSize);
+    }
+private:
+    class MessageHolder : public grpc::MessageHolder<Request, Response>
+    {
+    public:
+        explicit MessageHolder(const size_t initialBlockSize) :
+            mArena(toArenaOptions(initialBlockSize))
+        {
+            this->set_request(
+                google::protobuf::Arena::Create<Request> (&mArena));
+            this->set_response(
+                google::protobuf::Arena::Create<Response> (&mArena));
+        }
+        void Release() override
+        {
+            delete this;
+        }
+    private:
+        static google::protobuf::ArenaOptions
+            toArenaOptions(const size_t initialBlockSize)
+        {
+            google::protobuf::ArenaOptions options;
+            options.start_block_size = initialBlockSize;
+            options.max_block_size = std::max(initialBlockSize,
+                                              options.max_block_size);
+            return options;
+        }
+        google::protobuf::Arena mArena;
+    };
+    size_t mInitialBlockSize{0};
+};
+
+/// @result The milliseconds elapsed since the given time.
+[[nodiscard]] double getMilliseconds(
+    const std::chrono::steady_clock::time_point &startTime)
+{
+    const std::chrono::duration<double, std::milli> duration
+        = std::chrono::steady_clock::now() - startTime;
+    return duration.count();
+}
+
+/// @brief Attributes the SQLite stepping and row decoding done by the
+///        calling thread during its lifetime to an operation.
+class ProfiledQuery
+{
+public:
+    explicit ProfiledQuery(const ::Operation operation) :
+        mOperation(operation)
+    {
+        [[maybe_unused]] auto stale = UMetadata::Database::takeQueryProfile();
+    }
+    ~ProfiledQuery()
+    {
+        const auto profile = UMetadata::Database::takeQueryProfile();
+        auto &statistics = ::LatencyStatistics::getInstance();
+        statistics.record(mOperation, ::Stage::SQLiteStep, profile.step);
+        statistics.record(mOperation, ::Stage::RowUnpack, profile.unpack);
+    }
+    ProfiledQuery(const ProfiledQuery &) = delete;
+    ProfiledQuery& operator=(const ProfiledQuery &) = delete;
+private:
+    ::Operation mOperation;
+};
+
+/// @brief A unary reactor that holds the call's admission until gRPC is
+///        done with the call so that the RPC's limit also covers the time
+///        spent sending the response.
+class AdmittedUnaryReactor final : public grpc::ServerUnaryReactor
+{
+public:
+    explicit AdmittedUnaryReactor(
+        std::shared_ptr<const ::AdmissionController::Admission> admission) :
+        mAdmission(std::move(admission))
+    {
+    }
+    void OnDone() override
+    {
+        delete this;
+    }
+    /// @note This is only valid until the call is finished.
+    [[nodiscard]] const ::AdmissionController::Admission &getAdmission()
+        const noexcept
+    {
+        return *mAdmission;
+    }
+private:
+    std::shared_ptr<const ::AdmissionController::Admission> mAdmission;
+};
+
+/// @brief Finishes an admitted unary call and records its status on the
+///        call's span.
+grpc::ServerUnaryReactor *finish(
+    std::shared_ptr<const ::AdmissionController::Admission> admission,
+    ::ScopedSpan &span,
+    const grpc::Status &status)
+{
+    span.setStatus(status);
+    auto reactor = new ::AdmittedUnaryReactor(std::move(admission));
+    reactor->Finish(status);
+    return reactor;
+}
+
+/// @brief Finishes an admitted unary call once its database work has run on
+///        the executor.  The call's span is carried to, and active on, the
+///        worker.  Calls that are cancelled, or pass their deadline, while
+///        queued are not run.  Calls that do not fit in the queue, or wait
+///        longer than their queue budget, are rejected with
+///        RESOURCE_EXHAUSTED so that the client can back off.
+/// @param[in] work  Fills in the response and returns the call's status.
+grpc::ServerUnaryReactor *finishOnExecutor(
+    ::DatabaseExecutor &executor,
+    grpc::CallbackServerContext *context,
+    ::ScopedSpan &span,
+    std::shared_ptr<const ::AdmissionController::Admission> admission,
+    std::function<grpc::Status ()> work)
+{
+    // Only the reactor holds the admission on the worker's behalf so that
+    // it is given back when gRPC is done with the call and not whenever the
+    // worker releases the work
+    auto reactor = new ::AdmittedUnaryReactor(admission);
+    auto callSpan = span.release();
+    const auto queuedAt = std::chrono::steady_clock::now();
+    const auto accepted
+        = ::runOnExecutor(
+             executor,
+             admission->getRequestClass(),
+             [context]()
+             {
+                 return context->IsCancelled();
+             },
+             [reactor, callSpan, queuedAt, work = std::move(work)]()
+             {
+                 // The call is not finished so the reactor is still alive
+                 const auto &admission = reactor->getAdmission();
+                 const auto waited = std::chrono::steady_clock::now() - queuedAt;
+                 admission.recordQueueTime(waited);
+                 if (waited > admission.getQueueBudget())
+                 {
+                     // The caller likely gave up, or will, so do not spend
+                     // a worker on it
+                     admission.recordRejection("queue_time");
+                     return grpc::Status{
+                         grpc::StatusCode::RESOURCE_EXHAUSTED,
+                         "Request waited too long for a database worker"};
+                 }
+                 const opentelemetry::trace::Scope scope{callSpan};
+                 return work();
+             },
+             [reactor, callSpan](const grpc::Status &status)
+             {
+                 ::setSpanStatus(*callSpan, status);
+                 callSpan->End();
+                 reactor->Finish(status);
+             });
+    if (!accepted){admission->recordRejection("queue_full");}
+    return reactor;
+}
+
+/// @brief Records the latency, response size, and serialization time of
+///        every RPC.  gRPC creates one interceptor per call and destroys it
+///        when the call is done.
+class MetricsInterceptor final : public grpc::experimental::Interceptor
+{
+public:
+    MetricsInterceptor(const grpc::experimental::ServerRpcInfo *info,
+                       ::Metrics &metrics) :
+        mMetrics(metrics),
+        mStartTime(std::chrono::steady_clock::now())
+    {
+        std::tie(mService, mMethod) = ::splitMethodName(info->method());
+        mOperation = ::toOperation(mMethod);
+        mMetrics.addActiveRequests(mMethod, 1);
+    }
+    ~MetricsInterceptor() override
+    {
+        mMetrics.addActiveRequests(mMethod, -1);
+    }
+    void Intercept(grpc::experimental::InterceptorBatchMethods *methods) override
+    {
+        using HookPoint = grpc::experimental::InterceptionHookPoints;
+        if (methods->QueryInterceptionHookPoint(HookPoint::PRE_SEND_MESSAGE))
+        {
+            // Responses that were pre-serialized cost nothing here
+            const auto startTime = std::chrono::steady_clock::now();
+            const auto buffer = methods->GetSerializedSendMessage();
+            if (buffer != nullptr)
+            {
+                const auto duration
+                    = std::chrono::steady_clock::now() - startTime;
+                mMetrics.recordSerialization(
+                    mMethod,
+                    std::chrono::duration<double, std::milli>
+                       {duration}.count());
+                mMetrics.addResponseBytes(mMethod, buffer->Length());
+                if (mOperation)
+                {
+                    ::LatencyStatistics::getInstance().record(
+                        *mOperation, ::Stage::Serialization, duration);
+                }
+            }
+        }
+        if (methods->QueryInterceptionHookPoint(HookPoint::PRE_SEND_STATUS))
+        {
+            const auto duration = std::chrono::steady_clock::now() - mStartTime;
+            mMetrics.recordRPC(mService,
+                               mMethod,
+                               static_cast<int>
+                                  (methods->GetSendStatus().error_code()),
+                               std::chrono::duration<double, std::milli>
+                                  {duration}.count());
+            if (mOperation)
+            {
+                ::LatencyStatistics::getInstance().record(
+                    *mOperation, ::Stage::Total, duration);
+            }
+        }
+        methods->Proceed();
+    }
+private:
+    ::Metrics &mMetrics;
+    std::string mService;
+    std::string mMethod;
+    std::optional<::Operation> mOperation;
+    std::chrono::steady_clock::time_point mStartTime;
+};
+
+class MetricsInterceptorFactory final :
+    public grpc::experimental::ServerInterceptorFactoryInterface
+{
+public:
+    explicit MetricsInterceptorFactory(::Metrics &metrics) :
+        mMetrics(metrics)
+    {
+    }
+    grpc::experimental::Interceptor*
+        CreateServerInterceptor(grpc::experimental::ServerRpcInfo *info) override
+    {
+        return new ::MetricsInterceptor(info, mMetrics);
+    }
+private:
+    ::Metrics &mMetrics;
+};
+
+/// @result The exporter that pushes the metrics to an OTLP/HTTP collector.
+[[nodiscard]] std::unique_ptr<::MetricsExporter>
+    createOTLPMetricsExporter(const ::ProgramOptions &options)
+{
+    opentelemetry::exporter::otlp::OtlpHttpMetricExporterOptions
+        exporterOptions;
+    exporterOptions.url = options.otelHTTPMetricsURL;
+    auto result
+        = std::make_unique<::MetricsExporter>
+          (opentelemetry::exporter::otlp::OtlpHttpMetricExporterFactory::
+              Create(exporterOptions),
+           options.otelHTTPMetricsExportInterval,
+           options.otelHTTPMetricsExportTimeout);
+    spdlog::info("Exporting metrics to " + options.otelHTTPMetricsURL
+               + " every "
+               + std::to_string(options.otelHTTPMetricsExportInterval.count())
+               + " ms");
+    return result;
+}
+
+/// @brief Installs the tracer provider that batches spans to an OTLP/HTTP
+///        collector.  Sampling is decided when a trace starts so unsampled
+///        requests record nothing, and spans are dropped rather than
+///        blocking a request when the export queue is full.
+class TracesExporter
+{
+public:
+    explicit TracesExporter(const ::ProgramOptions &options)
+    {
+        opentelemetry::exporter::otlp::OtlpHttpExporterOptions exporterOptions;
+        exporterOptions.url = options.otelHTTPTracesURL;
+        auto exporter
+            = opentelemetry::exporter::otlp::OtlpHttpExporterFactory::
+              Create(exporterOptions);
+        opentelemetry::sdk::trace::BatchSpanProcessorOptions processorOptions;
+        processorOptions.max_queue_size
+            = options.otelHTTPTracesMaximumQueueSize;
+        processorOptions.schedule_delay_millis
+            = options.otelHTTPTracesScheduleDelay;
+        auto processor
+            = opentelemetry::sdk::trace::BatchSpanProcessorFactory::
+              Create(std::move(exporter), processorOptions);
+        std::unique_ptr<opentelemetry::sdk::trace::Sampler> sampler
+            = opentelemetry::sdk::trace::TraceIdRatioBasedSamplerFactory::
+              Create(options.otelHTTPTracesSamplingRatio);
+        if (options.otelHTTPTracesRespectParentSampling)
+        {
+            sampler
+                = opentelemetry::sdk::trace::ParentBasedSamplerFactory::
+                  Create(std::move(sampler));
+        }
+        auto resource
+            = opentelemetry::sdk::resource::Resource::Create(
+                 {{"service.name", options.applicationName},
+                  {"service.version", UMetadata::Version::getVersion()}});
+        mProvider
+            = opentelemetry::sdk::trace::TracerProviderFactory::
+              Create(std::move(processor), resource, std::move(sampler));
+        opentelemetry::trace::Provider::SetTracerProvider(mProvider);
+        tracingEnabled.store(true, std::memory_order_relaxed);
+        spdlog::info("Exporting traces to " + options.otelHTTPTracesURL
+                   + " with a sampling ratio of "
+                   + std::to_string(options.otelHTTPTracesSamplingRatio));
+    }
+    /// The provider flushes the queued spans when it is released.
+    ~TracesExporter()
+    {
+        tracingEnabled.store(false, std::memory_order_relaxed);
+        std::shared_ptr<opentelemetry::trace::TracerProvider> none;
+        opentelemetry::trace::Provider::SetTracerProvider(none);
+    }
+    TracesExporter(const TracesExporter &) = delete;
+    TracesExporter& operator=(const TracesExporter &) = delete;
+private:
+    std::shared_ptr<opentelemetry::trace::TracerProvider> mProvider;
 };
 
 std::string loadStringFromFile(const std::filesystem::path &path);
@@ -53,139 +666,1623 @@ void setVerbosityForSPDLOG(int verbosity);
 
 }
 
+/// @brief Normalizes the codes of an inventory item into its dot-separated
+///        lookup key, e.g., NET.STA, without allocating.  Whitespace is
+///        dropped and letters are upper-cased, as is done on insertion.
+/// @result The length of the key or 0 if a code is blank or the key does
+///         not fit in the buffer.
+template<size_t N>
+[[nodiscard]] size_t toKey(const std::initializer_list<std::string_view> codes,
+                           std::array<char, N> &key) noexcept
+{
+    size_t length{0};
+    auto append = [&](const std::string_view &input) -> size_t
+    {
+        size_t nCopied{0};
+        for (const auto c : input)
+        {
+            if (std::isspace(static_cast<unsigned char> (c))){continue;}
+            if (length == N){return 0;}
+            key[length] = static_cast<char>
+                          (std::toupper(static_cast<unsigned char> (c)));
+            length = length + 1;
+            nCopied = nCopied + 1;
+        }
+        return nCopied;
+    };
+    for (const auto &code : codes)
+    {
+        if (length > 0)
+        {
+            if (length == N){return 0;}
+            key[length] = '.';
+            length = length + 1;
+        }
+        if (append(code) == 0){return 0;}
+    }
+    return length;
+}
+
+/// @brief Normalizes a network and station name into the NET.STA lookup key.
+template<size_t N>
+[[nodiscard]] size_t toStationKey(const std::string_view &network,
+                                  const std::string_view &name,
+                                  std::array<char, N> &key) noexcept
+{
+    return ::toKey({network, name}, key);
+}
+
+/// @brief Normalizes a channel into the NET.STA.CHA.LOC lookup key.  A blank
+///        location code becomes "--", as is done when channels are inserted.
+template<size_t N>
+[[nodiscard]] size_t toChannelKey(const std::string_view &network,
+                                  const std::string_view &station,
+                                  const std::string_view &channel,
+                                  const std::string_view &locationCode,
+                                  std::array<char, N> &key) noexcept
+{
+    const bool blank
+        = std::ranges::all_of(locationCode,
+                              [](const char c)
+                              {
+                                  return std::isspace(
+                                     static_cast<unsigned char> (c)) != 0;
+                              });
+    return ::toKey({network, station, channel,
+                    blank ? std::string_view {"--"} : locationCode},
+                   key);
+}
+
+/// @brief Holds a snapshot of an active inventory.  The snapshot is rebuilt
+///        only when the database changes or when an epoch opens or closes
+///        and is published by atomically swapping a std::shared_ptr, RCU
+///        style, so that a rebuild never stalls in-flight readers.
+/// @tparam Snapshot  The immutable snapshot.  This must provide validUntil
+///                   and isCurrent(dataVersion, now).
+template<typename Snapshot>
+class SnapshotCache
+{
+public:
+    /// Versions start from the construction time in microseconds so a
+    /// client resuming across a server restart cannot match a stale one.
+    /// @param[in] name  Identifies the cache in the metrics.
+    SnapshotCache(const UMetadata::Database &database,
+                  ::Metrics &metrics,
+                  const std::string &name) :
+        mDatabase(database),
+        mMetrics(metrics),
+        mName(name),
+        mInitialVersion(
+           static_cast<uint64_t> (
+              std::chrono::duration_cast<std::chrono::microseconds>
+              (std::chrono::system_clock::now().time_since_epoch()).count()))
+    {
+        mMetrics.addCache(name, &mStatistics);
+    }
+    virtual ~SnapshotCache()
+    {
+        mMetrics.removeCache(&mStatistics);
+    }
+    SnapshotCache(const SnapshotCache &) = delete;
+    SnapshotCache& operator=(const SnapshotCache &) = delete;
+    /// @brief Rebuilds the snapshot if the database has changed or an
+    ///        epoch has opened or closed since it was built.
+    /// @result The current snapshot.
+    std::shared_ptr<const Snapshot> refresh()
+    {
+        // Readers that see a stale snapshot from here on ask again
+        mRefreshRequested.store(false, std::memory_order_relaxed);
+        const auto dataVersion = mDatabase.getDataVersion();
+        const auto now = getNow();
+        auto snapshot = mSnapshot.load();
+        if (snapshot && snapshot->isCurrent(dataVersion, now))
+        {
+            return snapshot;
+        }
+        std::shared_ptr<const Snapshot> previous{nullptr};
+        {
+            const std::lock_guard<std::mutex> lock(mRebuildMutex);
+            snapshot = mSnapshot.load();
+            if (snapshot && snapshot->isCurrent(dataVersion, now))
+            {
+                return snapshot;
+            }
+            previous = snapshot;
+            ::ScopedSpan span{*mTracer, mName + ".rebuild"};
+            try
+            {
+                snapshot = rebuild(dataVersion, now, previous);
+            }
+            catch (const std::exception &e)
+            {
+                span.setError(e.what());
+                throw;
+            }
+            mSnapshot.store(snapshot);
+            mGeneration.fetch_add(1, std::memory_order_release);
+        }
+        // Listeners may read the cache so they are told without the lock
+        published(previous, snapshot);
+        return snapshot;
+    }
+    /// @result The current snapshot.  In the common case this neither locks
+    ///         nor touches a shared reference count: each thread pins the
+    ///         latest snapshot and only reloads it when a new one is
+    ///         published.  Keeping the snapshot current is the job of the
+    ///         RefreshScheduler; if it has fallen behind an epoch boundary
+    ///         the published snapshot is served and the scheduler is woken.
+    ///         Only the first call, before any snapshot exists, builds one.
+    /// @note The reference is valid until this thread next calls peek() on
+    ///       this cache.
+    [[nodiscard]] const Snapshot &peek()
+    {
+        thread_local PinnedSnapshot pinned;
+        const auto generation = mGeneration.load(std::memory_order_acquire);
+        if (pinned.owner != this || pinned.generation != generation ||
+            !pinned.snapshot)
+        {
+            pin(pinned, mSnapshot.load(), generation);
+        }
+        if (!pinned.snapshot)
+        {
+            mStatistics.misses.fetch_add(1, std::memory_order_relaxed);
+            pin(pinned,
+                refresh(),
+                mGeneration.load(std::memory_order_acquire));
+        }
+        else if (getNow() >= pinned.snapshot->validUntil)
+        {
+            mStatistics.misses.fetch_add(1, std::memory_order_relaxed);
+            if (!requestRefresh())
+            {
+                pin(pinned,
+                    refresh(),
+                    mGeneration.load(std::memory_order_acquire));
+            }
+        }
+        else
+        {
+            mStatistics.hits.fetch_add(1, std::memory_order_relaxed);
+        }
+        return *pinned.snapshot;
+    }
+    /// @result A shared reference to the current snapshot for callers that
+    ///         must hold it across calls, e.g., a streaming RPC.  Like
+    ///         peek(), a stale snapshot is served while the scheduler
+    ///         refreshes it.
+    [[nodiscard]] std::shared_ptr<const Snapshot> get()
+    {
+        auto snapshot = mSnapshot.load();
+        if (!snapshot)
+        {
+            mStatistics.misses.fetch_add(1, std::memory_order_relaxed);
+            snapshot = refresh();
+        }
+        else if (getNow() >= snapshot->validUntil)
+        {
+            mStatistics.misses.fetch_add(1, std::memory_order_relaxed);
+            if (!requestRefresh()){snapshot = refresh();}
+        }
+        else
+        {
+            mStatistics.hits.fetch_add(1, std::memory_order_relaxed);
+        }
+        return snapshot;
+    }
+    /// @brief Sets the function that wakes the refresher of this cache.
+    ///        Until one is set, or once it is cleared, stale snapshots are
+    ///        refreshed by the reader.
+    void setRefreshRequester(std::function<void ()> requester)
+    {
+        const std::lock_guard<std::mutex> lock(mRequesterMutex);
+        mRequester = std::move(requester);
+    }
+    /// @result The time at which the current snapshot expires because a
+    ///         station or channel epoch opens or closes.
+    [[nodiscard]] std::chrono::seconds getValidUntil() const
+    {
+        auto snapshot = mSnapshot.load();
+        return snapshot ? snapshot->validUntil : std::chrono::seconds {0};
+    }
+protected:
+    /// @brief Builds the snapshot of the inventory active at the given time.
+    /// @param[in] previous  The snapshot being replaced.  This is NULL on
+    ///                      the first build.
+    [[nodiscard]] virtual std::shared_ptr<const Snapshot>
+        rebuild(int64_t dataVersion,
+                const std::chrono::seconds &now,
+                const std::shared_ptr<const Snapshot> &previous) = 0;
+    /// @brief Called after a snapshot is published.  This is not serialized
+    ///        with rebuilds so, when refreshes race, a newer snapshot may be
+    ///        published before this is called for an older one.
+    virtual void published(const std::shared_ptr<const Snapshot> &,
+                           const std::shared_ptr<const Snapshot> &)
+    {
+    }
+    [[nodiscard]] static std::chrono::seconds getNow()
+    {
+        return std::chrono::duration_cast<std::chrono::seconds>
+               (std::chrono::system_clock::now().time_since_epoch());
+    }
+    const UMetadata::Database &mDatabase;
+    ::Metrics &mMetrics;
+    std::string mName;
+    opentelemetry::nostd::shared_ptr<opentelemetry::trace::Tracer>
+        mTracer{::getTracer()};
+    std::mutex mRebuildMutex;
+    uint64_t mInitialVersion{0};
+private:
+    struct PinnedSnapshot
+    {
+        const SnapshotCache *owner{nullptr};
+        uint64_t generation{0};
+        std::shared_ptr<const Snapshot> snapshot{nullptr};
+    };
+    void pin(PinnedSnapshot &pinned,
+             std::shared_ptr<const Snapshot> snapshot,
+             const uint64_t generation)
+    {
+        pinned.owner = this;
+        pinned.generation = generation;
+        pinned.snapshot = std::move(snapshot);
+    }
+    /// @brief Asks the refresher, once per refresh, to rebuild the snapshot.
+    /// @result False if there is no refresher.
+    [[nodiscard]] bool requestRefresh()
+    {
+        const std::lock_guard<std::mutex> lock(mRequesterMutex);
+        if (!mRequester){return false;}
+        if (!mRefreshRequested.exchange(true, std::memory_order_relaxed))
+        {
+            mRequester();
+        }
+        return true;
+    }
+    std::atomic<std::shared_ptr<const Snapshot>> mSnapshot;
+    std::atomic<uint64_t> mGeneration{0};
+    ::CacheStatistics mStatistics;
+    std::mutex mRequesterMutex;
+    std::function<void ()> mRequester;
+    std::atomic<bool> mRefreshRequested{false};
+};
+
+/// @brief Holds the active stations snapshot.  A client that fell behind
+///        is brought forward from the recent snapshots.
+class ActiveStationsCache : public SnapshotCache<ActiveStationsSnapshot>
+{
+public:
+    ActiveStationsCache(const UMetadata::Database &database,
+                        ::Metrics &metrics) :
+        SnapshotCache<ActiveStationsSnapshot>(database,
+                                              metrics,
+                                              "active_stations")
+    {
+        mMetrics.addCache("active_station_projections",
+                          &mProjectionStatistics);
+    }
+    ~ActiveStationsCache() override
+    {
+        mMetrics.removeCache(&mProjectionStatistics);
+    }
+    /// @brief Sets the function called with each snapshot that has a new
+    ///        active set once it is published.
+    void setOnChange(
+        std::function<void (const std::shared_ptr<const ActiveStationsSnapshot> &)> onChange)
+    {
+        const std::lock_guard<std::mutex> lock(mOnChangeMutex);
+        mOnChange = std::move(onChange);
+    }
+    /// @brief Fills the update that brings a client from the given sequence
+    ///        number to the given snapshot.
+    /// @param[in] snapshot        The snapshot to bring the client to, e.g.,
+    ///                            the one just published.
+    /// @param[in] sequenceNumber  The last sequence number the client applied.
+    /// @param[out] update         The changes or, if the client cannot be
+    ///                            brought forward, a full snapshot.
+    /// @result False if the client is already at the snapshot.
+    [[nodiscard]] bool getUpdateSince(
+        const ActiveStationsSnapshot &snapshot,
+        const uint64_t sequenceNumber,
+        UMetadataAPI::V1::ActiveStationsUpdate *update) const
+    {
+        return mHistory.getUpdateSince(snapshot, sequenceNumber, update);
+    }
+    /// @result The serialized GetAllActiveStations response holding only the
+    ///         given columns of the snapshot's stations.  Each projection is
+    ///         serialized once per active set.  If the client already has
+    ///         the current version for these columns then this is a
+    ///         stationless "unchanged" response.
+    [[nodiscard]] std::shared_ptr<const std::string>
+        getProjection(const ActiveStationsSnapshot &snapshot,
+                      const uint32_t columns,
+                      const uint64_t clientVersion = 0)
+    {
+        const auto version
+            = ::toInventoryVersion(snapshot.sequenceNumber, columns);
+        if (clientVersion == version)
+        {
+            UMetadataAPI::V1::StationsResponse unchanged;
+            unchanged.set_version(version);
+            unchanged.set_unchanged(true);
+            return std::make_shared<const std::string>
+                   (unchanged.SerializeAsString());
+        }
+        if (columns == UMetadata::Database::StationColumn::AllStationColumns)
+        {
+            return snapshot.bytes;
+        }
+        {
+            const std::lock_guard<std::mutex> lock(mProjectionsMutex);
+            auto projection = mProjections.find(columns);
+            if (projection != mProjections.end() &&
+                projection->second.sequenceNumber == snapshot.sequenceNumber)
+            {
+                mProjectionStatistics.hits.fetch_add(1,
+                                                     std::memory_order_relaxed);
+                return projection->second.bytes;
+            }
+        }
+        mProjectionStatistics.misses.fetch_add(1, std::memory_order_relaxed);
+        // Concurrent misses may each build the projection; the copies are
+        // identical so the last one in wins
+        const ::ScopedSpan span{*mTracer, "active_stations.projection"};
+        const auto projectionTime = std::chrono::steady_clock::now();
+        google::protobuf::Arena arena;
+        auto response
+            = google::protobuf::Arena::Create
+              <UMetadataAPI::V1::StationsResponse> (&arena);
+        response->set_version(version);
+        response->mutable_stations()->Reserve(
+            static_cast<int> (snapshot.orderedStations.size()));
+        for (const auto &station : snapshot.orderedStations)
+        {
+            ::projectStation(*station, columns, response->add_stations());
+        }
+        auto bytes = std::make_shared<std::string> ();
+        const auto startTime = std::chrono::steady_clock::now();
+        {
+            const ::ScopedSpan serializeSpan{*mTracer, "serialize"};
+            if (!response->SerializeToString(bytes.get()))
+            {
+                throw std::runtime_error("Failed to serialize active stations");
+            }
+        }
+        mMetrics.recordSerialization("active_station_projection",
+                                     ::getMilliseconds(startTime));
+        auto &statistics = ::LatencyStatistics::getInstance();
+        statistics.record(::Operation::ActiveStationProjection,
+                          ::Stage::Serialization,
+                          std::chrono::steady_clock::now() - startTime);
+        statistics.record(::Operation::ActiveStationProjection,
+                          ::Stage::Total,
+                          std::chrono::steady_clock::now() - projectionTime);
+        {
+            const std::lock_guard<std::mutex> lock(mProjectionsMutex);
+            auto &projection = mProjections[columns];
+            if (projection.sequenceNumber <= snapshot.sequenceNumber)
+            {
+                projection = Projection{snapshot.sequenceNumber, bytes};
+            }
+        }
+        return bytes;
+    }
+private:
+    void published(
+        const std::shared_ptr<const ActiveStationsSnapshot> &previous,
+        const std::shared_ptr<const ActiveStationsSnapshot> &snapshot) override
+    {
+        if (previous && previous->sequenceNumber == snapshot->sequenceNumber)
+        {
+            return;
+        }
+        if (previous){mHistory.push(previous);}
+        std::function<void (const std::shared_ptr<const ActiveStationsSnapshot> &)>
+            onChange;
+        {
+            const std::lock_guard<std::mutex> lock(mOnChangeMutex);
+            onChange = mOnChange;
+        }
+        if (onChange){onChange(snapshot);}
+    }
+    [[nodiscard]] std::shared_ptr<const ActiveStationsSnapshot>
+        rebuild(const int64_t dataVersion,
+                const std::chrono::seconds &now,
+                const std::shared_ptr<const ActiveStationsSnapshot> &previous) override
+    {
+        const auto startTime = std::chrono::steady_clock::now();
+        google::protobuf::Arena arena;
+        auto response
+            = google::protobuf::Arena::Create
+              <UMetadataAPI::V1::StationsResponse> (&arena);
+        auto queryTime = std::chrono::steady_clock::now();
+        {
+            const ::ProfiledQuery profile{::Operation::ActiveStationsSnapshot};
+            mDatabase.appendStationsActiveAt(now, response);
+        }
+        mMetrics.recordQuery("active_stations_snapshot",
+                             ::getMilliseconds(queryTime));
+        auto snapshot = std::make_shared<ActiveStationsSnapshot> ();
+        snapshot->stations.reserve(
+            static_cast<size_t> (response->stations_size()));
+        snapshot->orderedStations.reserve(
+            static_cast<size_t> (response->stations_size()));
+        for (const auto &station : response->stations())
+        {
+            // Rows were normalized on insertion
+            auto [entry, inserted]
+                = snapshot->stations.emplace(station.network() + "."
+                                           + station.name(),
+                                             station);
+            if (inserted){snapshot->orderedStations.push_back(&entry->second);}
+        }
+        snapshot->dataVersion = dataVersion;
+        snapshot->time = now;
+        snapshot->validUntil
+            = mDatabase.getNextEpochBoundary(now).value_or(
+                 std::chrono::seconds::max());
+        // A new sequence number is issued only if the active set changed
+        if (previous)
+        {
+            auto delta
+                = std::make_shared<UMetadataAPI::V1::ActiveStationsUpdate> ();
+            ::appendDifferences(*previous, *snapshot, delta.get());
+            if (delta->added().empty() && delta->modified().empty() &&
+                delta->removed().empty())
+            {
+                snapshot->sequenceNumber = previous->sequenceNumber;
+                snapshot->delta = previous->delta;
+            }
+            else
+            {
+                // The delta is keyed on the sequence number it applies to
+                delta->set_sequence_number(previous->sequenceNumber);
+                snapshot->sequenceNumber = previous->sequenceNumber + 1;
+                snapshot->delta = std::move(delta);
+            }
+        }
+        else
+        {
+            snapshot->sequenceNumber = mInitialVersion;
+        }
+        // The sequence number, with the columns, is the inventory version
+        // clients send back to skip unchanged downloads
+        if (previous && previous->sequenceNumber == snapshot->sequenceNumber)
+        {
+            snapshot->bytes = previous->bytes;
+        }
+        else
+        {
+            response->set_version(
+                ::toInventoryVersion(
+                   snapshot->sequenceNumber,
+                   UMetadata::Database::StationColumn::AllStationColumns));
+            auto bytes = std::make_shared<std::string> ();
+            const auto serializationTime = std::chrono::steady_clock::now();
+            {
+                const ::ScopedSpan serializeSpan{*mTracer, "serialize"};
+                if (!response->SerializeToString(bytes.get()))
+                {
+                    throw std::runtime_error("Failed to serialize active stations");
+                }
+            }
+            mMetrics.recordSerialization("active_stations_snapshot",
+                                         ::getMilliseconds(serializationTime));
+            ::LatencyStatistics::getInstance().record(
+                ::Operation::ActiveStationsSnapshot,
+                ::Stage::Serialization,
+                std::chrono::steady_clock::now() - serializationTime);
+            snapshot->bytes = std::move(bytes);
+        }
+        ::LatencyStatistics::getInstance().record(
+            ::Operation::ActiveStationsSnapshot,
+            ::Stage::Total,
+            std::chrono::steady_clock::now() - startTime);
+        const std::chrono::duration<double> duration
+            = std::chrono::steady_clock::now() - startTime;
+        spdlog::info("Rebuilt active stations snapshot with "
+                   + std::to_string(response->stations_size())
+                   + " stations (" + std::to_string(snapshot->bytes->size())
+                   + " bytes) in " + std::to_string(duration.count()) + " s");
+        return snapshot;
+    }
+    /// @brief A serialized projection of an active set.
+    struct Projection
+    {
+        uint64_t sequenceNumber{0};
+        std::shared_ptr<const std::string> bytes{nullptr};
+    };
+    ::CacheStatistics mProjectionStatistics;
+    std::mutex mProjectionsMutex;
+    std::unordered_map<uint32_t, Projection> mProjections;
+    ::ActiveStationsHistory mHistory;
+    std::mutex mOnChangeMutex;
+    std::function<void (const std::shared_ptr<const ActiveStationsSnapshot> &)>
+        mOnChange;
+};
+
+/// @brief Holds the active channels snapshot.
+class ActiveChannelsCache : public SnapshotCache<ActiveChannelsSnapshot>
+{
+public:
+    ActiveChannelsCache(const UMetadata::Database &database,
+                        ::Metrics &metrics) :
+        SnapshotCache<ActiveChannelsSnapshot>(database,
+                                              metrics,
+                                              "active_channels")
+    {
+        mMetrics.addCache("active_channel_projections",
+                          &mProjectionStatistics);
+    }
+    ~ActiveChannelsCache() override
+    {
+        mMetrics.removeCache(&mProjectionStatistics);
+    }
+    /// @result The serialized GetAllActiveChannels response holding only the
+    ///         given columns of the snapshot's channels.  Each projection is
+    ///         serialized once per active set.  If the client already has
+    ///         the current version for these columns then this is a
+    ///         channelless "unchanged" response.
+    [[nodiscard]] std::shared_ptr<const std::string>
+        getProjection(const ActiveChannelsSnapshot &snapshot,
+                      const uint32_t columns,
+                      const uint64_t clientVersion = 0)
+    {
+        auto unchanged
+            = ::toUnchangedChannelsResponse(snapshot, columns, clientVersion);
+        if (unchanged){return unchanged;}
+        if (columns == ::ChannelColumn::AllChannelColumns)
+        {
+            return snapshot.bytes;
+        }
+        {
+            const std::lock_guard<std::mutex> lock(mProjectionsMutex);
+            auto projection = mProjections.find(columns);
+            if (projection != mProjections.end() &&
+                projection->second.version == snapshot.version)
+            {
+                mProjectionStatistics.hits.fetch_add(1,
+                                                     std::memory_order_relaxed);
+                return projection->second.bytes;
+            }
+        }
+        mProjectionStatistics.misses.fetch_add(1, std::memory_order_relaxed);
+        // Concurrent misses may each build the projection; the copies are
+        // identical so the last one in wins
+        const ::ScopedSpan span{*mTracer, "active_channels.projection"};
+        const auto projectionTime = std::chrono::steady_clock::now();
+        google::protobuf::Arena arena;
+        auto response
+            = google::protobuf::Arena::Create
+              <UMetadataAPI::V1::ChannelsResponse> (&arena);
+        ::projectChannels(snapshot, columns, response);
+        auto bytes = std::make_shared<std::string> ();
+        const auto startTime = std::chrono::steady_clock::now();
+        {
+            const ::ScopedSpan serializeSpan{*mTracer, "serialize"};
+            if (!response->SerializeToString(bytes.get()))
+            {
+                throw std::runtime_error("Failed to serialize active channels");
+            }
+        }
+        mMetrics.recordSerialization("active_channel_projection",
+                                     ::getMilliseconds(startTime));
+        auto &statistics = ::LatencyStatistics::getInstance();
+        statistics.record(::Operation::ActiveChannelProjection,
+                          ::Stage::Serialization,
+                          std::chrono::steady_clock::now() - startTime);
+        statistics.record(::Operation::ActiveChannelProjection,
+                          ::Stage::Total,
+                          std::chrono::steady_clock::now() - projectionTime);
+        {
+            const std::lock_guard<std::mutex> lock(mProjectionsMutex);
+            auto &projection = mProjections[columns];
+            if (projection.version <= snapshot.version)
+            {
+                projection = Projection{snapshot.version, bytes};
+            }
+        }
+        return bytes;
+    }
+private:
+    [[nodiscard]] std::shared_ptr<const ActiveChannelsSnapshot>
+        rebuild(const int64_t dataVersion,
+                const std::chrono::seconds &now,
+                const std::shared_ptr<const ActiveChannelsSnapshot> &previous) override
+    {
+        const auto startTime = std::chrono::steady_clock::now();
+        google::protobuf::Arena arena;
+        auto response
+            = google::protobuf::Arena::Create
+              <UMetadataAPI::V1::ChannelsResponse> (&arena);
+        auto queryTime = std::chrono::steady_clock::now();
+        {
+            const ::ProfiledQuery profile{::Operation::ActiveChannelsSnapshot};
+            mDatabase.appendChannelsActiveAt(now, response);
+        }
+        mMetrics.recordQuery("active_channels_snapshot",
+                             ::getMilliseconds(queryTime));
+        auto snapshot = std::make_shared<ActiveChannelsSnapshot> ();
+        snapshot->channels.reserve(
+            static_cast<size_t> (response->channels_size()));
+        snapshot->orderedChannels.reserve(snapshot->channels.size());
+        for (const auto &channel : response->channels())
+        {
+            // Rows were normalized on insertion
+            auto [entry, inserted]
+                = snapshot->channels.emplace(channel.network() + "."
+                                           + channel.station() + "."
+                                           + channel.name() + "."
+                                           + channel.location_code(),
+                                             channel);
+            if (inserted)
+            {
+                snapshot->orderedChannels.push_back(&entry->second);
+            }
+        }
+        snapshot->dataVersion = dataVersion;
+        snapshot->validUntil
+            = mDatabase.getNextEpochBoundary(now).value_or(
+                 std::chrono::seconds::max());
+        // A new version is issued only if the active set changed
+        const bool changed{!previous ||
+                           !::haveSameChannels(*previous, *snapshot)};
+        if (!changed)
+        {
+            snapshot->version = previous->version;
+            snapshot->bytes = previous->bytes;
+        }
+        else
+        {
+            snapshot->version
+                = previous ? previous->version + 1 : mInitialVersion;
+            response->set_version(
+                ::toChannelInventoryVersion(
+                    snapshot->version, ::ChannelColumn::AllChannelColumns));
+            auto bytes = std::make_shared<std::string> ();
+            const auto serializationTime = std::chrono::steady_clock::now();
+            {
+                const ::ScopedSpan serializeSpan{*mTracer, "serialize"};
+                if (!response->SerializeToString(bytes.get()))
+                {
+                    throw std::runtime_error("Failed to serialize active channels");
+                }
+            }
+            mMetrics.recordSerialization("active_channels_snapshot",
+                                         ::getMilliseconds(serializationTime));
+            ::LatencyStatistics::getInstance().record(
+                ::Operation::ActiveChannelsSnapshot,
+                ::Stage::Serialization,
+                std::chrono::steady_clock::now() - serializationTime);
+            snapshot->bytes = std::move(bytes);
+        }
+        ::LatencyStatistics::getInstance().record(
+            ::Operation::ActiveChannelsSnapshot,
+            ::Stage::Total,
+            std::chrono::steady_clock::now() - startTime);
+        const std::chrono::duration<double> duration
+            = std::chrono::steady_clock::now() - startTime;
+        spdlog::info("Rebuilt active channels snapshot with "
+                   + std::to_string(response->channels_size())
+                   + " channels (" + std::to_string(snapshot->bytes->size())
+                   + " bytes) in " + std::to_string(duration.count()) + " s");
+        return snapshot;
+    }
+    struct Projection
+    {
+        uint64_t version{0};
+        std::shared_ptr<const std::string> bytes{nullptr};
+    };
+    ::CacheStatistics mProjectionStatistics;
+    std::mutex mProjectionsMutex;
+    std::unordered_map<uint32_t, Projection> mProjections;
+};
+
+/// @brief Keeps a snapshot cache current in the background.  The database
+///        is polled for changes with PRAGMA data_version, which is cheap,
+///        and the snapshot is refreshed at the instant the next station or
+///        channel epoch opens or closes.  A reader that finds the snapshot
+///        past its boundary, e.g., because a rebuild ran long, wakes the
+///        scheduler rather than refreshing it.  Readers therefore never pay
+///        for a refresh and the cache needs no time-to-live.
+template<typename Cache>
+class RefreshScheduler
+{
+public:
+    RefreshScheduler(Cache &cache,
+                     const std::chrono::milliseconds &pollInterval,
+                     std::string name) :
+        mCache(cache),
+        mPollInterval(pollInterval),
+        mName(std::move(name))
+    {
+        mThread = std::thread(&RefreshScheduler::run, this);
+        mCache.setRefreshRequester([this]() {requestRefresh();});
+    }
+    ~RefreshScheduler()
+    {
+        mCache.setRefreshRequester(nullptr);
+        {
+            const std::lock_guard<std::mutex> lock(mMutex);
+            mKeepRunning = false;
+        }
+        mConditionVariable.notify_all();
+        if (mThread.joinable()){mThread.join();}
+    }
+    RefreshScheduler(const RefreshScheduler &) = delete;
+    RefreshScheduler& operator=(const RefreshScheduler &) = delete;
+    /// @brief Wakes the scheduler to refresh the cache now.
+    void requestRefresh()
+    {
+        {
+            const std::lock_guard<std::mutex> lock(mMutex);
+            mRefreshRequested = true;
+        }
+        mConditionVariable.notify_one();
+    }
+private:
+    void run()
+    {
+        spdlog::info("Refresh scheduler polling for " + mName
+                   + " changes every "
+                   + std::to_string(mPollInterval.count()) + " ms");
+        while (true)
+        {
+            try
+            {
+                mCache.refresh();
+            }
+            catch (const std::exception &e)
+            {
+                spdlog::warn("Failed to refresh " + mName + " because "
+                           + std::string {e.what()});
+            }
+            // Wake for the next poll or the next epoch boundary
+            auto wait = mPollInterval;
+            const auto now = std::chrono::system_clock::now();
+            const auto validUntil = mCache.getValidUntil();
+            if (validUntil < std::chrono::duration_cast<std::chrono::seconds>
+                                (std::chrono::system_clock::duration::max()))
+            {
+                const std::chrono::system_clock::time_point boundary{
+                    validUntil};
+                const auto untilBoundary
+                    = std::chrono::ceil<std::chrono::milliseconds>
+                      (boundary - now);
+                wait = std::clamp(untilBoundary,
+                                  std::chrono::milliseconds {0},
+                                  mPollInterval);
+            }
+            std::unique_lock<std::mutex> lock(mMutex);
+            mConditionVariable.wait_for(lock, wait,
+                                        [this]()
+                                        {
+                                            return !mKeepRunning ||
+                                                   mRefreshRequested;
+                                        });
+            if (!mKeepRunning){break;}
+            mRefreshRequested = false;
+        }
+    }
+    Cache &mCache;
+    std::chrono::milliseconds mPollInterval;
+    std::string mName;
+    std::mutex mMutex;
+    std::condition_variable mConditionVariable;
+    std::thread mThread;
+    bool mKeepRunning{true};
+    bool mRefreshRequested{false};
+};
+
+/// @brief Streams the active stations in pages.  The reactor pins one
+///        snapshot so that the pages are consistent and, since the snapshot
+///        is shared, the only per-call memory is the page being written.
+///        The call's span is ended, and its admission given back, when the
+///        stream is done.
+class ActiveStationsPagesReactor final :
+    public grpc::ServerWriteReactor<UMetadataAPI::V1::StationsResponse>
+{
+public:
+    /// Pages are also cut at this many bytes so that a page never
+    /// approaches gRPC's default 4 MB message limit.
+    static constexpr size_t MAXIMUM_PAGE_BYTES{1024*1024};
+    static constexpr int DEFAULT_PAGE_SIZE{512};
+    static constexpr int MAXIMUM_PAGE_SIZE{8192};
+    ActiveStationsPagesReactor(
+        std::shared_ptr<const ActiveStationsSnapshot> snapshot,
+        const int pageSize,
+        const uint32_t columns,
+        std::shared_ptr<const ::AdmissionController::Admission> admission,
+        opentelemetry::nostd::shared_ptr<opentelemetry::trace::Span> span) :
+        mSnapshot(std::move(snapshot)),
+        mAdmission(std::move(admission)),
+        mSpan(std::move(span)),
+        mColumns(columns),
+        mPageSize(pageSize > 0 ?
+                  std::min(pageSize, MAXIMUM_PAGE_SIZE) : DEFAULT_PAGE_SIZE)
+    {
+        writeNextPage();
+    }
+    void OnWriteDone(const bool ok) override
+    {
+        if (!ok)
+        {
+            finish(grpc::Status{grpc::StatusCode::UNAVAILABLE,
+                                "Failed to write page"});
+            return;
+        }
+        writeNextPage();
+    }
+    void OnDone() override
+    {
+        mSpan->SetAttribute("pages", static_cast<int64_t> (mPages));
+        mSpan->End();
+        delete this;
+    }
+private:
+    void finish(const grpc::Status &status)
+    {
+        ::setSpanStatus(*mSpan, status);
+        Finish(status);
+    }
+    void writeNextPage()
+    {
+        const auto &stations = mSnapshot->orderedStations;
+        // An empty inventory is still answered with one (empty) page
+        if (mIndex >= stations.size() && mWrittenPage)
+        {
+            finish(grpc::Status::OK);
+            return;
+        }
+        mPage.Clear();
+        mPage.set_version(
+            ::toInventoryVersion(mSnapshot->sequenceNumber, mColumns));
+        size_t pageBytes{0};
+        while (mIndex < stations.size() && mPage.stations_size() < mPageSize)
+        {
+            auto station = mPage.add_stations();
+            ::projectStation(*stations[mIndex], mColumns, station);
+            const auto stationBytes = station->ByteSizeLong();
+            if (mPage.stations_size() > 1 &&
+                pageBytes + stationBytes > MAXIMUM_PAGE_BYTES)
+            {
+                mPage.mutable_stations()->RemoveLast();
+                break;
+            }
+            pageBytes = pageBytes + stationBytes;
+            mIndex = mIndex + 1;
+        }
+        mWrittenPage = true;
+        mPages = mPages + 1;
+        StartWrite(&mPage);
+    }
+    std::shared_ptr<const ActiveStationsSnapshot> mSnapshot;
+    std::shared_ptr<const ::AdmissionController::Admission> mAdmission;
+    opentelemetry::nostd::shared_ptr<opentelemetry::trace::Span> mSpan;
+    UMetadataAPI::V1::StationsResponse mPage;
+    size_t mIndex{0};
+    size_t mPages{0};
+    uint32_t mColumns{UMetadata::Database::StationColumn::AllStationColumns};
+    int mPageSize{DEFAULT_PAGE_SIZE};
+    bool mWrittenPage{false};
+};
+
+class WatchActiveStationsReactor;
+
+/// @brief Tracks the open WatchActiveStations streams so that they can be
+///        told when the active set changes.
+class ActiveStationsWatchers
+{
+public:
+    void add(const std::shared_ptr<WatchActiveStationsReactor> &reactor)
+    {
+        const std::lock_guard<std::mutex> lock(mMutex);
+        mReactors.insert_or_assign(reactor.get(), reactor);
+    }
+    void remove(const WatchActiveStationsReactor *reactor)
+    {
+        const std::lock_guard<std::mutex> lock(mMutex);
+        mReactors.erase(reactor);
+    }
+    /// The reactors are notified without the lock, since a write may
+    /// complete inline, and each is kept alive until it has been notified.
+    void notifyAll(const std::shared_ptr<const ActiveStationsSnapshot> &snapshot);
+    [[nodiscard]] size_t size() const
+    {
+        const std::lock_guard<std::mutex> lock(mMutex);
+        return mReactors.size();
+    }
+private:
+    mutable std::mutex mMutex;
+    std::map<const WatchActiveStationsReactor *,
+             std::weak_ptr<WatchActiveStationsReactor>> mReactors;
+};
+
+/// @brief Streams changes to the active set to one client.  The first write
+///        is a full snapshot, unless the client is resuming from a sequence
+///        number the server still remembers, and every write after that is
+///        a delta.  At most one write is in flight; changes that arrive
+///        while a write is outstanding are coalesced into the next one.
+///        The call's span lasts as long as the stream and records each
+///        update written.  Since the first update may copy the entire
+///        active set, the stream holds an inventory admission until it is
+///        done.  The reactor owns itself until gRPC is done with
+///        it so that a notification in progress never sees it deleted.
+class WatchActiveStationsReactor final :
+    public grpc::ServerWriteReactor<UMetadataAPI::V1::ActiveStationsUpdate>
+{
+public:
+    /// @brief Registers a stream with the watchers and writes its first
+    ///        update.
+    /// @result The reactor to hand to gRPC.
+    [[nodiscard]] static WatchActiveStationsReactor *
+        start(::ActiveStationsCache &cache,
+              ::ActiveStationsWatchers &watchers,
+              const uint64_t sequenceNumber,
+              std::shared_ptr<const ::AdmissionController::Admission> admission,
+              opentelemetry::nostd::shared_ptr
+                 <opentelemetry::trace::Span> span)
+    {
+        std::shared_ptr<WatchActiveStationsReactor> reactor{
+            new WatchActiveStationsReactor(cache,
+                                           watchers,
+                                           sequenceNumber,
+                                           std::move(admission),
+                                           std::move(span))};
+        reactor->mSelf = reactor;
+        watchers.add(reactor);
+        reactor->notify();
+        return reactor.get();
+    }
+    /// @brief Writes the changes up to the given snapshot unless a write is
+    ///        outstanding.  A snapshot older than the one last written is
+    ///        ignored.
+    void notify(const std::shared_ptr<const ActiveStationsSnapshot> &snapshot)
+    {
+        bool write{false};
+        {
+            const std::lock_guard<std::mutex> lock(mMutex);
+            if (mWriting || mFinished){return;}
+            // Snapshots from racing refreshes can arrive out of order
+            if (snapshot->sequenceNumber < mSnapshotSequenceNumber){return;}
+            if (!mCache.getUpdateSince(*snapshot, mSequenceNumber, &mUpdate))
+            {
+                return;
+            }
+            mSequenceNumber = mUpdate.sequence_number();
+            mSnapshotSequenceNumber = snapshot->sequenceNumber;
+            mWriting = true;
+            write = true;
+        }
+        // gRPC may run reactions inline so do not hold the lock
+        if (write)
+        {
+            mSpan->AddEvent("update",
+                            {{"sequence_number",
+                              static_cast<int64_t> (mSequenceNumber)}});
+            StartWrite(&mUpdate);
+        }
+    }
+    /// @brief Writes the changes up to the current snapshot.
+    void notify()
+    {
+        std::shared_ptr<const ActiveStationsSnapshot> snapshot{nullptr};
+        try
+        {
+            snapshot = mCache.get();
+        }
+        catch (const std::exception &e)
+        {
+            spdlog::warn("Failed to create active stations update because "
+                       + std::string {e.what()});
+            finish(grpc::Status{grpc::StatusCode::UNKNOWN,
+                                "Server-side query failed"});
+            return;
+        }
+        notify(snapshot);
+    }
+    void OnWriteDone(const bool ok) override
+    {
+        {
+            const std::lock_guard<std::mutex> lock(mMutex);
+            mWriting = false;
+        }
+        if (!ok)
+        {
+            finish(grpc::Status{grpc::StatusCode::UNAVAILABLE,
+                                "Failed to write update"});
+            return;
+        }
+        // Catch up on anything that changed during the write
+        notify();
+    }
+    void OnCancel() override
+    {
+        finish(grpc::Status::CANCELLED);
+    }
+    void OnDone() override
+    {
+        mWatchers.remove(this);
+        mAdmission.reset();
+        mSpan->End();
+        // This may delete the reactor so it must come last
+        auto self = std::move(mSelf);
+    }
+private:
+    WatchActiveStationsReactor(::ActiveStationsCache &cache,
+                               ::ActiveStationsWatchers &watchers,
+                               const uint64_t sequenceNumber,
+                               std::shared_ptr
+                                  <const ::AdmissionController::Admission>
+                                  admission,
+                               opentelemetry::nostd::shared_ptr
+                                  <opentelemetry::trace::Span> span) :
+        mCache(cache),
+        mWatchers(watchers),
+        mAdmission(std::move(admission)),
+        mSpan(std::move(span)),
+        mSequenceNumber(sequenceNumber)
+    {
+    }
+    /// @brief Finishes the stream once.
+    void finish(const grpc::Status &status)
+    {
+        {
+            const std::lock_guard<std::mutex> lock(mMutex);
+            if (mFinished){return;}
+            mFinished = true;
+        }
+        ::setSpanStatus(*mSpan, status);
+        Finish(status);
+    }
+    ::ActiveStationsCache &mCache;
+    ::ActiveStationsWatchers &mWatchers;
+    std::shared_ptr<WatchActiveStationsReactor> mSelf{nullptr};
+    std::shared_ptr<const ::AdmissionController::Admission> mAdmission;
+    opentelemetry::nostd::shared_ptr<opentelemetry::trace::Span> mSpan;
+    UMetadataAPI::V1::ActiveStationsUpdate mUpdate;
+    std::mutex mMutex;
+    uint64_t mSequenceNumber{0};
+    uint64_t mSnapshotSequenceNumber{0};
+    bool mWriting{false};
+    bool mFinished{false};
+};
+
+void ActiveStationsWatchers::notifyAll(
+    const std::shared_ptr<const ActiveStationsSnapshot> &snapshot)
+{
+    std::vector<std::shared_ptr<WatchActiveStationsReactor>> reactors;
+    {
+        const std::lock_guard<std::mutex> lock(mMutex);
+        reactors.reserve(mReactors.size());
+        for (const auto &reactor : mReactors)
+        {
+            if (auto pinned = reactor.second.lock())
+            {
+                reactors.push_back(std::move(pinned));
+            }
+        }
+    }
+    for (const auto &reactor : reactors){reactor->notify(snapshot);}
+}
+
 class StationInformationServiceImpl final :
-    public UMetadataAPI::V1::StationInformation::CallbackService
+    public UMetadataAPI::V1::StationInformation::
+           WithRawCallbackMethod_GetAllActiveStations<
+              UMetadataAPI::V1::StationInformation::CallbackService>
 {
 public:
-    explicit StationInformationServiceImpl(
+    StationInformationServiceImpl(
         const ::ProgramOptions &options,
+        const UMetadata::Database &database,
+        ::Metrics &metrics,
+        ::DatabaseExecutor &executor,
+        ::AdmissionController &admission,
         std::shared_ptr<spdlog::logger> logger) :
-        mLogger(std::move(logger))
+        mLogger(std::move(logger)),
+        mDatabase(database),
+        mMetrics(metrics),
+        mExecutor(executor),
+        mAdmission(admission)
+    {
+        mActiveStationsCache
+            = std::make_unique<::ActiveStationsCache> (mDatabase, mMetrics);
+        mActiveStationsCache->setOnChange(
+            [this](const std::shared_ptr<const ActiveStationsSnapshot> &snapshot)
+            {
+                mWatchers.notifyAll(snapshot);
+            });
+        mRefreshScheduler
+            = std::make_unique<::RefreshScheduler<::ActiveStationsCache>>
+              (*mActiveStationsCache,
+               options.changePollInterval,
+               "active stations");
+        SetMessageAllocatorFor_GetActiveStations(&mBatchAllocator);
+        SetMessageAllocatorFor_GetActiveStationsInBoundingBox(
+            &mBoundingBoxAllocator);
+        SetMessageAllocatorFor_GetActiveStationsWithinRadius(
+            &mRadiusAllocator);
+    }
+    /// Served from pre-serialized bytes so the response is neither rebuilt
+    /// nor re-encoded unless the active set has changed.
+    grpc::ServerUnaryReactor*
+        GetAllActiveStations(grpc::CallbackServerContext *context,
+                             const grpc::ByteBuffer *request,
+                             grpc::ByteBuffer *response) override
+    {
+        ::ScopedSpan span{::startServerSpan(*mTracer, context,
+            "UMetadataAPI.V1.StationInformation/GetAllActiveStations")};
+        auto admission = mAdmission.admit(::Operation::GetAllActiveStations);
+        if (!admission)
+        {
+            return ::finish(context, span,
+                            ::AdmissionController::getRejectedStatus(
+                               ::Operation::GetAllActiveStations));
+        }
+        grpc::Status status{grpc::Status::OK};
+        UMetadataAPI::V1::AllActiveStationsRequest parsedRequest;
+        if (!::parseRawRequest(*request, &parsedRequest))
+        {
+            return ::finish(admission, span,
+                            grpc::Status{grpc::StatusCode::INVALID_ARGUMENT,
+                                         "Could not parse request"});
+        }
+        if (mLogger && !parsedRequest.identifier().empty())
+        {
+            SPDLOG_LOGGER_DEBUG(mLogger,
+                "Received GetAllActiveStations request from {}",
+                parsedRequest.identifier());
+        }
+        uint32_t columns{UMetadata::Database::StationColumn::AllStationColumns};
+        try
+        {
+            columns = ::toStationColumns(parsedRequest.field_mask());
+        }
+        catch (const std::invalid_argument &e)
+        {
+            return ::finish(admission, span,
+                            grpc::Status{grpc::StatusCode::INVALID_ARGUMENT,
+                                         std::string {e.what()}});
+        }
+        try
+        {
+            const auto &snapshot = mActiveStationsCache->peek();
+            ::setRawResponse(
+                mActiveStationsCache->getProjection(snapshot,
+                                                    columns,
+                                                    parsedRequest.version()),
+                response);
+            if (parsedRequest.version()
+                != ::toInventoryVersion(snapshot.sequenceNumber, columns))
+            {
+                mMetrics.addRows("GetAllActiveStations",
+                                 snapshot.orderedStations.size());
+            }
+        }
+        catch (const std::exception &e)
+        {
+            if (mLogger)
+            {
+                SPDLOG_LOGGER_ERROR(mLogger,
+                    "GetAllActiveStations request query failed with {}",
+                    std::string {e.what()});
+            }
+            status = grpc::Status{grpc::StatusCode::UNKNOWN,
+                                  "Server-side query failed"};
+        }
+        return ::finish(admission, span, status);
+    }
+    grpc::ServerWriteReactor<UMetadataAPI::V1::StationsResponse>*
+        GetAllActiveStationsPaged(
+            grpc::CallbackServerContext *context,
+            const UMetadataAPI::V1::ActiveStationsPagesRequest *request) override
     {
-        constexpr bool openReadOnly{true};
+        ::ScopedSpan span{::startServerSpan(*mTracer, context,
+            "UMetadataAPI.V1.StationInformation/GetAllActiveStationsPaged")};
+        auto admission
+            = mAdmission.admit(::Operation::GetAllActiveStationsPaged);
+        if (!admission)
+        {
+            const auto status
+                = ::AdmissionController::getRejectedStatus(
+                     ::Operation::GetAllActiveStationsPaged);
+            span.setStatus(status);
+            return new ::FailedWriteReactor<UMetadataAPI::V1::StationsResponse>
+                       (status);
+        }
+        if (mLogger && !request->identifier().empty())
+        {
+            SPDLOG_LOGGER_DEBUG(mLogger,
+                "Received GetAllActiveStationsPaged request from {}",
+                request->identifier());
+        }
+        uint32_t columns{UMetadata::Database::StationColumn::AllStationColumns};
+        try
+        {
+            columns = ::toStationColumns(request->field_mask());
+        }
+        catch (const std::invalid_argument &e)
+        {
+            const grpc::Status status{grpc::StatusCode::INVALID_ARGUMENT,
+                                      std::string {e.what()}};
+            span.setStatus(status);
+            return new ::FailedWriteReactor<UMetadataAPI::V1::StationsResponse>
+                       (status);
+        }
+        std::shared_ptr<const ActiveStationsSnapshot> snapshot{nullptr};
         try
         {
-            mDatabase
-                = std::make_unique<UMetadata::Database>
-                  (options.sqlite3Database, openReadOnly); 
+            snapshot = mActiveStationsCache->get();
         }
         catch (const std::exception &e)
         {
-            spdlog::critical("Failed to open read-only connection because "
-                           + std::string {e.what()});
-            throw std::runtime_error("Failed to open database connection");
+            if (mLogger)
+            {
+                SPDLOG_LOGGER_ERROR(mLogger,
+                    "GetAllActiveStationsPaged request query failed with {}",
+                    std::string {e.what()});
+            }
+            const grpc::Status status{grpc::StatusCode::UNKNOWN,
+                                      "Server-side query failed"};
+            span.setStatus(status);
+            return new ::FailedWriteReactor<UMetadataAPI::V1::StationsResponse>
+                       (status);
         }
+        mMetrics.addRows("GetAllActiveStationsPaged",
+                         snapshot->orderedStations.size());
+        return new ::ActiveStationsPagesReactor(std::move(snapshot),
+                                                request->page_size(),
+                                                columns,
+                                                std::move(admission),
+                                                span.release());
     }
     grpc::ServerUnaryReactor*
-        GetAllActiveStations(grpc::CallbackServerContext *context,
-                             const UMetadataAPI::V1::AllActiveStationsRequest *request,
-                             UMetadataAPI::V1::StationsResponse *response) override
-    {
-        class Reactor : public grpc::ServerUnaryReactor 
+        GetActiveStation(grpc::CallbackServerContext *context,
+                         const UMetadataAPI::V1::ActiveStationRequest *request,
+                         UMetadataAPI::V1::Station *response) override
+    {   
+        ::ScopedSpan span{::startServerSpan(*mTracer, context,
+            "UMetadataAPI.V1.StationInformation/GetActiveStation")};
+        auto admission = mAdmission.admit(::Operation::GetActiveStation);
+        if (!admission)
+        {
+            return ::finish(context, span,
+                            ::AdmissionController::getRejectedStatus(
+                               ::Operation::GetActiveStation));
+        }
+        grpc::Status status{grpc::Status::OK};
+        uint32_t columns{UMetadata::Database::StationColumn::AllStationColumns};
+        try
+        {
+            columns = ::toStationColumns(request->field_mask());
+        }
+        catch (const std::invalid_argument &e)
+        {
+            return ::finish(admission, span,
+                            grpc::Status{grpc::StatusCode::INVALID_ARGUMENT,
+                                         std::string {e.what()}});
+        }
+        // Look the station up in the in-memory index
+        std::array<char, 64> key;
+        const auto keyLength
+            = ::toStationKey(request->network(), request->name(), key);
+        if (keyLength > 0)
         {
-        public:
-            Reactor(const UMetadata::Database &mDatabaseHandle,
-                    const UMetadataAPI::V1::AllActiveStationsRequest &request,
-                    UMetadataAPI::V1::StationsResponse *response,
-                    std::shared_ptr<spdlog::logger> logger) : 
-                mLogger(std::move(logger))
+            try
             {
-                if (mLogger && !request.identifier().empty())
-                {
-                    SPDLOG_LOGGER_DEBUG(mLogger,
-                       "Received GetAllActiveStations request from {}",
-                       request.identifier());
-                } 
-                const auto startTime
-                   = std::chrono::duration_cast<std::chrono::nanoseconds>
-                     ((std::chrono::high_resolution_clock::now()).time_since_epoch());
-                try
+                const auto &snapshot = mActiveStationsCache->peek();
+                auto station
+                    = snapshot.stations.find(
+                         std::string_view {key.data(), keyLength});
+                if (station != snapshot.stations.end())
                 {
-                    auto allStations = mDatabaseHandle.getAllActiveStations();
-                    response->clear_stations();
-                    for (const auto &station : allStations)
-                    {
-                        *response->add_stations() = station.toProtobuf();
-                    }
+                    ::projectStation(station->second, columns, response);
+                    mMetrics.addRows("GetActiveStation", 1);
                 }
-                catch (const std::exception &e)
+                else
                 {
-                    if (mLogger)
-                    {
-                        SPDLOG_LOGGER_ERROR(mLogger,
-                            "GetAllActiveStations request query failed with ",
-                             std::string{e.what()});
-                    }
-                    grpc::Status status{grpc::StatusCode::UNKNOWN,
-                                        "Server-side query failed"};
-                    Finish(status);
+                    status = grpc::Status{grpc::StatusCode::NOT_FOUND,
+                                          "Could not find "
+                                        + request->network() + "."
+                                        + request->name()};
                 }
-                const auto endTime
-                    = std::chrono::duration_cast<std::chrono::nanoseconds>
-                      ((std::chrono::high_resolution_clock::now()).time_since_epoch());
-                const auto processTime
-                    = static_cast<double> ((endTime - startTime).count())*1.e-9;
-                Finish(grpc::Status::OK);
+                return ::finish(admission, span, status);
             }
-        private:
-            void OnDone() override
+            catch (const std::exception &e)
             {
-                if (mLogger)
-                {
-                    SPDLOG_LOGGER_DEBUG(mLogger,
-                                        "GetAllActiveStations RPC completed");
-                }
-                delete this;
+                spdlog::warn("Station index lookup failed because "
+                           + std::string {e.what()}
+                           + "; querying database");
             }
-            void OnCancel() override
+        }
+        // Invalid or unusually long names go to the database
+        return ::finishOnExecutor(mExecutor, context, span, admission,
+                                  [this, request, response, columns]()
+        {
+            grpc::Status status{grpc::Status::OK};
+            const auto network = request->network();
+            const auto name = request->name();
+            try
             {
-                if (mLogger)
+                const auto startTime = std::chrono::steady_clock::now();
+                std::optional<UMetadata::Station> result;
                 {
-                   SPDLOG_LOGGER_DEBUG(mLogger,
-                                       "GetAllActiveStations RPC canceled");
+                    const ::ProfiledQuery profile{::Operation::GetActiveStation};
+                    result = mDatabase.getActiveStationInformation(network, name);
+                }
+                mMetrics.recordQuery("GetActiveStation",
+                                     ::getMilliseconds(startTime));
+                if (!result)
+                {
+                    status = grpc::Status{grpc::StatusCode::NOT_FOUND,
+                                          "Could not find "
+                                          + network + "." + name};
+                }
+                else
+                {
+                    const auto conversionTime = std::chrono::steady_clock::now();
+                    ::projectStation(result->toProtobuf(), columns, response);
+                    ::LatencyStatistics::getInstance().record(
+                        ::Operation::GetActiveStation,
+                        ::Stage::ToProtobuf,
+                        std::chrono::steady_clock::now() - conversionTime);
+                    mMetrics.addRows("GetActiveStation", 1);
                 }
             }
-            std::shared_ptr<spdlog::logger> mLogger{nullptr};
-        };
-        return new Reactor(*mDatabase, *request, response, mLogger);
+            catch (const std::invalid_argument &e)
+            {
+                status = grpc::Status{grpc::StatusCode::INVALID_ARGUMENT,
+                                      std::string {e.what()}};
+            }
+            catch (const std::exception &e)
+            {
+                spdlog::warn(e.what());
+                status = grpc::Status{grpc::StatusCode::UNKNOWN,
+                                      "Server-side query failed"};
+            }
+            return status;
+        });
+    }
+    /// Each stream is registered with the cache's change notifications
+    /// rather than polling.
+    grpc::ServerWriteReactor<UMetadataAPI::V1::ActiveStationsUpdate>*
+        WatchActiveStations(
+            grpc::CallbackServerContext *context,
+            const UMetadataAPI::V1::WatchActiveStationsRequest *request) override
+    {
+        ::ScopedSpan span{::startServerSpan(*mTracer, context,
+            "UMetadataAPI.V1.StationInformation/WatchActiveStations")};
+        auto admission = mAdmission.admit(::Operation::WatchActiveStations);
+        if (!admission)
+        {
+            const auto status
+                = ::AdmissionController::getRejectedStatus(
+                     ::Operation::WatchActiveStations);
+            span.setStatus(status);
+            return new ::FailedWriteReactor
+                       <UMetadataAPI::V1::ActiveStationsUpdate> (status);
+        }
+        if (mLogger && !request->identifier().empty())
+        {
+            SPDLOG_LOGGER_DEBUG(mLogger,
+                "Received WatchActiveStations request from {} at {}",
+                request->identifier(), request->sequence_number());
+        }
+        return ::WatchActiveStationsReactor::start(*mActiveStationsCache,
+                                                   mWatchers,
+                                                   request->sequence_number(),
+                                                   std::move(admission),
+                                                   span.release());
     }
+    /// Every key is resolved against one pinned snapshot so the batch is
+    /// consistent and costs one hash probe per station.
     grpc::ServerUnaryReactor*
-        GetActiveStation(grpc::CallbackServerContext *context,
-                         const UMetadataAPI::V1::ActiveStationRequest *request,
-                         UMetadataAPI::V1::Station *response) override
-    {   
-        // Get the active stations
-        const auto network = request->network();
-        const auto name = request->name();
+        GetActiveStations(grpc::CallbackServerContext *context,
+                          const UMetadataAPI::V1::ActiveStationsRequest *request,
+                          UMetadataAPI::V1::ActiveStationsResponse *response) override
+    {
+        ::ScopedSpan span{::startServerSpan(*mTracer, context,
+            "UMetadataAPI.V1.StationInformation/GetActiveStations")};
+        auto admission = mAdmission.admit(::Operation::GetActiveStations);
+        if (!admission)
+        {
+            return ::finish(context, span,
+                            ::AdmissionController::getRejectedStatus(
+                               ::Operation::GetActiveStations));
+        }
         grpc::Status status{grpc::Status::OK};
+        if (request->stations_size() > MAXIMUM_BATCH_SIZE)
+        {
+            status = grpc::Status{grpc::StatusCode::INVALID_ARGUMENT,
+                                  "At most "
+                                + std::to_string(MAXIMUM_BATCH_SIZE)
+                                + " stations can be requested"};
+            return ::finish(admission, span, status);
+        }
+        if (mLogger && !request->identifier().empty())
+        {
+            SPDLOG_LOGGER_DEBUG(mLogger,
+                "Received GetActiveStations request for {} stations from {}",
+                request->stations_size(), request->identifier());
+        }
         try
         {
-            auto result = mDatabase->getActiveStationInformation(network, name);
-            if (!result)
-            {
-                status = grpc::Status{grpc::StatusCode::NOT_FOUND,
-                                      "Could not find "
-                                      + network + "." + name};
-            }
-            else
+            const auto columns = ::toStationColumns(request->field_mask());
+            const auto &snapshot = mActiveStationsCache->peek();
+            response->mutable_stations()->Reserve(request->stations_size());
+            std::array<char, 64> key;
+            for (const auto &station : request->stations())
             {
-                *response = result->toProtobuf();
+                // Invalid or unusually long names cannot be in the index
+                const auto keyLength
+                    = ::toStationKey(station.network(), station.name(), key);
+                auto match = keyLength > 0 ?
+                             snapshot.stations.find(
+                                std::string_view {key.data(), keyLength}) :
+                             snapshot.stations.end();
+                if (match != snapshot.stations.end())
+                {
+                    ::projectStation(match->second,
+                                     columns,
+                                     response->add_stations());
+                }
+                else
+                {
+                    auto missing = response->add_missing();
+                    missing->set_network(station.network());
+                    missing->set_name(station.name());
+                }
             }
+            mMetrics.addRows("GetActiveStations",
+                             static_cast<size_t> (response->stations_size()));
         }
         catch (const std::invalid_argument &e)
         {
+            response->Clear();
             status = grpc::Status{grpc::StatusCode::INVALID_ARGUMENT,
                                   std::string {e.what()}};
         }
         catch (const std::exception &e)
         {
-            spdlog::warn(e.what());
+            if (mLogger)
+            {
+                SPDLOG_LOGGER_ERROR(mLogger,
+                    "GetActiveStations request query failed with {}",
+                    std::string {e.what()});
+            }
+            response->Clear();
             status = grpc::Status{grpc::StatusCode::UNKNOWN,
                                   "Server-side query failed"};
         }
-        auto reactor = context->DefaultReactor();
-        reactor->Finish(status);
-        return reactor;
+        return ::finish(admission, span, status);
+    }
+    grpc::ServerUnaryReactor*
+        GetActiveStationsInBoundingBox(
+            grpc::CallbackServerContext *context,
+            const UMetadataAPI::V1::ActiveStationsInBoundingBoxRequest *request,
+            UMetadataAPI::V1::StationsResponse *response) override
+    {
+        ::ScopedSpan span{::startServerSpan(*mTracer, context,
+            "UMetadataAPI.V1.StationInformation/GetActiveStationsInBoundingBox")};
+        auto admission
+            = mAdmission.admit(::Operation::GetActiveStationsInBoundingBox);
+        if (!admission)
+        {
+            return ::finish(context, span,
+                            ::AdmissionController::getRejectedStatus(
+                               ::Operation::GetActiveStationsInBoundingBox));
+        }
+        return ::finishOnExecutor(mExecutor, context, span, admission,
+                                  [this, request, response]()
+        {
+            grpc::Status status{grpc::Status::OK};
+            try
+            {
+                const auto startTime = std::chrono::steady_clock::now();
+                std::vector<UMetadata::Station> stations;
+                {
+                    const ::ProfiledQuery profile{
+                        ::Operation::GetActiveStationsInBoundingBox};
+                    stations
+                        = mDatabase.getActiveStationsInBoundingBox(
+                             request->minimum_latitude(),
+                             request->maximum_latitude(),
+                             request->minimum_longitude(),
+                             request->maximum_longitude());
+                }
+                mMetrics.recordQuery("GetActiveStationsInBoundingBox",
+                                     ::getMilliseconds(startTime));
+                mMetrics.addRows("GetActiveStationsInBoundingBox",
+                                 stations.size());
+                const auto conversionTime = std::chrono::steady_clock::now();
+                response->clear_stations();
+                response->mutable_stations()->Reserve(
+                    static_cast<int> (stations.size()));
+                for (const auto &station : stations)
+                {
+                    *response->add_stations() = station.toProtobuf();
+                }
+                ::LatencyStatistics::getInstance().record(
+                    ::Operation::GetActiveStationsInBoundingBox,
+                    ::Stage::ToProtobuf,
+                    std::chrono::steady_clock::now() - conversionTime);
+            }
+            catch (const std::invalid_argument &e)
+            {
+                status = grpc::Status{grpc::StatusCode::INVALID_ARGUMENT,
+                                      std::string {e.what()}};
+            }
+            catch (const std::exception &e)
+            {
+                spdlog::warn(e.what());
+                status = grpc::Status{grpc::StatusCode::UNKNOWN,
+                                      "Server-side query failed"};
+            }
+            return status;
+        });
+    }
+    grpc::ServerUnaryReactor*
+        GetActiveStationsWithinRadius(
+            grpc::CallbackServerContext *context,
+            const UMetadataAPI::V1::ActiveStationsWithinRadiusRequest *request,
+            UMetadataAPI::V1::StationsResponse *response) override
+    {
+        ::ScopedSpan span{::startServerSpan(*mTracer, context,
+            "UMetadataAPI.V1.StationInformation/GetActiveStationsWithinRadius")};
+        auto admission
+            = mAdmission.admit(::Operation::GetActiveStationsWithinRadius);
+        if (!admission)
+        {
+            return ::finish(context, span,
+                            ::AdmissionController::getRejectedStatus(
+                               ::Operation::GetActiveStationsWithinRadius));
+        }
+        return ::finishOnExecutor(mExecutor, context, span, admission,
+                                  [this, request, response]()
+        {
+            grpc::Status status{grpc::Status::OK};
+            try
+            {
+                const auto startTime = std::chrono::steady_clock::now();
+                std::vector<UMetadata::Station> stations;
+                {
+                    const ::ProfiledQuery profile{
+                        ::Operation::GetActiveStationsWithinRadius};
+                    stations
+                        = mDatabase.getActiveStationsWithinRadius(
+                             request->latitude(),
+                             request->longitude(),
+                             request->radius());
+                }
+                mMetrics.recordQuery("GetActiveStationsWithinRadius",
+                                     ::getMilliseconds(startTime));
+                mMetrics.addRows("GetActiveStationsWithinRadius",
+                                 stations.size());
+                const auto conversionTime = std::chrono::steady_clock::now();
+                response->clear_stations();
+                response->mutable_stations()->Reserve(
+                    static_cast<int> (stations.size()));
+                for (const auto &station : stations)
+                {
+                    *response->add_stations() = station.toProtobuf();
+                }
+                ::LatencyStatistics::getInstance().record(
+                    ::Operation::GetActiveStationsWithinRadius,
+                    ::Stage::ToProtobuf,
+                    std::chrono::steady_clock::now() - conversionTime);
+            }
+            catch (const std::invalid_argument &e)
+            {
+                status = grpc::Status{grpc::StatusCode::INVALID_ARGUMENT,
+                                      std::string {e.what()}};
+            }
+            catch (const std::exception &e)
+            {
+                spdlog::warn(e.what());
+                status = grpc::Status{grpc::StatusCode::UNKNOWN,
+                                      "Server-side query failed"};
+            }
+            return status;
+        });
     }
 
     void setHealthCheckService(
@@ -194,18 +2291,346 @@ public:
         mHealthCheckService = healthCheckService;
     }
     std::shared_ptr<spdlog::logger> mLogger{nullptr};
+    opentelemetry::nostd::shared_ptr<opentelemetry::trace::Tracer>
+        mTracer{::getTracer()};
+    // An inventory of a few hundred stations serializes to tens of kB
+    // Bounds the work, and the response size, of one batch lookup
+    static constexpr int MAXIMUM_BATCH_SIZE{10000};
+    ::ArenaMessageAllocator<UMetadataAPI::V1::ActiveStationsRequest,
+                            UMetadataAPI::V1::ActiveStationsResponse>
+        mBatchAllocator{64*1024};
+    ::ArenaMessageAllocator<UMetadataAPI::V1::ActiveStationsInBoundingBoxRequest,
+                            UMetadataAPI::V1::StationsResponse>
+        mBoundingBoxAllocator{64*1024};
+    ::ArenaMessageAllocator<UMetadataAPI::V1::ActiveStationsWithinRadiusRequest,
+                            UMetadataAPI::V1::StationsResponse>
+        mRadiusAllocator{64*1024};
     mutable std::mutex mMutex;
-    std::unique_ptr<UMetadata::Database> mDatabase{nullptr};
+    const UMetadata::Database &mDatabase;
+    ::Metrics &mMetrics;
+    ::DatabaseExecutor &mExecutor;
+    ::AdmissionController &mAdmission;
+    ::ActiveStationsWatchers mWatchers;
+    std::unique_ptr<::ActiveStationsCache> mActiveStationsCache{nullptr};
+    std::unique_ptr<::RefreshScheduler<::ActiveStationsCache>>
+        mRefreshScheduler{nullptr};
     grpc::HealthCheckServiceInterface *mHealthCheckService{nullptr};
 };
 
+class ChannelInformationServiceImpl final :
+    public UMetadataAPI::V1::ChannelInformation::
+           WithRawCallbackMethod_GetAllActiveChannels<
+              UMetadataAPI::V1::ChannelInformation::CallbackService>
+{
+public:
+    ChannelInformationServiceImpl(
+        const ::ProgramOptions &options,
+        const UMetadata::Database &database,
+        ::Metrics &metrics,
+        ::DatabaseExecutor &executor,
+        ::AdmissionController &admission,
+        std::shared_ptr<spdlog::logger> logger) :
+        mLogger(std::move(logger)),
+        mDatabase(database),
+        mMetrics(metrics),
+        mExecutor(executor),
+        mAdmission(admission)
+    {
+        mActiveChannelsCache
+            = std::make_unique<::ActiveChannelsCache> (mDatabase, mMetrics);
+        mRefreshScheduler
+            = std::make_unique<::RefreshScheduler<::ActiveChannelsCache>>
+              (*mActiveChannelsCache,
+               options.changePollInterval,
+               "active channels");
+    }
+    /// Served from pre-serialized bytes so the response is neither rebuilt
+    /// nor re-encoded unless the active set has changed.
+    grpc::ServerUnaryReactor*
+        GetAllActiveChannels(grpc::CallbackServerContext *context,
+                             const grpc::ByteBuffer *request,
+                             grpc::ByteBuffer *response) override
+    {
+        ::ScopedSpan span{::startServerSpan(*mTracer, context,
+            "UMetadataAPI.V1.ChannelInformation/GetAllActiveChannels")};
+        auto admission = mAdmission.admit(::Operation::GetAllActiveChannels);
+        if (!admission)
+        {
+            return ::finish(context, span,
+                            ::AdmissionController::getRejectedStatus(
+                               ::Operation::GetAllActiveChannels));
+        }
+        grpc::Status status{grpc::Status::OK};
+        UMetadataAPI::V1::AllActiveChannelsRequest parsedRequest;
+        if (!::parseRawRequest(*request, &parsedRequest))
+        {
+            return ::finish(admission, span,
+                            grpc::Status{grpc::StatusCode::INVALID_ARGUMENT,
+                                         "Could not parse request"});
+        }
+        if (mLogger && !parsedRequest.identifier().empty())
+        {
+            SPDLOG_LOGGER_DEBUG(mLogger,
+                "Received GetAllActiveChannels request from {}",
+                parsedRequest.identifier());
+        }
+        uint32_t columns{::ChannelColumn::AllChannelColumns};
+        try
+        {
+            columns = ::toChannelColumns(parsedRequest.field_mask());
+        }
+        catch (const std::invalid_argument &e)
+        {
+            return ::finish(admission, span,
+                            grpc::Status{grpc::StatusCode::INVALID_ARGUMENT,
+                                         std::string {e.what()}});
+        }
+        try
+        {
+            const auto &snapshot = mActiveChannelsCache->peek();
+            ::setRawResponse(
+                mActiveChannelsCache->getProjection(snapshot,
+                                                    columns,
+                                                    parsedRequest.version()),
+                response);
+            if (parsedRequest.version()
+                != ::toChannelInventoryVersion(snapshot.version, columns))
+            {
+                mMetrics.addRows("GetAllActiveChannels",
+                                 snapshot.channels.size());
+            }
+        }
+        catch (const std::exception &e)
+        {
+            if (mLogger)
+            {
+                SPDLOG_LOGGER_ERROR(mLogger,
+                    "GetAllActiveChannels request query failed with {}",
+                    std::string {e.what()});
+            }
+            status = grpc::Status{grpc::StatusCode::UNKNOWN,
+                                  "Server-side query failed"};
+        }
+        return ::finish(admission, span, status);
+    }
+    grpc::ServerUnaryReactor*
+        GetActiveChannel(grpc::CallbackServerContext *context,
+                         const UMetadataAPI::V1::ActiveChannelRequest *request,
+                         UMetadataAPI::V1::Channel *response) override
+    {
+        ::ScopedSpan span{::startServerSpan(*mTracer, context,
+            "UMetadataAPI.V1.ChannelInformation/GetActiveChannel")};
+        auto admission = mAdmission.admit(::Operation::GetActiveChannel);
+        if (!admission)
+        {
+            return ::finish(context, span,
+                            ::AdmissionController::getRejectedStatus(
+                               ::Operation::GetActiveChannel));
+        }
+        grpc::Status status{grpc::Status::OK};
+        uint32_t columns{::ChannelColumn::AllChannelColumns};
+        try
+        {
+            columns = ::toChannelColumns(request->field_mask());
+        }
+        catch (const std::invalid_argument &e)
+        {
+            return ::finish(admission, span,
+                            grpc::Status{grpc::StatusCode::INVALID_ARGUMENT,
+                                         std::string {e.what()}});
+        }
+        // Look the channel up in the in-memory index
+        std::array<char, 64> key;
+        const auto keyLength
+            = ::toChannelKey(request->network(), request->name(),
+                             request->channel(), request->location_code(),
+                             key);
+        if (keyLength > 0)
+        {
+            try
+            {
+                const auto &snapshot = mActiveChannelsCache->peek();
+                auto channel
+                    = snapshot.channels.find(
+                         std::string_view {key.data(), keyLength});
+                if (channel != snapshot.channels.end())
+                {
+                    ::projectChannel(channel->second, columns, response);
+                    mMetrics.addRows("GetActiveChannel", 1);
+                }
+                else
+                {
+                    status = grpc::Status{grpc::StatusCode::NOT_FOUND,
+                                          "Could not find "
+                                        + std::string {key.data(), keyLength}};
+                }
+                return ::finish(admission, span, status);
+            }
+            catch (const std::exception &e)
+            {
+                spdlog::warn("Channel index lookup failed because "
+                           + std::string {e.what()}
+                           + "; querying database");
+            }
+        }
+        // Invalid or unusually long names go to the database
+        return ::finishOnExecutor(mExecutor, context, span, admission,
+                                  [this, request, response, columns]()
+        {
+            grpc::Status status{grpc::Status::OK};
+            try
+            {
+                const auto startTime = std::chrono::steady_clock::now();
+                std::optional<UMetadata::Channel> result;
+                {
+                    const ::ProfiledQuery profile{::Operation::GetActiveChannel};
+                    result = mDatabase.getActiveChannelInformation(
+                                request->network(), request->name(),
+                                request->channel(), request->location_code());
+                }
+                mMetrics.recordQuery("GetActiveChannel",
+                                     ::getMilliseconds(startTime));
+                if (!result)
+                {
+                    status = grpc::Status{grpc::StatusCode::NOT_FOUND,
+                                          "Could not find "
+                                        + request->network() + "."
+                                        + request->name() + "."
+                                        + request->channel() + "."
+                                        + request->location_code()};
+                }
+                else
+                {
+                    const auto conversionTime = std::chrono::steady_clock::now();
+                    ::projectChannel(result->toProtobuf(), columns, response);
+                    ::LatencyStatistics::getInstance().record(
+                        ::Operation::GetActiveChannel,
+                        ::Stage::ToProtobuf,
+                        std::chrono::steady_clock::now() - conversionTime);
+                    mMetrics.addRows("GetActiveChannel", 1);
+                }
+            }
+            catch (const std::invalid_argument &e)
+            {
+                status = grpc::Status{grpc::StatusCode::INVALID_ARGUMENT,
+                                      std::string {e.what()}};
+            }
+            catch (const std::exception &e)
+            {
+                spdlog::warn(e.what());
+                status = grpc::Status{grpc::StatusCode::UNKNOWN,
+                                      "Server-side query failed"};
+            }
+            return status;
+        });
+    }
+private:
+    std::shared_ptr<spdlog::logger> mLogger{nullptr};
+    opentelemetry::nostd::shared_ptr<opentelemetry::trace::Tracer>
+        mTracer{::getTracer()};
+    const UMetadata::Database &mDatabase;
+    ::Metrics &mMetrics;
+    ::DatabaseExecutor &mExecutor;
+    ::AdmissionController &mAdmission;
+    std::unique_ptr<::ActiveChannelsCache> mActiveChannelsCache{nullptr};
+    std::unique_ptr<::RefreshScheduler<::ActiveChannelsCache>>
+        mRefreshScheduler{nullptr};
+};
+
+/// @brief Reports where the server spends its time so that it can be
+///        diagnosed while it is live.
+class ServerStatisticsServiceImpl final :
+    public UMetadataAPI::V1::ServerStatistics::CallbackService
+{
+public:
+    explicit ServerStatisticsServiceImpl(
+        std::shared_ptr<spdlog::logger> logger) :
+        mLogger(std::move(logger))
+    {
+    }
+    grpc::ServerUnaryReactor*
+        GetServerStatistics(
+            grpc::CallbackServerContext *context,
+            const UMetadataAPI::V1::ServerStatisticsRequest *request,
+            UMetadataAPI::V1::ServerStatisticsResponse *response) override
+    {
+        ::ScopedSpan span{::startServerSpan(*mTracer, context,
+            "UMetadataAPI.V1.ServerStatistics/GetServerStatistics")};
+        if (mLogger && !request->identifier().empty())
+        {
+            SPDLOG_LOGGER_DEBUG(mLogger,
+                "Received GetServerStatistics request from {}",
+                request->identifier());
+        }
+        ::LatencyStatistics::getInstance().fill(response);
+        return ::finish(context, span, grpc::Status::OK);
+    }
+private:
+    std::shared_ptr<spdlog::logger> mLogger{nullptr};
+    opentelemetry::nostd::shared_ptr<opentelemetry::trace::Tracer>
+        mTracer{::getTracer()};
+};
+
 void runServer(const ::ProgramOptions &options,
                std::shared_ptr<spdlog::logger> logger)
 {
     auto serverAddress = options.grpcHost + ":"
                         + std::to_string(options.grpcPort);
 
-    StationInformationServiceImpl service{options, logger};
+    // Instruments created before the exporter would never be exported
+    std::unique_ptr<::MetricsExporter> metricsExporter{nullptr};
+    if (!options.otelHTTPMetricsURL.empty())
+    {
+        metricsExporter = ::createOTLPMetricsExporter(options);
+    }
+    // Likewise, the database and services cache their tracers
+    std::unique_ptr<::TracesExporter> tracesExporter{nullptr};
+    if (!options.otelHTTPTracesURL.empty())
+    {
+        tracesExporter = std::make_unique<::TracesExporter> (options);
+    }
+    ::Metrics metrics{APPLICATION_NAME};
+    // The latency statistics break each query into its step and unpack time
+    UMetadata::Database::setQueryProfiling(true);
+
+    // The services share one read-only connection pool so that an
+    // in-memory database is loaded once
+    std::unique_ptr<UMetadata::Database> database{nullptr};
+    try
+    {
+        constexpr bool openReadOnly{true};
+        database
+            = std::make_unique<UMetadata::Database>
+              (options.sqlite3Database,
+               openReadOnly,
+               options.databaseOptions);
+    }
+    catch (const std::exception &e)
+    {
+        spdlog::critical("Failed to open read-only connection because "
+                       + std::string {e.what()});
+        throw std::runtime_error("Failed to open database connection");
+    }
+    // Queued database work holds admissions so the controller must outlive
+    // the executor
+    ::AdmissionController admission{options.maximumConcurrentLookups,
+                                    options.maximumConcurrentInventories,
+                                    options.lookupQueueBudget,
+                                    options.inventoryQueueBudget,
+                                    metrics};
+    // There is no point in more workers than connections to query with
+    ::DatabaseExecutor executor{
+        options.databaseWorkerThreads > 0 ?
+        options.databaseWorkerThreads :
+        options.databaseOptions.getReadConnectionPoolSize(),
+        options.maximumQueuedQueries};
+    StationInformationServiceImpl service{options, *database,
+                                          metrics, executor, admission,
+                                          logger};
+    ChannelInformationServiceImpl channelService{options, *database,
+                                                 metrics, executor, admission,
+                                                 logger};
+    ServerStatisticsServiceImpl statisticsService{logger};
 
     grpc::EnableDefaultHealthCheckService(true);
     if (options.grpcEnableReflection)
@@ -233,6 +2658,13 @@ void runServer(const ::ProgramOptions &options,
                                  grpc::SslServerCredentials(sslOptions));
     }
     builder.RegisterService(&service);
+    builder.RegisterService(&channelService);
+    builder.RegisterService(&statisticsService);
+    std::vector<std::unique_ptr<
+        grpc::experimental::ServerInterceptorFactoryInterface>> interceptors;
+    interceptors.push_back(
+        std::make_unique<::MetricsInterceptorFactory> (metrics));
+    builder.experimental().SetInterceptorCreators(std::move(interceptors));
 
     std::unique_ptr<grpc::Server> server(builder.BuildAndStart()); 
     service.setHealthCheckService(server->GetHealthCheckService());
@@ -275,13 +2707,18 @@ auto logger = spdlog::stdout_color_mt("console");
 try 
 {   
     constexpr bool readOnly{false};
-    UMetadata::Database database{programOptions.sqlite3Database, readOnly};
+    UMetadata::Database database{programOptions.sqlite3Database,
+                                 readOnly,
+                                 programOptions.databaseOptions};
 
     if (programOptions.isUtah)
     {
         SPDLOG_LOGGER_INFO(logger, "Making utah stations");
         auto stations = ::createStationsUtah();
         database.insert(stations);
+        SPDLOG_LOGGER_INFO(logger, "Making utah channels");
+        auto channels = ::createChannelsUtah();
+        database.insert(channels);
     }
     else
     {
@@ -407,6 +2844,71 @@ options.isUtah = propertyTree.get<bool> ("General.isUtah", options.isUtah);
     options.sqlite3Database
         = propertyTree.get<std::string> ("SQLite3.databaseFile",
                                          options.sqlite3Database.string());
+    auto busyTimeout
+        = propertyTree.get<int64_t>
+          ("SQLite3.busyTimeout",
+           options.databaseOptions.getBusyTimeout().count());
+    options.databaseOptions.setBusyTimeout(
+        std::chrono::milliseconds {busyTimeout});
+    options.databaseOptions.setReadConnectionPoolSize(
+        propertyTree.get<int> (
+           "SQLite3.readConnections",
+           options.databaseOptions.getReadConnectionPoolSize()));
+    std::string servingMode{"FILE"};
+    servingMode
+        = propertyTree.get<std::string> ("SQLite3.servingMode", servingMode);
+    std::transform(servingMode.begin(), servingMode.end(),
+                   servingMode.begin(), ::toupper);
+    if (servingMode == "FILE")
+    {
+        options.databaseOptions.setServingMode(
+            UMetadata::DatabaseOptions::ServingMode::File);
+    }
+    else if (servingMode == "MMAP")
+    {
+        options.databaseOptions.setServingMode(
+            UMetadata::DatabaseOptions::ServingMode::MemoryMapped);
+    }
+    else if (servingMode == "MEMORY")
+    {
+        options.databaseOptions.setServingMode(
+            UMetadata::DatabaseOptions::ServingMode::InMemory);
+    }
+    else
+    {
+        throw std::invalid_argument("Unhandled serving mode " + servingMode
+                                  + "; must be FILE, MMAP, or MEMORY");
+    }
+    options.databaseOptions.setMemoryMapSize(
+        propertyTree.get<int64_t> (
+           "SQLite3.mmapSize",
+           options.databaseOptions.getMemoryMapSize()));
+    options.databaseOptions.setCacheSize(
+        propertyTree.get<int64_t> (
+           "SQLite3.cacheSize",
+           options.databaseOptions.getCacheSize()));
+    options.changePollInterval
+        = std::chrono::milliseconds {
+             propertyTree.get<int64_t> ("SQLite3.changePollInterval",
+                                        options.changePollInterval.count())};
+    if (options.changePollInterval.count() <= 0)
+    {
+        throw std::invalid_argument("Change poll interval must be positive");
+    }
+    options.databaseWorkerThreads
+        = propertyTree.get<int> ("SQLite3.workerThreads",
+                                 options.databaseWorkerThreads);
+    if (options.databaseWorkerThreads < 0)
+    {
+        throw std::invalid_argument("Worker threads must be non-negative");
+    }
+    options.maximumQueuedQueries
+        = propertyTree.get<size_t> ("SQLite3.maximumQueuedQueries",
+                                    options.maximumQueuedQueries);
+    if (options.maximumQueuedQueries == 0)
+    {
+        throw std::invalid_argument("Maximum queued queries must be positive");
+    }
 /*
     if (!std::filesystem::exists(options.sqlite3Database))
     {
@@ -429,6 +2931,39 @@ options.isUtah = propertyTree.get<bool> ("General.isUtah", options.isUtah);
         = propertyTree.get<bool> ("gRPC.enableReflection",
                                   options.grpcEnableReflection);
 
+    options.maximumConcurrentLookups
+        = propertyTree.get<int> ("gRPC.maximumConcurrentLookups",
+                                 options.maximumConcurrentLookups);
+    if (options.maximumConcurrentLookups < 1)
+    {
+        throw std::invalid_argument(
+           "Maximum concurrent lookups must be positive");
+    }
+    options.maximumConcurrentInventories
+        = propertyTree.get<int> ("gRPC.maximumConcurrentInventories",
+                                 options.maximumConcurrentInventories);
+    if (options.maximumConcurrentInventories < 1)
+    {
+        throw std::invalid_argument(
+           "Maximum concurrent inventories must be positive");
+    }
+    options.lookupQueueBudget
+        = std::chrono::milliseconds {
+             propertyTree.get<int64_t> ("gRPC.lookupQueueBudget",
+                                        options.lookupQueueBudget.count())};
+    if (options.lookupQueueBudget.count() <= 0)
+    {
+        throw std::invalid_argument("Lookup queue budget must be positive");
+    }
+    options.inventoryQueueBudget
+        = std::chrono::milliseconds {
+             propertyTree.get<int64_t> ("gRPC.inventoryQueueBudget",
+                                        options.inventoryQueueBudget.count())};
+    if (options.inventoryQueueBudget.count() <= 0)
+    {
+        throw std::invalid_argument("Inventory queue budget must be positive");
+    }
+
     std::string grpcServerKey = "";
     grpcServerKey 
         = propertyTree.get<std::string> ("gRPC.serverKey",
@@ -453,6 +2988,60 @@ options.isUtah = propertyTree.get<bool> ("General.isUtah", options.isUtah);
         options.grpcServerKey = grpcServerKey;
         options.grpcServerCertificate = grpcServerCertificate;
     }
+
+    options.otelHTTPMetricsURL
+        = propertyTree.get<std::string> ("OTelHTTPMetricsOptions.url",
+                                         options.otelHTTPMetricsURL);
+    options.otelHTTPMetricsExportInterval
+        = std::chrono::milliseconds {
+             propertyTree.get<int64_t> (
+                "OTelHTTPMetricsOptions.exportInterval",
+                options.otelHTTPMetricsExportInterval.count())};
+    options.otelHTTPMetricsExportTimeout
+        = std::chrono::milliseconds {
+             propertyTree.get<int64_t> (
+                "OTelHTTPMetricsOptions.exportTimeout",
+                options.otelHTTPMetricsExportTimeout.count())};
+    if (options.otelHTTPMetricsExportTimeout.count() <= 0 ||
+        options.otelHTTPMetricsExportTimeout
+           > options.otelHTTPMetricsExportInterval)
+    {
+        throw std::invalid_argument(
+           "Metrics export timeout must be in (0, export interval]");
+    }
+
+    options.otelHTTPTracesURL
+        = propertyTree.get<std::string> ("OTelHTTPTracesOptions.url",
+                                         options.otelHTTPTracesURL);
+    options.otelHTTPTracesSamplingRatio
+        = propertyTree.get<double> ("OTelHTTPTracesOptions.samplingRatio",
+                                    options.otelHTTPTracesSamplingRatio);
+    if (options.otelHTTPTracesSamplingRatio < 0 ||
+        options.otelHTTPTracesSamplingRatio > 1)
+    {
+        throw std::invalid_argument("Trace sampling ratio must be in [0, 1]");
+    }
+    options.otelHTTPTracesRespectParentSampling
+        = propertyTree.get<bool> (
+             "OTelHTTPTracesOptions.respectParentSampling",
+             options.otelHTTPTracesRespectParentSampling);
+    options.otelHTTPTracesScheduleDelay
+        = std::chrono::milliseconds {
+             propertyTree.get<int64_t> (
+                "OTelHTTPTracesOptions.scheduleDelay",
+                options.otelHTTPTracesScheduleDelay.count())};
+    if (options.otelHTTPTracesScheduleDelay.count() <= 0)
+    {
+        throw std::invalid_argument("Trace schedule delay must be positive");
+    }
+    options.otelHTTPTracesMaximumQueueSize
+        = propertyTree.get<size_t> (
+             "OTelHTTPTracesOptions.maximumQueueSize",
+             options.otelHTTPTracesMaximumQueueSize);
+    if (options.otelHTTPTracesMaximumQueueSize == 0)
+    {
+        throw std::invalid_argument("Trace queue size must be positive");
+    }
     return options;
 }
 
@@ -97,6 +97,26 @@ Station& Station::operator=(Station &&station) noexcept
     return *this;
 }
 
+/// Reset class
+void Station::clear() noexcept
+{
+    // Keep the strings' capacity so a reused station does not reallocate
+    pImpl->mNetwork.clear();
+    pImpl->mName.clear();
+    pImpl->mDescription.clear();
+    pImpl->mStartTime = std::chrono::seconds {0};
+    pImpl->mEndTime = ::getYear3000();
+    pImpl->mLastModified = ::getNow();
+    pImpl->mLatitude = 0;
+    pImpl->mLongitude = 0;
+    pImpl->mElevation = 0;
+    pImpl->mHasLatitude = false;
+    pImpl->mHasLongitude = false;
+    pImpl->mHasElevation = false;
+    pImpl->mHasStartAndEndTime = false;
+    pImpl->mHasDescription = false;
+}
+
 /// Destructor
 Station::~Station() = default;
 
@@ -0,0 +1,39 @@
+#ifndef TRACING_HPP
+#define TRACING_HPP
+#ifdef WITH_TRACING
+#include <opentelemetry/trace/provider.h>
+#include <opentelemetry/trace/scope.h>
+#include <opentelemetry/trace/tracer.h>
+#include "uMetadata/version.hpp"
+#endif
+namespace
+{
+
+#ifdef WITH_TRACING
+/// The library's tracer.
+using TracerHandle
+    = opentelemetry::nostd::shared_ptr<opentelemetry::trace::Tracer>;
+
+/// @result The tracer of the application's tracer provider.  Without an SDK
+///         installed by the application this is a no-op.
+[[maybe_unused]] [[nodiscard]]
+TracerHandle getLibraryTracer(const char *name)
+{
+    return opentelemetry::trace::Provider::GetTracerProvider()
+          ->GetTracer(name, UMetadata::Version::getVersion());
+}
+#else
+/// Without tracing compiled in there is nothing to trace to.
+struct TracerHandle
+{
+};
+
+[[maybe_unused]] [[nodiscard]]
+TracerHandle getLibraryTracer(const char *) noexcept
+{
+    return {};
+}
+#endif
+
+}
+#endif
@@ -1,10 +1,13 @@
 #include <iostream>
+#include <algorithm>
+#include <chrono>
 #include <string>
 #include <spdlog/spdlog.h>
 #include <boost/program_options.hpp>
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/ini_parser.hpp>
 #include "uMetadata/database.hpp"
+#include "uMetadata/databaseOptions.hpp"
 #include "data/utah.hpp"
 #include "data/ynp.hpp"
 
@@ -16,6 +19,8 @@ struct ProgramOptions
 {
     std::string applicationName{APPLICATION_NAME};
     std::filesystem::path sqlite3Database{"utah.db"};
+    UMetadata::DatabaseOptions databaseOptions;
+    bool upsert{false};
     int verbosity{3};
 bool isUtah{true};
 };
@@ -61,16 +66,17 @@ int main(int argc, char *argv[])
     {
         constexpr bool readOnly{false};
         UMetadata::Database database{programOptions.sqlite3Database,
-                                     readOnly};
+                                     readOnly,
+                                     programOptions.databaseOptions};
 
-        if (programOptions.isUtah)
+        auto stations = programOptions.isUtah ?
+                        ::createStationsUtah() : ::createStationsYNP();
+        if (programOptions.upsert)
         {
-            auto stations = ::createStationsUtah();
-            database.insert(stations);
+            database.upsert(stations);
         }
         else
         {
-            auto stations = ::createStationsYNP();
             database.insert(stations);
         }
         database.close();
@@ -149,6 +155,52 @@ options.isUtah = propertyTree.get<bool> ("General.isUtah", options.isUtah);
     options.sqlite3Database
         = propertyTree.get<std::string> ("SQLite3.databaseFile",
                                          options.sqlite3Database.string());
+    std::string journalMode{"WAL"};
+    journalMode
+        = propertyTree.get<std::string> ("SQLite3.journalMode", journalMode);
+    std::transform(journalMode.begin(), journalMode.end(),
+                   journalMode.begin(), ::toupper);
+    if (journalMode == "WAL")
+    {
+        options.databaseOptions.setJournalMode(
+            UMetadata::DatabaseOptions::JournalMode::WAL);
+    }
+    else if (journalMode == "DELETE")
+    {
+        options.databaseOptions.setJournalMode(
+            UMetadata::DatabaseOptions::JournalMode::Delete);
+    }
+    else
+    {
+        throw std::invalid_argument("Unhandled journal mode " + journalMode
+                                  + "; must be WAL or DELETE");
+    }
+    auto busyTimeout
+        = propertyTree.get<int64_t>
+          ("SQLite3.busyTimeout",
+           options.databaseOptions.getBusyTimeout().count());
+    options.databaseOptions.setBusyTimeout(
+        std::chrono::milliseconds {busyTimeout});
+
+    std::string ingestMode{"INSERT"};
+    ingestMode
+        = propertyTree.get<std::string> ("General.ingestMode", ingestMode);
+    std::transform(ingestMode.begin(), ingestMode.end(),
+                   ingestMode.begin(), ::toupper);
+    if (ingestMode == "INSERT")
+    {
+        options.upsert = false;
+    }
+    else if (ingestMode == "UPSERT")
+    {
+        options.upsert = true;
+    }
+    else
+    {
+        throw std::invalid_argument("Unhandled ingest mode " + ingestMode
+                                  + "; must be INSERT or UPSERT");
+    }
+
     auto parentPath = options.sqlite3Database.parent_path();
     if (!parentPath.empty())
     {
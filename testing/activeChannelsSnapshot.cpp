@@ -0,0 +1,160 @@
+#include <memory>
+#include <string>
+#include <vector>
+#include "activeChannelsSnapshot.hpp"
+#include <catch2/catch_test_macros.hpp>
+
+namespace
+{
+
+[[nodiscard]] UMetadataAPI::V1::Channel makeChannel(const std::string &name,
+                                                    const double dip)
+{
+    UMetadataAPI::V1::Channel channel;
+    channel.set_network("UU");
+    channel.set_station("FORK");
+    channel.set_name(name);
+    channel.set_location_code("01");
+    channel.set_sampling_rate(100);
+    channel.set_dip(dip);
+    return channel;
+}
+
+[[nodiscard]] ActiveChannelsSnapshot
+    makeSnapshot(const std::vector<UMetadataAPI::V1::Channel> &channels,
+                 const uint64_t version)
+{
+    ActiveChannelsSnapshot snapshot;
+    UMetadataAPI::V1::ChannelsResponse response;
+    for (const auto &channel : channels)
+    {
+        *response.add_channels() = channel;
+        auto [entry, inserted]
+            = snapshot.channels.emplace(channel.network() + "."
+                                      + channel.station() + "."
+                                      + channel.name() + "."
+                                      + channel.location_code(),
+                                        channel);
+        if (inserted){snapshot.orderedChannels.push_back(&entry->second);}
+    }
+    response.set_version(
+        ::toChannelInventoryVersion(version,
+                                    ::ChannelColumn::AllChannelColumns));
+    snapshot.version = version;
+    snapshot.bytes
+        = std::make_shared<const std::string> (response.SerializeAsString());
+    return snapshot;
+}
+
+}
+
+TEST_CASE("UMetadata::ActiveChannelsSnapshot", "[activeChannelsSnapshot]")
+{
+    constexpr uint64_t version{1000};
+    const auto snapshot
+        = ::makeSnapshot({::makeChannel("HHZ", -90),
+                          ::makeChannel("HHN", 0),
+                          ::makeChannel("HHE", 0)},
+                         version);
+
+    SECTION("Same Channels")
+    {
+        // A rebuild of the same active set keeps its version
+        const auto rebuilt
+            = ::makeSnapshot({::makeChannel("HHE", 0),
+                              ::makeChannel("HHZ", -90),
+                              ::makeChannel("HHN", 0)},
+                             version + 1);
+        CHECK(::haveSameChannels(snapshot, rebuilt));
+    }
+
+    SECTION("Changed Channels")
+    {
+        // A modified, removed, or renamed channel bumps the version
+        CHECK(!::haveSameChannels(snapshot,
+                                  ::makeSnapshot({::makeChannel("HHZ", -90),
+                                                  ::makeChannel("HHN", 0),
+                                                  ::makeChannel("HHE", 1)},
+                                                 version)));
+        CHECK(!::haveSameChannels(snapshot,
+                                  ::makeSnapshot({::makeChannel("HHZ", -90),
+                                                  ::makeChannel("HHN", 0)},
+                                                 version)));
+        CHECK(!::haveSameChannels(snapshot,
+                                  ::makeSnapshot({::makeChannel("HHZ", -90),
+                                                  ::makeChannel("HHN", 0),
+                                                  ::makeChannel("HH1", 0)},
+                                                 version)));
+    }
+
+    SECTION("Projection")
+    {
+        google::protobuf::FieldMask mask;
+        CHECK(::toChannelColumns(mask) == ::ChannelColumn::AllChannelColumns);
+        mask.add_paths("station");
+        mask.add_paths("sampling_rate");
+        mask.add_paths("dip");
+        const auto columns = ::toChannelColumns(mask);
+        CHECK(columns == (::ChannelColumn::SamplingRate
+                        | ::ChannelColumn::Dip));
+        UMetadataAPI::V1::ChannelsResponse response;
+        ::projectChannels(snapshot, columns, &response);
+        CHECK(response.version()
+              == ::toChannelInventoryVersion(version, columns));
+        REQUIRE(response.channels_size() == 3);
+        // The database's order is kept
+        const auto &projected = response.channels(0);
+        CHECK(projected.name() == "HHZ");
+        CHECK(projected.network() == "UU");
+        CHECK(projected.station() == "FORK");
+        CHECK(projected.location_code() == "01");
+        CHECK(projected.sampling_rate() == 100);
+        CHECK(projected.dip() == -90);
+        CHECK(!projected.has_start_time());
+        CHECK(response.channels(2).name() == "HHE");
+        mask.add_paths("gain");
+        CHECK_THROWS_AS(::toChannelColumns(mask), std::invalid_argument);
+    }
+
+    SECTION("Inventory Version")
+    {
+        // A version answers for one field mask
+        const auto all
+            = ::toChannelInventoryVersion(version,
+                                          ::ChannelColumn::AllChannelColumns);
+        const auto masked
+            = ::toChannelInventoryVersion(version, ::ChannelColumn::Dip);
+        CHECK(all != masked);
+        CHECK(::toChannelInventoryVersion(version, 0) != masked);
+        // and, for that mask, increases with the active set
+        CHECK(::toChannelInventoryVersion(version - 1, ::ChannelColumn::Dip)
+              < masked);
+        CHECK(::toChannelInventoryVersion(version + 1, 0) > all);
+    }
+
+    SECTION("Unchanged Response")
+    {
+        const auto all
+            = ::toChannelInventoryVersion(version,
+                                          ::ChannelColumn::AllChannelColumns);
+        UMetadataAPI::V1::ChannelsResponse response;
+        REQUIRE(response.ParseFromString(*snapshot.bytes));
+        CHECK(response.version() == all);
+        // A client without the current version of its mask is sent channels
+        CHECK(!::toUnchangedChannelsResponse(
+                  snapshot, ::ChannelColumn::AllChannelColumns, 0));
+        CHECK(!::toUnchangedChannelsResponse(
+                  snapshot, ::ChannelColumn::AllChannelColumns, all - 1));
+        CHECK(!::toUnchangedChannelsResponse(
+                  snapshot, ::ChannelColumn::Dip, all));
+        // A client with the current version is told it is unchanged
+        const auto bytes
+            = ::toUnchangedChannelsResponse(
+                 snapshot, ::ChannelColumn::AllChannelColumns, all);
+        REQUIRE(bytes);
+        REQUIRE(response.ParseFromString(*bytes));
+        CHECK(response.unchanged());
+        CHECK(response.version() == all);
+        CHECK(response.channels().empty());
+    }
+}
@@ -0,0 +1,209 @@
+#include <memory>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "activeStationsSnapshot.hpp"
+#include <catch2/catch_test_macros.hpp>
+
+namespace
+{
+
+[[nodiscard]] UMetadataAPI::V1::Station makeStation(const std::string &name,
+                                                    const double elevation)
+{
+    UMetadataAPI::V1::Station station;
+    station.set_network("UU");
+    station.set_name(name);
+    station.set_latitude(40.);
+    station.set_longitude(-112.);
+    station.set_elevation(elevation);
+    return station;
+}
+
+/// @brief Builds the snapshot of an active set.  Like the cache, the delta
+///        is taken from the previous snapshot.
+[[nodiscard]] std::shared_ptr<const ActiveStationsSnapshot>
+    makeSnapshot(const std::vector<UMetadataAPI::V1::Station> &stations,
+                 const std::shared_ptr<const ActiveStationsSnapshot> &previous)
+{
+    auto snapshot = std::make_shared<ActiveStationsSnapshot> ();
+    for (const auto &station : stations)
+    {
+        auto [entry, inserted]
+            = snapshot->stations.emplace(station.network() + "."
+                                       + station.name(),
+                                         station);
+        if (inserted){snapshot->orderedStations.push_back(&entry->second);}
+    }
+    if (previous)
+    {
+        auto delta
+            = std::make_shared<UMetadataAPI::V1::ActiveStationsUpdate> ();
+        ::appendDifferences(*previous, *snapshot, delta.get());
+        delta->set_sequence_number(previous->sequenceNumber);
+        snapshot->sequenceNumber = previous->sequenceNumber + 1;
+        snapshot->delta = std::move(delta);
+    }
+    else
+    {
+        snapshot->sequenceNumber = 1000;
+    }
+    return snapshot;
+}
+
+[[nodiscard]] std::set<std::string>
+    getNames(const google::protobuf::RepeatedPtrField<
+                UMetadataAPI::V1::Station> &stations)
+{
+    std::set<std::string> names;
+    for (const auto &station : stations){names.insert(station.name());}
+    return names;
+}
+
+}
+
+TEST_CASE("UMetadata::ActiveStationsSnapshot", "[activeStationsSnapshot]")
+{
+    // FORK is modified, NOQ is removed, and CTU and then MOUT are added
+    const auto first
+        = ::makeSnapshot({::makeStation("FORK", 1500),
+                          ::makeStation("NOQ", 1600),
+                          ::makeStation("SRU", 1700)},
+                         nullptr);
+    const auto second
+        = ::makeSnapshot({::makeStation("FORK", 1510),
+                          ::makeStation("SRU", 1700),
+                          ::makeStation("CTU", 1800)},
+                         first);
+    const auto third
+        = ::makeSnapshot({::makeStation("FORK", 1510),
+                          ::makeStation("SRU", 1700),
+                          ::makeStation("CTU", 1800),
+                          ::makeStation("MOUT", 1900)},
+                         second);
+    ::ActiveStationsHistory history;
+    history.push(first);
+    history.push(second);
+    UMetadataAPI::V1::ActiveStationsUpdate update;
+
+    SECTION("Differences")
+    {
+        UMetadataAPI::V1::ActiveStationsUpdate differences;
+        ::appendDifferences(*first, *second, &differences);
+        CHECK(::getNames(differences.added())
+              == std::set<std::string> {"CTU"});
+        CHECK(::getNames(differences.modified())
+              == std::set<std::string> {"FORK"});
+        CHECK(::getNames(differences.removed())
+              == std::set<std::string> {"NOQ"});
+        differences.Clear();
+        ::appendDifferences(*third, *third, &differences);
+        CHECK(differences.added().empty());
+        CHECK(differences.modified().empty());
+        CHECK(differences.removed().empty());
+    }
+
+    SECTION("Projection")
+    {
+        using Column = UMetadata::Database::StationColumn;
+        google::protobuf::FieldMask mask;
+        CHECK(::toStationColumns(mask) == Column::AllStationColumns);
+        mask.add_paths("network");
+        mask.add_paths("latitude");
+        mask.add_paths("elevation");
+        const auto columns = ::toStationColumns(mask);
+        CHECK(columns == (Column::Latitude | Column::Elevation));
+        const auto &fork = third->stations.at("UU.FORK");
+        UMetadataAPI::V1::Station projected;
+        ::projectStation(fork, columns, &projected);
+        CHECK(projected.network() == "UU");
+        CHECK(projected.name() == "FORK");
+        CHECK(projected.latitude() == fork.latitude());
+        CHECK(projected.elevation() == fork.elevation());
+        CHECK(projected.longitude() == 0);
+        CHECK(projected.ByteSizeLong() < fork.ByteSizeLong());
+        mask.add_paths("channels");
+        CHECK_THROWS_AS(::toStationColumns(mask), std::invalid_argument);
+    }
+
+    SECTION("Inventory Version")
+    {
+        // A version answers for one field mask
+        using Column = UMetadata::Database::StationColumn;
+        const auto all
+            = ::toInventoryVersion(third->sequenceNumber,
+                                   Column::AllStationColumns);
+        const auto masked
+            = ::toInventoryVersion(third->sequenceNumber, Column::Latitude);
+        CHECK(all != masked);
+        CHECK(::toInventoryVersion(third->sequenceNumber, 0) != masked);
+        // and, for that mask, increases with the active set
+        CHECK(::toInventoryVersion(second->sequenceNumber, Column::Latitude)
+              < masked);
+        CHECK(::toInventoryVersion(third->sequenceNumber, Column::Latitude)
+              == masked);
+    }
+
+    SECTION("Current")
+    {
+        CHECK(!history.getUpdateSince(*third, third->sequenceNumber, &update));
+        CHECK(update.added().empty());
+    }
+
+    SECTION("Delta")
+    {
+        // A client one change behind gets the snapshot's delta
+        REQUIRE(history.getUpdateSince(*second,
+                                       first->sequenceNumber,
+                                       &update));
+        CHECK(update.sequence_number() == second->sequenceNumber);
+        CHECK(!update.is_snapshot());
+        CHECK(::getNames(update.added()) == std::set<std::string> {"CTU"});
+        CHECK(::getNames(update.modified()) == std::set<std::string> {"FORK"});
+        CHECK(::getNames(update.removed()) == std::set<std::string> {"NOQ"});
+    }
+
+    SECTION("Resume From Sequence Number")
+    {
+        // A client two changes behind is brought forward from the history
+        REQUIRE(history.getUpdateSince(*third,
+                                       first->sequenceNumber,
+                                       &update));
+        CHECK(update.sequence_number() == third->sequenceNumber);
+        CHECK(!update.is_snapshot());
+        CHECK(::getNames(update.added())
+              == std::set<std::string> {"CTU", "MOUT"});
+        CHECK(::getNames(update.modified()) == std::set<std::string> {"FORK"});
+        CHECK(::getNames(update.removed()) == std::set<std::string> {"NOQ"});
+    }
+
+    SECTION("Full Snapshot Fallback")
+    {
+        // An unknown sequence number, e.g., from before a restart, gets
+        // every station in the database's order
+        REQUIRE(history.getUpdateSince(*third, 1, &update));
+        CHECK(update.sequence_number() == third->sequenceNumber);
+        CHECK(update.is_snapshot());
+        REQUIRE(update.added_size() == 4);
+        CHECK(update.added(0).name() == "FORK");
+        CHECK(update.added(3).name() == "MOUT");
+        CHECK(update.modified().empty());
+        CHECK(update.removed().empty());
+        // So does one that has aged out of the history
+        ::ActiveStationsHistory shortHistory{1};
+        shortHistory.push(first);
+        shortHistory.push(second);
+        REQUIRE(shortHistory.getUpdateSince(*third,
+                                            first->sequenceNumber,
+                                            &update));
+        CHECK(update.is_snapshot());
+        CHECK(update.added_size() == 4);
+        // The previous update is cleared
+        REQUIRE(shortHistory.getUpdateSince(*third,
+                                            second->sequenceNumber,
+                                            &update));
+        CHECK(!update.is_snapshot());
+        CHECK(::getNames(update.added()) == std::set<std::string> {"MOUT"});
+    }
+}
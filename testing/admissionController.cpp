@@ -0,0 +1,100 @@
+#include <chrono>
+#include <memory>
+#include <vector>
+#include "admissionController.hpp"
+#include <catch2/catch_test_macros.hpp>
+
+TEST_CASE("UMetadata::AdmissionController", "[admissionController]")
+{
+    constexpr int maximumLookups{3};
+    constexpr int maximumInventories{2};
+    constexpr std::chrono::milliseconds lookupQueueBudget{250};
+    constexpr std::chrono::milliseconds inventoryQueueBudget{2000};
+    // Without an exporter the rejections are not recorded anywhere
+    ::Metrics metrics{"uMetadataServer"};
+    ::AdmissionController controller{maximumLookups,
+                                     maximumInventories,
+                                     lookupQueueBudget,
+                                     inventoryQueueBudget,
+                                     metrics};
+
+    SECTION("Classification")
+    {
+        using Operation = ::Operation;
+        for (const auto operation : {Operation::GetAllActiveStations,
+                                     Operation::GetAllActiveStationsPaged,
+                                     Operation::WatchActiveStations,
+                                     Operation::GetAllActiveChannels})
+        {
+            CHECK(::AdmissionController::classify(operation)
+                  == ::RequestClass::Inventory);
+        }
+        for (const auto operation : {Operation::GetActiveStation,
+                                     Operation::GetActiveStations,
+                                     Operation::GetActiveStationsInBoundingBox,
+                                     Operation::GetActiveStationsWithinRadius,
+                                     Operation::GetActiveChannel})
+        {
+            CHECK(::AdmissionController::classify(operation)
+                  == ::RequestClass::Lookup);
+        }
+    }
+
+    SECTION("Lookup Limit")
+    {
+        std::vector<std::shared_ptr<const ::AdmissionController::Admission>>
+            admissions;
+        for (int i = 0; i < maximumLookups; ++i)
+        {
+            auto admission = controller.admit(::Operation::GetActiveStation);
+            REQUIRE(admission);
+            CHECK(admission->getRequestClass() == ::RequestClass::Lookup);
+            CHECK(admission->getQueueBudget() == lookupQueueBudget);
+            admissions.push_back(std::move(admission));
+        }
+        CHECK(controller.getInFlight(::Operation::GetActiveStation)
+              == maximumLookups);
+        // The next call is turned away and does not count against the limit
+        CHECK(!controller.admit(::Operation::GetActiveStation));
+        CHECK(controller.getInFlight(::Operation::GetActiveStation)
+              == maximumLookups);
+        // Each RPC has its own limit
+        CHECK(controller.admit(::Operation::GetActiveChannel));
+        // A call is admitted once another is done
+        admissions.pop_back();
+        CHECK(controller.getInFlight(::Operation::GetActiveStation)
+              == maximumLookups - 1);
+        CHECK(controller.admit(::Operation::GetActiveStation));
+    }
+
+    SECTION("Inventory Limit")
+    {
+        auto first = controller.admit(::Operation::GetAllActiveStations);
+        REQUIRE(first);
+        CHECK(first->getRequestClass() == ::RequestClass::Inventory);
+        CHECK(first->getQueueBudget() == inventoryQueueBudget);
+        // The claim lasts until the last reference is released, e.g., by
+        // the reactor once gRPC is done with the call
+        auto reactorCopy = first;
+        auto second = controller.admit(::Operation::GetAllActiveStations);
+        REQUIRE(second);
+        CHECK(!controller.admit(::Operation::GetAllActiveStations));
+        first.reset();
+        CHECK(!controller.admit(::Operation::GetAllActiveStations));
+        reactorCopy.reset();
+        CHECK(controller.admit(::Operation::GetAllActiveStations));
+        CHECK(controller.getInFlight(::Operation::GetAllActiveStations) == 1);
+        second.reset();
+        CHECK(controller.getInFlight(::Operation::GetAllActiveStations) == 0);
+    }
+
+    SECTION("Rejected Status")
+    {
+        const auto status
+            = ::AdmissionController::getRejectedStatus(
+                 ::Operation::GetAllActiveChannels);
+        CHECK(status.error_code() == grpc::StatusCode::RESOURCE_EXHAUSTED);
+        CHECK(status.error_message()
+              == "Too many GetAllActiveChannels requests in progress");
+    }
+}
@@ -47,6 +47,12 @@ TEST_CASE("UMetadata::Channel", "[channel]")
     REQUIRE(channel.getStation() == station);
     REQUIRE(channel.getName() == name);
     REQUIRE(channel.getLocationCode() == locationCode);
+    {
+        UMetadata::Channel blank;
+        blank.setLocationCode("  ");
+        REQUIRE(blank.hasLocationCode());
+        REQUIRE(blank.getLocationCode() == "--");
+    }
     REQUIRE_THAT(channel.getLatitude(),
                  Catch::Matchers::WithinAbs(latitude, 1.e-10));
     REQUIRE_THAT(channel.getLongitude(),
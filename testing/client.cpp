@@ -0,0 +1,390 @@
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <grpcpp/generic/async_generic_service.h>
+#include <grpcpp/security/server_credentials.h>
+#include <grpcpp/server.h>
+#include <grpcpp/server_builder.h>
+#include "uMetadata/client.hpp"
+#include "uMetadata/channel.hpp"
+#include "uMetadata/station.hpp"
+#include "uMetadataAPI/v1/active_channel_request.pb.h"
+#include "uMetadataAPI/v1/all_active_channels_request.pb.h"
+#include "uMetadataAPI/v1/all_active_stations_request.pb.h"
+#include "uMetadataAPI/v1/channels_response.pb.h"
+#include "uMetadataAPI/v1/stations_response.pb.h"
+#include "data/utah.hpp"
+#include "data/utahChannels.hpp"
+#include <catch2/catch_test_macros.hpp>
+
+namespace
+{
+
+/// Answers one method's request.
+using MethodHandler
+    = std::function<grpc::Status (const std::string &request,
+                                  std::string *response)>;
+
+/// @brief Answers a unary call with the handler for its method.
+class StandInReactor final : public grpc::ServerGenericBidiReactor
+{
+public:
+    explicit StandInReactor(const MethodHandler *handler) :
+        mHandler(handler)
+    {
+        if (mHandler == nullptr)
+        {
+            Finish(grpc::Status{grpc::StatusCode::UNIMPLEMENTED,
+                                "Not served by the stand-in"});
+            return;
+        }
+        StartRead(&mRequest);
+    }
+    void OnReadDone(const bool ok) override
+    {
+        if (!ok)
+        {
+            Finish(grpc::Status{grpc::StatusCode::INVALID_ARGUMENT,
+                                "No request"});
+            return;
+        }
+        std::vector<grpc::Slice> slices;
+        std::string request;
+        if (mRequest.Dump(&slices).ok())
+        {
+            for (const auto &slice : slices)
+            {
+                request.append(reinterpret_cast<const char *> (slice.begin()),
+                               slice.size());
+            }
+        }
+        std::string response;
+        const auto status = (*mHandler)(request, &response);
+        if (!status.ok())
+        {
+            Finish(status);
+            return;
+        }
+        grpc::Slice slice{response};
+        mResponse = grpc::ByteBuffer{&slice, 1};
+        StartWriteAndFinish(&mResponse, grpc::WriteOptions {}, status);
+    }
+    void OnDone() override
+    {
+        delete this;
+    }
+private:
+    const MethodHandler *mHandler{nullptr};
+    grpc::ByteBuffer mRequest;
+    grpc::ByteBuffer mResponse;
+};
+
+/// @brief Stands in for the uMetadata server by answering the methods it
+///        is given handlers for.
+class StandInServer final : public grpc::CallbackGenericService
+{
+public:
+    explicit StandInServer(std::map<std::string, MethodHandler> handlers) :
+        mHandlers(std::move(handlers))
+    {
+        grpc::ServerBuilder builder;
+        builder.AddListeningPort("127.0.0.1:0",
+                                 grpc::InsecureServerCredentials(),
+                                 &mPort);
+        builder.RegisterCallbackGenericService(this);
+        mServer = builder.BuildAndStart();
+    }
+    ~StandInServer() override
+    {
+        if (mServer){mServer->Shutdown();}
+    }
+    grpc::ServerGenericBidiReactor *
+        CreateReactor(grpc::GenericCallbackServerContext *context) override
+    {
+        auto handler = mHandlers.find(context->method());
+        return new StandInReactor(handler == mHandlers.end() ?
+                                  nullptr : &handler->second);
+    }
+    [[nodiscard]] std::string getEndPoint() const
+    {
+        return "127.0.0.1:" + std::to_string(mPort);
+    }
+    StandInServer(const StandInServer &) = delete;
+    StandInServer& operator=(const StandInServer &) = delete;
+private:
+    std::map<std::string, MethodHandler> mHandlers;
+    std::unique_ptr<grpc::Server> mServer;
+    int mPort{0};
+};
+
+/// @brief A versioned station inventory that answers GetAllActiveStations
+///        like the server does.
+struct StationInventory
+{
+    grpc::Status getAllActiveStations(const std::string &bytes,
+                                      std::string *response)
+    {
+        UMetadataAPI::V1::AllActiveStationsRequest request;
+        if (!request.ParseFromString(bytes))
+        {
+            return grpc::Status{grpc::StatusCode::INVALID_ARGUMENT,
+                                "Could not parse request"};
+        }
+        const std::lock_guard<std::mutex> lock(mutex);
+        receivedVersions.push_back(request.version());
+        UMetadataAPI::V1::StationsResponse reply;
+        if (request.version() != 0 &&
+            (request.version() == version || alwaysUnchanged))
+        {
+            reply.set_version(version);
+            reply.set_unchanged(true);
+        }
+        else
+        {
+            reply.set_version(version);
+            for (const auto &station : stations)
+            {
+                *reply.add_stations() = station.toProtobuf();
+            }
+        }
+        *response = reply.SerializeAsString();
+        return grpc::Status::OK;
+    }
+    std::mutex mutex;
+    std::vector<UMetadata::Station> stations;
+    std::vector<uint64_t> receivedVersions;
+    uint64_t version{0};
+    /// Misbehaves by answering that any version is unchanged.
+    bool alwaysUnchanged{false};
+};
+
+/// @brief A versioned channel inventory that answers GetAllActiveChannels
+///        and GetActiveChannel like the server does.
+struct ChannelInventory
+{
+    grpc::Status getAllActiveChannels(const std::string &bytes,
+                                      std::string *response)
+    {
+        UMetadataAPI::V1::AllActiveChannelsRequest request;
+        if (!request.ParseFromString(bytes))
+        {
+            return grpc::Status{grpc::StatusCode::INVALID_ARGUMENT,
+                                "Could not parse request"};
+        }
+        const std::lock_guard<std::mutex> lock(mutex);
+        receivedVersions.push_back(request.version());
+        UMetadataAPI::V1::ChannelsResponse reply;
+        reply.set_version(version);
+        if (request.version() != 0 &&
+            (request.version() == version || alwaysUnchanged))
+        {
+            reply.set_unchanged(true);
+        }
+        else
+        {
+            for (const auto &channel : channels)
+            {
+                *reply.add_channels() = channel.toProtobuf();
+            }
+        }
+        *response = reply.SerializeAsString();
+        return grpc::Status::OK;
+    }
+    grpc::Status getActiveChannel(const std::string &bytes,
+                                  std::string *response)
+    {
+        UMetadataAPI::V1::ActiveChannelRequest request;
+        if (!request.ParseFromString(bytes))
+        {
+            return grpc::Status{grpc::StatusCode::INVALID_ARGUMENT,
+                                "Could not parse request"};
+        }
+        const std::lock_guard<std::mutex> lock(mutex);
+        for (const auto &channel : channels)
+        {
+            if (channel.getNetwork() == request.network() &&
+                channel.getStation() == request.name() &&
+                channel.getName() == request.channel() &&
+                channel.getLocationCode() == request.location_code())
+            {
+                *response = channel.toProtobuf().SerializeAsString();
+                return grpc::Status::OK;
+            }
+        }
+        return grpc::Status{grpc::StatusCode::NOT_FOUND,
+                            "Channel is not active"};
+    }
+    std::mutex mutex;
+    std::vector<UMetadata::Channel> channels;
+    std::vector<uint64_t> receivedVersions;
+    uint64_t version{0};
+    /// Misbehaves by answering that any version is unchanged.
+    bool alwaysUnchanged{false};
+};
+
+}
+
+TEST_CASE("UMetadata::Client Inventory Cache", "[client]")
+{
+    constexpr uint64_t firstVersion{(1000U << 7U) | 127U};
+    ::StationInventory inventory;
+    inventory.stations = ::createStationsUtah();
+    inventory.version = firstVersion;
+    REQUIRE(inventory.stations.size() > 1);
+    const auto nStations = inventory.stations.size();
+    ::StandInServer server{
+        {{"/UMetadataAPI.V1.StationInformation/GetAllActiveStations",
+          [&inventory](const std::string &request, std::string *response)
+          {
+              return inventory.getAllActiveStations(request, response);
+          }}}};
+    const UMetadata::Client client{server.getEndPoint()};
+
+    // The first call has nothing cached so it asks for everything
+    auto stations = client.getAllActiveStations();
+    REQUIRE(stations.size() == nStations);
+    CHECK(stations.front().toProtobuf().SerializeAsString()
+          == inventory.stations.front().toProtobuf().SerializeAsString());
+
+    SECTION("Unchanged")
+    {
+        // The cached stations are returned without being resent
+        const auto cached = client.getAllActiveStations();
+        CHECK(cached.size() == nStations);
+        CHECK(cached.front().toProtobuf().SerializeAsString()
+              == stations.front().toProtobuf().SerializeAsString());
+        const std::lock_guard<std::mutex> lock(inventory.mutex);
+        const std::vector<uint64_t> expected{0, firstVersion};
+        CHECK(inventory.receivedVersions == expected);
+    }
+
+    SECTION("Changed")
+    {
+        {
+            const std::lock_guard<std::mutex> lock(inventory.mutex);
+            inventory.stations.pop_back();
+            inventory.version = firstVersion + (1U << 7U);
+        }
+        stations = client.getAllActiveStations();
+        CHECK(stations.size() == nStations - 1);
+        // The new version is cached
+        stations = client.getAllActiveStations();
+        CHECK(stations.size() == nStations - 1);
+        const std::lock_guard<std::mutex> lock(inventory.mutex);
+        const std::vector<uint64_t> expected{0,
+                                             firstVersion,
+                                             firstVersion + (1U << 7U)};
+        CHECK(inventory.receivedVersions == expected);
+    }
+
+    SECTION("Unchanged For Another Version")
+    {
+        // An "unchanged" reply that does not match the cache is not trusted
+        // and the inventory is requested in full
+        {
+            const std::lock_guard<std::mutex> lock(inventory.mutex);
+            inventory.stations.pop_back();
+            inventory.version = firstVersion + (1U << 7U);
+            inventory.alwaysUnchanged = true;
+        }
+        stations = client.getAllActiveStations();
+        CHECK(stations.size() == nStations - 1);
+        const std::lock_guard<std::mutex> lock(inventory.mutex);
+        const std::vector<uint64_t> expected{0, firstVersion, 0};
+        CHECK(inventory.receivedVersions == expected);
+    }
+}
+
+TEST_CASE("UMetadata::Client Channels", "[client]")
+{
+    constexpr uint64_t firstVersion{1000};
+    ::ChannelInventory inventory;
+    inventory.channels = ::createChannelsUtah();
+    inventory.version = firstVersion;
+    REQUIRE(inventory.channels.size() > 1);
+    const auto nChannels = inventory.channels.size();
+    ::StandInServer server{
+        {{"/UMetadataAPI.V1.ChannelInformation/GetAllActiveChannels",
+          [&inventory](const std::string &request, std::string *response)
+          {
+              return inventory.getAllActiveChannels(request, response);
+          }},
+         {"/UMetadataAPI.V1.ChannelInformation/GetActiveChannel",
+          [&inventory](const std::string &request, std::string *response)
+          {
+              return inventory.getActiveChannel(request, response);
+          }}}};
+    const UMetadata::Client client{server.getEndPoint()};
+
+    // The first call has nothing cached so it asks for everything
+    auto channels = client.getAllActiveChannels();
+    REQUIRE(channels.size() == nChannels);
+    CHECK(channels.front().toProtobuf().SerializeAsString()
+          == inventory.channels.front().toProtobuf().SerializeAsString());
+
+    SECTION("Active Channel")
+    {
+        const auto &expected = inventory.channels.back();
+        const auto channel
+            = client.getActiveChannel(expected.getNetwork(),
+                                      expected.getStation(),
+                                      expected.getName(),
+                                      expected.getLocationCode());
+        REQUIRE(channel);
+        CHECK(channel->toProtobuf().SerializeAsString()
+              == expected.toProtobuf().SerializeAsString());
+        // A channel that is not active is not an error
+        CHECK(!client.getActiveChannel("UU", "NOPE", "HHZ", "01"));
+    }
+
+    SECTION("Unchanged")
+    {
+        // The cached channels are returned without being resent
+        const auto cached = client.getAllActiveChannels();
+        CHECK(cached.size() == nChannels);
+        CHECK(cached.front().toProtobuf().SerializeAsString()
+              == channels.front().toProtobuf().SerializeAsString());
+        const std::lock_guard<std::mutex> lock(inventory.mutex);
+        const std::vector<uint64_t> expected{0, firstVersion};
+        CHECK(inventory.receivedVersions == expected);
+    }
+
+    SECTION("Changed")
+    {
+        {
+            const std::lock_guard<std::mutex> lock(inventory.mutex);
+            inventory.channels.pop_back();
+            inventory.version = firstVersion + 1;
+        }
+        channels = client.getAllActiveChannels();
+        CHECK(channels.size() == nChannels - 1);
+        // The new version is cached
+        channels = client.getAllActiveChannels();
+        CHECK(channels.size() == nChannels - 1);
+        const std::lock_guard<std::mutex> lock(inventory.mutex);
+        const std::vector<uint64_t> expected{0,
+                                             firstVersion,
+                                             firstVersion + 1};
+        CHECK(inventory.receivedVersions == expected);
+    }
+
+    SECTION("Unchanged For Another Version")
+    {
+        // An "unchanged" reply that does not match the cache is not trusted
+        // and the inventory is requested in full
+        {
+            const std::lock_guard<std::mutex> lock(inventory.mutex);
+            inventory.channels.pop_back();
+            inventory.version = firstVersion + 1;
+            inventory.alwaysUnchanged = true;
+        }
+        channels = client.getAllActiveChannels();
+        CHECK(channels.size() == nChannels - 1);
+        const std::lock_guard<std::mutex> lock(inventory.mutex);
+        const std::vector<uint64_t> expected{0, firstVersion, 0};
+        CHECK(inventory.receivedVersions == expected);
+    }
+}
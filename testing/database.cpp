@@ -1,11 +1,28 @@
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cmath>
+#include <coroutine>
 #include <iostream>
+#include <latch>
+#include <optional>
 #include <filesystem>
+#include <map>
+#include <memory>
+#include <numbers>
+#include <stdexcept>
 #include <string>
+#include <thread>
+#include <vector>
+#include <sqlite3.h>
 #include "uMetadata/database.hpp"
+#include "uMetadata/databaseOptions.hpp"
 #include "uMetadata/station.hpp"
 #include "uMetadata/channel.hpp"
+#include <google/protobuf/arena.h>
+#include "uMetadataAPI/v1/station.pb.h"
+#include "uMetadataAPI/v1/stations_response.pb.h"
+#include "uMetadataAPI/v1/channels_response.pb.h"
 #include "data/utah.hpp"
 #include "data/ynp.hpp"
 #include "data/utahChannels.hpp"
@@ -19,6 +36,31 @@
 namespace
 {
 
+/// @result The single integer selected by the query.
+[[nodiscard]] int64_t queryInteger(sqlite3 *handle, const std::string &sql)
+{
+    sqlite3_stmt *statement{nullptr};
+    if (sqlite3_prepare_v2(handle, sql.c_str(), -1, &statement, nullptr)
+        != SQLITE_OK)
+    {
+        throw std::runtime_error("Failed to prepare " + sql);
+    }
+    int64_t result{0};
+    if (sqlite3_step(statement) == SQLITE_ROW)
+    {
+        result = sqlite3_column_int64(statement, 0);
+    }
+    sqlite3_finalize(statement);
+    return result;
+}
+
+/// @result True if the statements executed successfully.
+[[nodiscard]] bool execute(sqlite3 *handle, const std::string &sql)
+{
+    return sqlite3_exec(handle, sql.c_str(), nullptr, nullptr, nullptr)
+        == SQLITE_OK;
+}
+
 bool operator==(const UMetadata::Station &lhs,
                 const UMetadata::Station &rhs)
 {
@@ -56,6 +98,110 @@ bool operator==(const UMetadata::Station &lhs,
     return true;
 }
 
+/// A coroutine that runs to completion without being awaited.
+struct Detached
+{
+    struct promise_type
+    {
+        Detached get_return_object() noexcept {return {};}
+        std::suspend_never initial_suspend() noexcept {return {};}
+        std::suspend_never final_suspend() noexcept {return {};}
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept {std::terminate();}
+    };
+};
+
+Detached countActiveStations(const UMetadata::Database &database,
+                             std::atomic<size_t> &count,
+                             std::latch &done)
+{
+    auto stations = co_await database.getAllActiveStationsAsync();
+    count += stations.size();
+    done.count_down();
+}
+
+Detached getStation(const UMetadata::Database &database,
+                    const UMetadata::Station &station,
+                    std::optional<UMetadata::Station> &result,
+                    bool &threw,
+                    std::latch &done)
+{
+    try
+    {
+        result = co_await database.getActiveStationInformationAsync(
+                     station.getNetwork(), station.getName());
+    }
+    catch (const std::runtime_error &)
+    {
+        threw = true;
+    }
+    done.count_down();
+}
+
+/// Holds the query thread that resumes it until released.
+Detached holdQueryThread(const UMetadata::Database &database,
+                         std::latch &held,
+                         std::latch &release)
+{
+    [[maybe_unused]] auto stations
+        = co_await database.getAllActiveStationsAsync();
+    held.count_down();
+    release.wait();
+}
+
+/// Sets rejected if the query could not be started.
+Detached probeQuery(const UMetadata::Database &database,
+                    std::shared_ptr<std::atomic<bool>> rejected)
+{
+    try
+    {
+        [[maybe_unused]] auto stations
+            = co_await database.getAllActiveStationsAsync();
+    }
+    catch (const std::runtime_error &)
+    {
+        rejected->store(true);
+    }
+}
+
+/// Starts a second query from the query thread that resumed the first.
+Detached chainQueries(const UMetadata::Database &database,
+                      std::atomic<int> &firstQueries,
+                      std::atomic<int> &rejectedSecondQueries,
+                      std::latch &done)
+{
+    try
+    {
+        [[maybe_unused]] auto first
+            = co_await database.getAllActiveStationsAsync();
+        firstQueries.fetch_add(1);
+        [[maybe_unused]] auto second
+            = co_await database.getAllActiveStationsAsync();
+    }
+    catch (const std::runtime_error &)
+    {
+        rejectedSecondQueries.fetch_add(1);
+    }
+    done.count_down();
+}
+
+Detached getInvalidBoundingBox(const UMetadata::Database &database,
+                               bool &threw,
+                               std::latch &done)
+{
+    try
+    {
+        [[maybe_unused]] auto stations
+            = co_await database.getActiveStationsInBoundingBoxAsync(
+                 -91, 40, -112, -111);
+    }
+    catch (const std::invalid_argument &)
+    {
+        threw = true;
+    }
+    done.count_down();
+}
+
 }
 
 TEST_CASE("UMetadata::Database", "[sqlite3]")
@@ -73,6 +219,19 @@ TEST_CASE("UMetadata::Database", "[sqlite3]")
 
     // Fail adding
     REQUIRE_NOTHROW(database.insert(activeStationsRef.at(0)));
+    // Fail adding in bulk - including duplicates in the same batch
+    auto duplicates = activeStationsRef;
+    duplicates.push_back(activeStationsRef.at(0));
+    // A malformed station is skipped rather than failing the batch
+    UMetadata::Station malformed;
+    malformed.setNetwork("UU");
+    malformed.setName("BAD");
+    duplicates.push_back(malformed);
+    REQUIRE_NOTHROW(database.insert(duplicates));
+    // Channels attach to their station epochs.  Channels whose stations are
+    // not in the inventory are skipped.
+    REQUIRE_NOTHROW(database.insert(activeChannelsRef));
+    REQUIRE_NOTHROW(database.insert(activeChannelsRef.at(0)));
     database.close();
     
 
@@ -88,6 +247,20 @@ TEST_CASE("UMetadata::Database", "[sqlite3]")
         const bool match = (firstStation && (*firstStation == firstStationRef));
         CHECK(match);
 
+        // Repeatedly query to exercise the rebinding of cached statements
+        for (int pass = 0; pass < 2; ++pass)
+        {
+            for (const auto &stationRef : activeStationsRef)
+            {
+                auto station
+                    = database.getActiveStationInformation(
+                         stationRef.getNetwork(), stationRef.getName());
+                const bool matchRef = (station && (*station == stationRef));
+                CHECK(matchRef);
+            }
+        }
+        CHECK(!database.getActiveStationInformation("ZZ", "NONE"));
+
         auto activeStations = database.getAllActiveStations();
         REQUIRE(activeStations.size() == activeStationsRef.size());
         // Find them all
@@ -142,5 +315,726 @@ TEST_CASE("UMetadata::Database", "[sqlite3]")
         }
     }
 
+    SECTION("Active At")
+    {
+        constexpr bool readOnly{true};
+        const UMetadata::Database database{databaseFile, readOnly};
+        for (const auto time : std::vector<int64_t> {1000000000,
+                                                     1500000000,
+                                                     1760000000})
+        {
+            const std::chrono::seconds queryTime{time};
+            size_t nExpected{0};
+            for (const auto &station : activeStationsRef)
+            {
+                auto [start, end] = station.getStartAndEndTime();
+                if (start <= queryTime && queryTime <= end){nExpected++;}
+            }
+            auto stations = database.getStationsActiveAt(queryTime);
+            CHECK(stations.size() == nExpected);
+            for (const auto &station : stations)
+            {
+                auto [start, end] = station.getStartAndEndTime();
+                CHECK(start <= queryTime);
+                CHECK(queryTime <= end);
+            }
+        }
+    }
+
+    SECTION("Visitor")
+    {
+        constexpr bool readOnly{true};
+        const UMetadata::Database database{databaseFile, readOnly};
+        size_t nVisited{0};
+        database.forEachActiveStation(
+            [&](const UMetadata::Station &station)
+            {
+                bool match{false};
+                for (const auto &refStation : activeStationsRef)
+                {
+                    if (station == refStation)
+                    {
+                        match = true;
+                        break;
+                    }
+                }
+                CHECK(match);
+                nVisited++;
+            });
+        CHECK(nVisited == activeStationsRef.size());
+        // Abandon the query part way through then query again
+        REQUIRE_THROWS(database.forEachActiveStation(
+            [](const UMetadata::Station &)
+            {
+                throw std::runtime_error("Stop");
+            }));
+        nVisited = 0;
+        database.forEachStationActiveAt(std::chrono::seconds {1760000000},
+                                        [&](const UMetadata::Station &)
+                                        {
+                                            nVisited++;
+                                        });
+        CHECK(nVisited ==
+              database.getStationsActiveAt(
+                 std::chrono::seconds {1760000000}).size());
+        REQUIRE_THROWS(database.forEachActiveStation(nullptr));
+    }
+
+    SECTION("Protobuf")
+    {
+        constexpr bool readOnly{true};
+        const UMetadata::Database database{databaseFile, readOnly};
+        UMetadataAPI::V1::StationsResponse response;
+        database.appendActiveStations(&response);
+        auto stations = database.getAllActiveStations();
+        REQUIRE(response.stations_size() ==
+                static_cast<int> (stations.size()));
+        for (int i = 0; i < response.stations_size(); ++i)
+        {
+            // Must match the validated path bit-for-bit
+            CHECK(response.stations(i).SerializeAsString() ==
+                  stations.at(i).toProtobuf().SerializeAsString());
+            const bool match
+                = (UMetadata::Station {response.stations(i)} == stations.at(i));
+            CHECK(match);
+        }
+        REQUIRE_THROWS(database.appendActiveStations(nullptr));
+    }
+
+    SECTION("Query Profile")
+    {
+        constexpr bool readOnly{true};
+        const UMetadata::Database database{databaseFile, readOnly};
+        [[maybe_unused]] auto discard = UMetadata::Database::takeQueryProfile();
+        // Without profiling only the rows are counted
+        REQUIRE(!UMetadata::Database::isQueryProfiling());
+        UMetadataAPI::V1::StationsResponse response;
+        database.appendActiveStations(&response);
+        auto profile = UMetadata::Database::takeQueryProfile();
+        CHECK(profile.rows == static_cast<uint64_t> (response.stations_size()));
+        CHECK(profile.step.count() == 0);
+        CHECK(profile.unpack.count() == 0);
+
+        UMetadata::Database::setQueryProfiling(true);
+        REQUIRE(UMetadata::Database::isQueryProfiling());
+        response.Clear();
+        database.appendActiveStations(&response);
+        profile = UMetadata::Database::takeQueryProfile();
+        CHECK(profile.rows == static_cast<uint64_t> (response.stations_size()));
+        CHECK(profile.step.count() > 0);
+        CHECK(profile.unpack.count() > 0);
+        // Taking the profile resets it
+        profile = UMetadata::Database::takeQueryProfile();
+        CHECK(profile.rows == 0);
+        CHECK(profile.step.count() == 0);
+        CHECK(profile.unpack.count() == 0);
+        // Profiles are kept per thread
+        std::thread([&database]()
+        {
+            UMetadataAPI::V1::StationsResponse other;
+            database.appendActiveStations(&other);
+        }).join();
+        CHECK(UMetadata::Database::takeQueryProfile().rows == 0);
+        UMetadata::Database::setQueryProfiling(false);
+    }
+
+    SECTION("Asynchronous")
+    {
+        UMetadata::DatabaseOptions options;
+        options.setReadConnectionPoolSize(1);
+        options.setAsyncQueryThreads(2);
+        UMetadata::Database reader{databaseFile, true, options};
+        const auto nActive = reader.getAllActiveStations().size();
+        // Many queries are in flight on two threads
+        constexpr int nQueries{16};
+        std::atomic<size_t> count{0};
+        std::latch countsDone{nQueries};
+        for (int i = 0; i < nQueries; ++i)
+        {
+            ::countActiveStations(reader, count, countsDone);
+        }
+        countsDone.wait();
+        CHECK(count.load() == nQueries*nActive);
+
+        std::optional<UMetadata::Station> station;
+        bool threw{false};
+        std::latch stationDone{1};
+        ::getStation(reader, activeStationsRef.at(0), station, threw,
+                     stationDone);
+        stationDone.wait();
+        CHECK(!threw);
+        const bool match = (station && *station == activeStationsRef.at(0));
+        CHECK(match);
+
+        // Errors are rethrown from co_await
+        std::latch errorDone{1};
+        ::getInvalidBoundingBox(reader, threw, errorDone);
+        errorDone.wait();
+        CHECK(threw);
+
+        // Queries cannot be started once the database is closed
+        reader.close();
+        threw = false;
+        std::latch closedDone{1};
+        ::getStation(reader, activeStationsRef.at(0), station, threw,
+                     closedDone);
+        closedDone.wait();
+        CHECK(threw);
+    }
+
+    SECTION("Asynchronous Close")
+    {
+        UMetadata::DatabaseOptions options;
+        options.setAsyncQueryThreads(2);
+        UMetadata::Database reader{databaseFile, true, options};
+        // Occupy both query threads so the chains queue behind them
+        std::latch held{2};
+        std::latch release{1};
+        ::holdQueryThread(reader, held, release);
+        ::holdQueryThread(reader, held, release);
+        held.wait();
+        constexpr int nChains{64};
+        std::atomic<int> firstQueries{0};
+        std::atomic<int> rejectedSecondQueries{0};
+        std::latch chainsDone{nChains};
+        for (int i = 0; i < nChains; ++i)
+        {
+            ::chainQueries(reader, firstQueries, rejectedSecondQueries,
+                           chainsDone);
+        }
+        std::thread closer([&reader]()
+                           {
+                               reader.close();
+                           });
+        // Wait until the close refuses new queries
+        bool closing{false};
+        const auto deadline
+            = std::chrono::steady_clock::now() + std::chrono::seconds {10};
+        while (std::chrono::steady_clock::now() < deadline)
+        {
+            auto rejected = std::make_shared<std::atomic<bool>> (false);
+            ::probeQuery(reader, rejected);
+            if (rejected->load())
+            {
+                closing = true;
+                break;
+            }
+            std::this_thread::yield();
+        }
+        CHECK(closing);
+        // The queued chains drain and each of their second queries fails
+        release.count_down();
+        chainsDone.wait();
+        closer.join();
+        CHECK(firstQueries.load() == nChains);
+        CHECK(rejectedSecondQueries.load() == nChains);
+    }
+
+    SECTION("Channels")
+    {
+        constexpr bool readOnly{true};
+        const UMetadata::Database database{databaseFile, readOnly};
+        const auto now
+            = std::chrono::duration_cast<std::chrono::seconds>
+              (std::chrono::system_clock::now().time_since_epoch());
+        std::vector<UMetadata::Channel> expected;
+        for (const auto &channel : activeChannelsRef)
+        {
+            const auto [startTime, endTime] = channel.getStartAndEndTime();
+            if (startTime > now || endTime < now){continue;}
+            bool haveStation{false};
+            for (const auto &station : activeStationsRef)
+            {
+                const auto [stationStart, stationEnd]
+                    = station.getStartAndEndTime();
+                if (station.getNetwork() == channel.getNetwork() &&
+                    station.getName() == channel.getStation() &&
+                    stationStart <= startTime && stationEnd >= startTime)
+                {
+                    haveStation = true;
+                    break;
+                }
+            }
+            if (haveStation){expected.push_back(channel);}
+        }
+        REQUIRE(!expected.empty());
+        auto channels = database.getAllActiveChannels();
+        REQUIRE(channels.size() == expected.size());
+        std::map<std::string, std::string> channelsByKey;
+        for (const auto &channel : channels)
+        {
+            channelsByKey.insert({channel.getNetwork() + "."
+                                + channel.getStation() + "."
+                                + channel.getName() + "."
+                                + channel.getLocationCode(),
+                                  channel.toProtobuf().SerializeAsString()});
+        }
+        for (const auto &channel : expected)
+        {
+            auto match
+                = channelsByKey.find(channel.getNetwork() + "."
+                                   + channel.getStation() + "."
+                                   + channel.getName() + "."
+                                   + channel.getLocationCode());
+            REQUIRE(match != channelsByKey.end());
+            CHECK(match->second == channel.toProtobuf().SerializeAsString());
+        }
+
+        // Direct decoding must match the validated path
+        UMetadataAPI::V1::ChannelsResponse response;
+        database.appendActiveChannels(&response);
+        REQUIRE(response.channels_size() == static_cast<int> (channels.size()));
+        for (int i = 0; i < response.channels_size(); ++i)
+        {
+            CHECK(response.channels(i).SerializeAsString() ==
+                  channels.at(i).toProtobuf().SerializeAsString());
+        }
+        REQUIRE_THROWS(database.appendActiveChannels(nullptr));
+
+        // NSLC lookup
+        const auto &channelRef = expected.at(0);
+        auto channel
+            = database.getActiveChannelInformation(
+                 channelRef.getNetwork(), channelRef.getStation(),
+                 channelRef.getName(), channelRef.getLocationCode());
+        REQUIRE(channel);
+        CHECK(channel->toProtobuf().SerializeAsString() ==
+              channelRef.toProtobuf().SerializeAsString());
+        CHECK(!database.getActiveChannelInformation(
+                  channelRef.getNetwork(), channelRef.getStation(),
+                  channelRef.getName(), "99"));
+        // Codes are normalized as they are on insertion
+        auto lowerCase = [](std::string code)
+        {
+            std::transform(code.begin(), code.end(), code.begin(), ::tolower);
+            return " " + code;
+        };
+        channel = database.getActiveChannelInformation(
+                     lowerCase(channelRef.getNetwork()),
+                     lowerCase(channelRef.getStation()),
+                     lowerCase(channelRef.getName()),
+                     lowerCase(channelRef.getLocationCode()));
+        REQUIRE(channel);
+        CHECK(channel->getName() == channelRef.getName());
+        for (const auto &blankChannel : expected)
+        {
+            if (blankChannel.getLocationCode() != "--"){continue;}
+            channel = database.getActiveChannelInformation(
+                         blankChannel.getNetwork(), blankChannel.getStation(),
+                         blankChannel.getName(), "  ");
+            REQUIRE(channel);
+            CHECK(channel->getLocationCode() == "--");
+            break;
+        }
+        CHECK_THROWS_AS(database.getActiveChannelInformation(
+                            "", channelRef.getStation(),
+                            channelRef.getName(), "--"),
+                        std::invalid_argument);
+        CHECK_THROWS_AS(database.getActiveChannelInformation(
+                            channelRef.getNetwork(), channelRef.getStation(),
+                            " ", "--"),
+                        std::invalid_argument);
+        CHECK(database.getChannelsActiveAt(std::chrono::seconds {0}).empty());
+    }
+
+    SECTION("Spatial")
+    {
+        constexpr bool readOnly{true};
+        const UMetadata::Database database{databaseFile, readOnly};
+        // Wasatch front
+        auto inBox = database.getActiveStationsInBoundingBox(40, 41.5,
+                                                             -112.5, -111.5);
+        size_t nExpected{0};
+        for (const auto &station : activeStationsRef)
+        {
+            if (station.getLatitude() >= 40 && station.getLatitude() <= 41.5 &&
+                station.getLongitude() >= -112.5 &&
+                station.getLongitude() <= -111.5)
+            {
+                nExpected++;
+            }
+        }
+        CHECK(nExpected > 0);
+        CHECK(inBox.size() == nExpected);
+        for (const auto &station : inBox)
+        {
+            CHECK(station.getLatitude() >= 40);
+            CHECK(station.getLatitude() <= 41.5);
+            CHECK(station.getLongitude() >= -112.5);
+            CHECK(station.getLongitude() <= -111.5);
+        }
+        // Everything and nothing across the antimeridian
+        CHECK(database.getActiveStationsInBoundingBox(-90, 90, -180, 180).size()
+              == activeStationsRef.size());
+        CHECK(database.getActiveStationsInBoundingBox(-90, 90, 170, -170).empty());
+        CHECK(database.getActiveStationsInBoundingBox(-90, 90, -100, -120).empty());
+        CHECK(database.getActiveStationsInBoundingBox(-90, 90, -120, -100).size()
+              == activeStationsRef.size());
+        REQUIRE_THROWS(database.getActiveStationsInBoundingBox(41, 40, 0, 1));
+        REQUIRE_THROWS(database.getActiveStationsInBoundingBox(-91, 40, 0, 1));
+        // Within 50 km of Salt Lake City
+        constexpr double latitude{40.76};
+        constexpr double longitude{-111.89};
+        constexpr double radius{50};
+        auto withinRadius = database.getActiveStationsWithinRadius(latitude,
+                                                                   longitude,
+                                                                   radius);
+        nExpected = 0;
+        for (const auto &station : activeStationsRef)
+        {
+            constexpr double toRadians{std::numbers::pi/180};
+            const double dLatitude
+                = (station.getLatitude() - latitude)*toRadians;
+            const double dLongitude
+                = (station.getLongitude() - longitude)*toRadians;
+            const double a
+                = std::pow(std::sin(dLatitude/2), 2)
+                + std::cos(latitude*toRadians)
+                 *std::cos(station.getLatitude()*toRadians)
+                 *std::pow(std::sin(dLongitude/2), 2);
+            if (2*6371*std::asin(std::sqrt(a)) <= radius){nExpected++;}
+        }
+        CHECK(nExpected > 0);
+        CHECK(withinRadius.size() == nExpected);
+        CHECK(database.getActiveStationsWithinRadius(latitude,
+                                                     longitude + 360,
+                                                     radius).size()
+              == nExpected);
+        CHECK(database.getActiveStationsWithinRadius(-45, 0, 100).empty());
+        REQUIRE_THROWS(database.getActiveStationsWithinRadius(latitude,
+                                                              longitude,
+                                                              -1));
+    }
+
+    SECTION("Change Detection")
+    {
+        constexpr bool readOnly{true};
+        const UMetadata::Database reader{databaseFile, readOnly};
+        const auto version = reader.getDataVersion();
+        CHECK(reader.getDataVersion() == version);
+        {
+            UMetadata::Database writer{databaseFile, false};
+            writer.insert(::createStationsYNP());
+        }
+        CHECK(reader.getDataVersion() != version);
+
+        const std::chrono::seconds time{1500000000};
+        std::optional<std::chrono::seconds> expected;
+        std::vector<std::pair<std::chrono::seconds, std::chrono::seconds>>
+            epochs;
+        // Only channels attached to a Utah station epoch were inserted
+        for (const auto &channel : activeChannelsRef)
+        {
+            const auto channelEpoch = channel.getStartAndEndTime();
+            for (const auto &station : activeStationsRef)
+            {
+                auto [start, end] = station.getStartAndEndTime();
+                if (station.getNetwork() == channel.getNetwork() &&
+                    station.getName() == channel.getStation() &&
+                    start <= channelEpoch.first && end >= channelEpoch.first)
+                {
+                    epochs.push_back(channelEpoch);
+                    break;
+                }
+            }
+        }
+        for (const auto &station : ::createStationsYNP())
+        {
+            activeStationsRef.push_back(station);
+        }
+        for (const auto &station : activeStationsRef)
+        {
+            epochs.push_back(station.getStartAndEndTime());
+        }
+        for (const auto &[start, end] : epochs)
+        {
+            std::optional<std::chrono::seconds> boundary;
+            if (start > time)
+            {
+                boundary = start;
+            }
+            else if (end >= time)
+            {
+                boundary = end + std::chrono::seconds {1};
+            }
+            if (boundary && (!expected || *boundary < *expected))
+            {
+                expected = boundary;
+            }
+        }
+        auto boundary = reader.getNextEpochBoundary(time);
+        REQUIRE(boundary);
+        CHECK(*boundary == *expected);
+        CHECK(!reader.getNextEpochBoundary(std::chrono::seconds {99999999999}));
+    }
+
+    SECTION("Upsert")
+    {
+        auto stations = activeStationsRef;
+        const auto newer = stations.at(0).getLastModified()
+                         + std::chrono::microseconds {1000000};
+        // Corrected coordinates
+        stations.at(0).setLatitude(stations.at(0).getLatitude() + 0.01);
+        stations.at(0).setLastModified(newer);
+        // Closed epoch
+        auto [startTime, endTime] = stations.at(1).getStartAndEndTime();
+        const std::chrono::seconds closeTime{startTime.count() + 86400};
+        stations.at(1).setStartAndEndTime(std::pair {startTime, closeTime});
+        stations.at(1).setLastModified(
+            stations.at(1).getLastModified() + std::chrono::microseconds {1});
+        // A change that is not newer is ignored
+        const auto staleLatitude = stations.at(2).getLatitude();
+        stations.at(2).setLatitude(staleLatitude + 0.01);
+        // New epochs
+        const auto ynp = ::createStationsYNP();
+        stations.insert(stations.end(), ynp.begin(), ynp.end());
+        // A malformed station is skipped rather than failing the upsert
+        UMetadata::Station malformed;
+        malformed.setNetwork("UU");
+        malformed.setName("BAD");
+        stations.push_back(malformed);
+
+        UMetadata::Database writer{databaseFile, false};
+        auto summary = writer.upsert(stations);
+        CHECK(summary.inserted == ynp.size());
+        CHECK(summary.changed == 1);
+        CHECK(summary.closed == 1);
+        CHECK(summary.unchanged == activeStationsRef.size() - 2);
+        CHECK(summary.skipped == 1);
+        // Idempotent
+        summary = writer.upsert(stations);
+        CHECK(summary.inserted == 0);
+        CHECK(summary.changed == 0);
+        CHECK(summary.closed == 0);
+        CHECK(summary.unchanged == stations.size() - 1);
+        CHECK(summary.skipped == 1);
+        writer.close();
+
+        constexpr bool readOnly{true};
+        const UMetadata::Database database{databaseFile, readOnly};
+        auto corrected
+            = database.getActiveStationInformation(
+                 stations.at(0).getNetwork(), stations.at(0).getName());
+        REQUIRE(corrected);
+        CHECK(std::abs(corrected->getLatitude()
+                     - stations.at(0).getLatitude()) < 1.e-10);
+        CHECK(corrected->getLastModified() == newer);
+        CHECK(!database.getActiveStationInformation(
+                 stations.at(1).getNetwork(), stations.at(1).getName()));
+        auto stale
+            = database.getActiveStationInformation(
+                 stations.at(2).getNetwork(), stations.at(2).getName());
+        REQUIRE(stale);
+        CHECK(std::abs(stale->getLatitude() - staleLatitude) < 1.e-10);
+        CHECK(database.getAllActiveStations().size() ==
+              activeStationsRef.size() - 1 + ynp.size());
+        UMetadata::Database reader{databaseFile, readOnly};
+        REQUIRE_THROWS(reader.upsert(stations));
+    }
+
+    SECTION("Serving Modes")
+    {
+        constexpr bool readOnly{true};
+        UMetadata::DatabaseOptions options;
+        options.setReadConnectionPoolSize(2);
+        options.setCacheSize(8*1024*1024);
+        for (const auto mode : {UMetadata::DatabaseOptions::ServingMode::File,
+                                UMetadata::DatabaseOptions::ServingMode::MemoryMapped,
+                                UMetadata::DatabaseOptions::ServingMode::InMemory})
+        {
+            options.setServingMode(mode);
+            const UMetadata::Database database{databaseFile, readOnly, options};
+            CHECK(database.getAllActiveStations().size() ==
+                  activeStationsRef.size());
+            auto station
+                = database.getActiveStationInformation(
+                     activeStationsRef.at(0).getNetwork(),
+                     activeStationsRef.at(0).getName());
+            const bool match = (station && *station == activeStationsRef.at(0));
+            CHECK(match);
+            CHECK(!database.getActiveStationsWithinRadius(40.76, -111.89, 50)
+                           .empty());
+        }
+        // The in-memory copy is a snapshot; later writes go to the file only
+        options.setServingMode(UMetadata::DatabaseOptions::ServingMode::InMemory);
+        const UMetadata::Database snapshot{databaseFile, readOnly, options};
+        const UMetadata::Database second{databaseFile, readOnly, options};
+        {
+            UMetadata::Database writer{databaseFile, false, options};
+            writer.insert(::createStationsYNP());
+        }
+        CHECK(snapshot.getAllActiveStations().size() ==
+              activeStationsRef.size());
+        CHECK(second.getAllActiveStations().size() ==
+              activeStationsRef.size());
+    }
+
+    SECTION("Parallel Reads")
+    {
+        UMetadata::DatabaseOptions options;
+        options.setReadConnectionPoolSize(4);
+        const UMetadata::Database reader{databaseFile, true, options};
+        std::vector<std::thread> threads;
+        std::atomic<int> nMatches{0};
+        for (int i = 0; i < 8; ++i)
+        {
+            threads.emplace_back([&]()
+            {
+                for (const auto &stationRef : activeStationsRef)
+                {
+                    auto station
+                        = reader.getActiveStationInformation(
+                             stationRef.getNetwork(), stationRef.getName());
+                    if (station && *station == stationRef){nMatches++;}
+                }
+            });
+        }
+        for (auto &thread : threads){thread.join();}
+        CHECK(nMatches.load() ==
+              8*static_cast<int> (activeStationsRef.size()));
+    }
+
+    SECTION("Concurrent Read and Write")
+    {
+        UMetadata::DatabaseOptions options;
+        options.setJournalMode(UMetadata::DatabaseOptions::JournalMode::WAL);
+        options.setBusyTimeout(std::chrono::milliseconds {1000});
+        const auto nStations = activeStationsRef.size();
+        const auto nAllStations = nStations + ::createStationsYNP().size();
+        UMetadata::Database reader{databaseFile, true, options};
+        std::thread writer([&]()
+        {
+            UMetadata::Database writeDatabase{databaseFile, false, options};
+            writeDatabase.insert(::createStationsYNP());
+            writeDatabase.close();
+        });
+        // Readers always see either the old or the new snapshot
+        for (int i = 0; i < 50; ++i)
+        {
+            auto nActive = reader.getAllActiveStations().size();
+            CHECK(nActive >= nStations);
+            CHECK(nActive <= nAllStations);
+        }
+        writer.join();
+        CHECK(reader.getAllActiveStations().size() > nStations);
+    }
+
+}
+
+TEST_CASE("UMetadata::Database Schema Migration", "[sqlite3]")
+{
+    const std::filesystem::path databaseFile{"legacy.sqlite3"};
+    if (std::filesystem::exists(databaseFile))
+    {
+        std::filesystem::remove(databaseFile);
+    }
+    {
+        UMetadata::Database database{databaseFile, false};
+        database.insert(::createStationsUtah());
+        database.close();
+    }
+    // Recreate what older versions wrote: an unversioned database whose
+    // channel table only admits a dip of -90
+    const std::string insertChannel{
+        "INSERT INTO channel (station_identifier, name, location_code, "
+        "latitude, longitude, elevation, sampling_rate, azimuth, dip, "
+        "start_time) VALUES ((SELECT MIN(identifier) FROM station), "};
+    sqlite3 *handle{nullptr};
+    REQUIRE(sqlite3_open(databaseFile.c_str(), &handle) == SQLITE_OK);
+    REQUIRE(::execute(handle, R"""(
+DROP TABLE channel_epoch;
+DROP TABLE channel;
+CREATE TABLE channel (
+  identifier INTEGER PRIMARY KEY AUTOINCREMENT,
+  station_identifier INTEGER,
+  name TEXT,
+  location_code TEXT DEFAULT NULL,
+  latitude DOUBLE NOT NULL CHECK( latitude >= -90 AND latitude <= 90),
+  longitude DOUBLE NOT NULL,
+  elevation DOUBLE NOT NULL CHECK( elevation >= -10000 AND elevation <= 8600 ),
+  sampling_rate DOUBLE NOT NULL CHECK ( sampling_rate > 0 ),
+  azimuth DOUBLE CHECK( azimuth >= 0 AND azimuth < 360 ),
+  dip DOUBLE CHECK( dip >= -90 AND dip <= -90 ),
+  start_time BIGINT NOT NULL,
+  end_time BIGINT DEFAULT 32503680000 CHECK (end_time > start_time),
+  last_modified DOUBLE DEFAULT CURRENT_TIMESTAMP,
+  UNIQUE(station_identifier, name, location_code, start_time),
+  FOREIGN KEY(station_identifier) REFERENCES station(identifier)
+);
+PRAGMA user_version = 0;
+)"""));
+    REQUIRE(::execute(handle,
+                      insertChannel + "'HHZ', '01', 40, -112, 1500, 100, 0, -90, 0)"));
+    CHECK(!::execute(handle,
+                     insertChannel + "'HHN', '01', 40, -112, 1500, 100, 0, 0, 0)"));
+    sqlite3_close(handle);
+
+    // Opening the database for writing migrates it
+    {
+        UMetadata::Database database{databaseFile, false};
+        database.close();
+    }
+    REQUIRE(sqlite3_open(databaseFile.c_str(), &handle) == SQLITE_OK);
+    CHECK(::queryInteger(handle, "PRAGMA user_version") == 1);
+    // The existing channel is kept, and is indexed, and other dips fit
+    CHECK(::queryInteger(handle, "SELECT COUNT(*) FROM channel") == 1);
+    CHECK(::queryInteger(handle, "SELECT COUNT(*) FROM channel_epoch") == 1);
+    CHECK(::execute(handle,
+                    insertChannel + "'HHN', '01', 40, -112, 1500, 100, 0, 0, 0)"));
+    CHECK(::queryInteger(handle, "SELECT COUNT(*) FROM channel_epoch") == 2);
+    sqlite3_close(handle);
+
+    // A current database is left alone
+    {
+        UMetadata::Database database{databaseFile, false};
+        database.close();
+    }
+    REQUIRE(sqlite3_open(databaseFile.c_str(), &handle) == SQLITE_OK);
+    CHECK(::queryInteger(handle, "PRAGMA user_version") == 1);
+    CHECK(::queryInteger(handle, "SELECT COUNT(*) FROM channel") == 2);
+    sqlite3_close(handle);
+    std::filesystem::remove(databaseFile);
 }
 
+TEST_CASE("UMetadata::Database Decoding", "[.][benchmark]")
+{
+    const std::filesystem::path databaseFile{"benchmark.sqlite3"};
+    if (std::filesystem::exists(databaseFile))
+    {
+        std::filesystem::remove(databaseFile);
+    }
+    {
+        UMetadata::Database writer{databaseFile, false};
+        writer.insert(::createStationsUtah());
+        writer.insert(::createStationsYNP());
+    }
+    constexpr bool readOnly{true};
+    const UMetadata::Database database{databaseFile, readOnly};
+
+    BENCHMARK("Station then protobuf")
+    {
+        UMetadataAPI::V1::StationsResponse response;
+        for (const auto &station : database.getAllActiveStations())
+        {
+            *response.add_stations() = station.toProtobuf();
+        }
+        return response.stations_size();
+    };
+
+    BENCHMARK("Direct to protobuf")
+    {
+        UMetadataAPI::V1::StationsResponse response;
+        database.appendActiveStations(&response);
+        return response.stations_size();
+    };
+
+    BENCHMARK("Direct to arena protobuf")
+    {
+        google::protobuf::Arena arena;
+        auto response
+            = google::protobuf::Arena::Create
+              <UMetadataAPI::V1::StationsResponse> (&arena);
+        database.appendActiveStations(response);
+        return response->stations_size();
+    };
+}
@@ -0,0 +1,262 @@
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <latch>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "databaseExecutor.hpp"
+#include <catch2/catch_test_macros.hpp>
+
+TEST_CASE("UMetadata::DatabaseExecutor", "[databaseExecutor]")
+{
+    SECTION("Construction")
+    {
+        REQUIRE_THROWS(::DatabaseExecutor(0, 1));
+        REQUIRE_THROWS(::DatabaseExecutor(1, 0));
+    }
+
+    SECTION("Bounded Queue")
+    {
+        ::DatabaseExecutor executor{1, 2};
+        std::latch running{1};
+        std::latch release{1};
+        REQUIRE(executor.submit([&]()
+                                {
+                                    running.count_down();
+                                    release.wait();
+                                },
+                                ::RequestClass::Lookup));
+        // The only worker is busy so these wait
+        running.wait();
+        std::atomic<int> ran{0};
+        CHECK(executor.submit([&ran](){++ran;}, ::RequestClass::Lookup));
+        CHECK(executor.submit([&ran](){++ran;}, ::RequestClass::Inventory));
+        // Lookups and inventories share the limit
+        CHECK(!executor.submit([&ran](){++ran;}, ::RequestClass::Lookup));
+        CHECK(!executor.submit([&ran](){++ran;}, ::RequestClass::Inventory));
+        release.count_down();
+        // The queue empties out so there is room again
+        std::promise<void> done;
+        while (!executor.submit([&done](){done.set_value();},
+                                ::RequestClass::Lookup))
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds {1});
+        }
+        done.get_future().wait();
+        CHECK(ran == 2);
+    }
+
+    SECTION("Lookups First")
+    {
+        // With one worker the queued lookups go ahead of earlier inventories
+        ::DatabaseExecutor executor{1, 8};
+        std::latch running{1};
+        std::latch release{1};
+        REQUIRE(executor.submit([&]()
+                                {
+                                    running.count_down();
+                                    release.wait();
+                                },
+                                ::RequestClass::Inventory));
+        running.wait();
+        std::mutex orderMutex;
+        std::vector<std::string> order;
+        const auto record = [&](const std::string &name)
+        {
+            return [&orderMutex, &order, name]()
+            {
+                const std::lock_guard<std::mutex> lock(orderMutex);
+                order.push_back(name);
+            };
+        };
+        REQUIRE(executor.submit(record("inventory1"),
+                                ::RequestClass::Inventory));
+        REQUIRE(executor.submit(record("lookup1"), ::RequestClass::Lookup));
+        REQUIRE(executor.submit(record("inventory2"),
+                                ::RequestClass::Inventory));
+        REQUIRE(executor.submit(record("lookup2"), ::RequestClass::Lookup));
+        std::promise<void> done;
+        REQUIRE(executor.submit([&done](){done.set_value();},
+                                ::RequestClass::Inventory));
+        release.count_down();
+        done.get_future().wait();
+        const std::vector<std::string> expected{"lookup1",
+                                                "lookup2",
+                                                "inventory1",
+                                                "inventory2"};
+        CHECK(order == expected);
+    }
+
+    SECTION("Reserved Worker")
+    {
+        // With two workers at most one inventory runs at a time so a lookup
+        // never waits behind inventories
+        ::DatabaseExecutor executor{2, 8};
+        std::latch running{1};
+        std::latch release{1};
+        REQUIRE(executor.submit([&]()
+                                {
+                                    running.count_down();
+                                    release.wait();
+                                },
+                                ::RequestClass::Inventory));
+        running.wait();
+        std::atomic<bool> secondInventoryRan{false};
+        REQUIRE(executor.submit([&secondInventoryRan]()
+                                {
+                                    secondInventoryRan = true;
+                                },
+                                ::RequestClass::Inventory));
+        std::promise<void> lookupRan;
+        REQUIRE(executor.submit([&lookupRan](){lookupRan.set_value();},
+                                ::RequestClass::Lookup));
+        const auto lookupStatus
+            = lookupRan.get_future().wait_for(std::chrono::seconds {10});
+        // Give the idle worker a chance to (wrongly) take the inventory
+        std::this_thread::sleep_for(std::chrono::milliseconds {50});
+        const bool ranEarly = secondInventoryRan;
+        release.count_down();
+        CHECK(lookupStatus == std::future_status::ready);
+        CHECK(!ranEarly);
+    }
+
+    SECTION("Failed Work")
+    {
+        // A throw does not take down the worker
+        ::DatabaseExecutor executor{1, 4};
+        REQUIRE(executor.submit([](){throw std::runtime_error("Failed");},
+                                ::RequestClass::Lookup));
+        std::promise<void> done;
+        REQUIRE(executor.submit([&done](){done.set_value();},
+                                ::RequestClass::Lookup));
+        CHECK(done.get_future().wait_for(std::chrono::seconds {10})
+              == std::future_status::ready);
+    }
+
+    SECTION("Drains Queue On Destruction")
+    {
+        std::atomic<int> ran{0};
+        {
+            ::DatabaseExecutor executor{2, 64};
+            for (int i = 0; i < 64; ++i)
+            {
+                REQUIRE(executor.submit([&ran]()
+                        {
+                            std::this_thread::sleep_for(
+                                std::chrono::microseconds {100});
+                            ++ran;
+                        },
+                        i%2 == 0 ? ::RequestClass::Lookup :
+                                   ::RequestClass::Inventory));
+            }
+        }
+        CHECK(ran == 64);
+    }
+}
+
+TEST_CASE("UMetadata::DatabaseExecutor Calls", "[databaseExecutor]")
+{
+    SECTION("Runs Work")
+    {
+        ::DatabaseExecutor executor{1, 4};
+        std::promise<grpc::Status> finished;
+        const auto accepted
+            = ::runOnExecutor(executor,
+                              ::RequestClass::Lookup,
+                              [](){return false;},
+                              []()
+                              {
+                                  return grpc::Status{grpc::StatusCode::NOT_FOUND,
+                                                      "No such station"};
+                              },
+                              [&finished](const grpc::Status &status)
+                              {
+                                  finished.set_value(status);
+                              });
+        REQUIRE(accepted);
+        const auto status = finished.get_future().get();
+        CHECK(status.error_code() == grpc::StatusCode::NOT_FOUND);
+        CHECK(status.error_message() == "No such station");
+    }
+
+    SECTION("Skips Cancelled Calls")
+    {
+        ::DatabaseExecutor executor{1, 4};
+        std::atomic<bool> ran{false};
+        std::promise<grpc::Status> finished;
+        REQUIRE(::runOnExecutor(executor,
+                                ::RequestClass::Inventory,
+                                [](){return true;},
+                                [&ran]()
+                                {
+                                    ran = true;
+                                    return grpc::Status::OK;
+                                },
+                                [&finished](const grpc::Status &status)
+                                {
+                                    finished.set_value(status);
+                                }));
+        CHECK(finished.get_future().get().error_code()
+              == grpc::StatusCode::CANCELLED);
+        CHECK(!ran);
+    }
+
+    SECTION("Failed Work")
+    {
+        ::DatabaseExecutor executor{1, 4};
+        std::promise<grpc::Status> finished;
+        REQUIRE(::runOnExecutor(executor,
+                                ::RequestClass::Lookup,
+                                [](){return false;},
+                                []() -> grpc::Status
+                                {
+                                    throw std::runtime_error("Disk I/O error");
+                                },
+                                [&finished](const grpc::Status &status)
+                                {
+                                    finished.set_value(status);
+                                }));
+        CHECK(finished.get_future().get().error_code()
+              == grpc::StatusCode::UNKNOWN);
+    }
+
+    SECTION("Queue Full")
+    {
+        ::DatabaseExecutor executor{1, 1};
+        std::latch running{1};
+        std::latch release{1};
+        REQUIRE(executor.submit([&]()
+                                {
+                                    running.count_down();
+                                    release.wait();
+                                },
+                                ::RequestClass::Lookup));
+        running.wait();
+        REQUIRE(executor.submit([](){}, ::RequestClass::Lookup));
+        // The call is finished right away on this thread and never run
+        std::atomic<bool> ran{false};
+        std::optional<grpc::Status> finished;
+        const auto accepted
+            = ::runOnExecutor(executor,
+                              ::RequestClass::Lookup,
+                              [](){return false;},
+                              [&ran]()
+                              {
+                                  ran = true;
+                                  return grpc::Status::OK;
+                              },
+                              [&finished](const grpc::Status &status)
+                              {
+                                  finished = status;
+                              });
+        release.count_down();
+        CHECK(!accepted);
+        REQUIRE(finished);
+        CHECK(finished->error_code() == grpc::StatusCode::RESOURCE_EXHAUSTED);
+        CHECK(!ran);
+    }
+}
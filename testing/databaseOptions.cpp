@@ -0,0 +1,45 @@
+#include <chrono>
+#include "uMetadata/databaseOptions.hpp"
+#include <catch2/catch_test_macros.hpp>
+
+TEST_CASE("UMetadata::DatabaseOptions", "[databaseOptions]")
+{
+    UMetadata::DatabaseOptions options;
+    REQUIRE(options.getJournalMode() ==
+            UMetadata::DatabaseOptions::JournalMode::WAL);
+    REQUIRE(options.getBusyTimeout() == std::chrono::milliseconds {5000});
+    REQUIRE(options.getReadConnectionPoolSize() >= 1);
+    REQUIRE(options.getAsyncQueryThreads() == 2);
+    REQUIRE(options.getServingMode() ==
+            UMetadata::DatabaseOptions::ServingMode::File);
+    REQUIRE(options.getMemoryMapSize() == 256*1024*1024);
+    REQUIRE(options.getCacheSize() == 0);
+
+    const std::chrono::milliseconds busyTimeout{250};
+    options.setJournalMode(UMetadata::DatabaseOptions::JournalMode::Delete);
+    REQUIRE_NOTHROW(options.setBusyTimeout(busyTimeout));
+    REQUIRE_THROWS(options.setBusyTimeout(std::chrono::milliseconds {-1}));
+    REQUIRE_NOTHROW(options.setReadConnectionPoolSize(3));
+    REQUIRE_THROWS(options.setReadConnectionPoolSize(0));
+    REQUIRE_NOTHROW(options.setAsyncQueryThreads(4));
+    REQUIRE_THROWS(options.setAsyncQueryThreads(0));
+    options.setServingMode(UMetadata::DatabaseOptions::ServingMode::InMemory);
+    REQUIRE_NOTHROW(options.setMemoryMapSize(1024*1024));
+    REQUIRE_THROWS(options.setMemoryMapSize(0));
+    REQUIRE_NOTHROW(options.setCacheSize(16*1024*1024));
+    REQUIRE_THROWS(options.setCacheSize(-1));
+
+    SECTION("Copy")
+    {
+        UMetadata::DatabaseOptions copy{options};
+        REQUIRE(copy.getJournalMode() ==
+                UMetadata::DatabaseOptions::JournalMode::Delete);
+        REQUIRE(copy.getBusyTimeout() == busyTimeout);
+        REQUIRE(copy.getReadConnectionPoolSize() == 3);
+        REQUIRE(copy.getAsyncQueryThreads() == 4);
+        REQUIRE(copy.getServingMode() ==
+                UMetadata::DatabaseOptions::ServingMode::InMemory);
+        REQUIRE(copy.getMemoryMapSize() == 1024*1024);
+        REQUIRE(copy.getCacheSize() == 16*1024*1024);
+    }
+}
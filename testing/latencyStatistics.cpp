@@ -0,0 +1,212 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <numeric>
+#include <string>
+#include <thread>
+#include <vector>
+#include "latencyStatistics.hpp"
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_floating_point.hpp>
+
+namespace
+{
+[[nodiscard]] std::vector<uint64_t> getCounts(const ::LatencyHistogram &histogram,
+                                              uint64_t *nSamples = nullptr)
+{
+    std::vector<uint64_t> counts;
+    uint64_t total{0};
+    uint64_t maximum{0};
+    histogram.addTo(counts, total, maximum);
+    if (nSamples)
+    {
+        *nSamples = std::accumulate(counts.begin(), counts.end(), uint64_t {0});
+    }
+    return counts;
+}
+
+[[nodiscard]] size_t countNonEmptyBins(const std::vector<uint64_t> &counts)
+{
+    return static_cast<size_t>
+           (std::count_if(counts.begin(), counts.end(),
+                          [](const uint64_t count){return count > 0;}));
+}
+}
+
+TEST_CASE("UMetadata::LatencyHistogram", "[latencyStatistics]")
+{
+    SECTION("Empty")
+    {
+        const ::LatencyHistogram histogram;
+        uint64_t nSamples{0};
+        const auto counts = ::getCounts(histogram, &nSamples);
+        CHECK(nSamples == 0);
+        CHECK(::LatencyHistogram::getPercentile(counts, nSamples, 50) == 0);
+    }
+
+    SECTION("Exact Below 128 ns")
+    {
+        ::LatencyHistogram histogram;
+        for (int64_t value = 0; value < 128; ++value)
+        {
+            histogram.record(std::chrono::nanoseconds {value});
+        }
+        uint64_t nSamples{0};
+        const auto counts = ::getCounts(histogram, &nSamples);
+        REQUIRE(nSamples == 128);
+        // Every value gets its own bin
+        CHECK(::countNonEmptyBins(counts) == 128);
+        for (size_t i = 0; i < 128; ++i)
+        {
+            CHECK(::LatencyHistogram::toValue(i) == static_cast<double> (i));
+        }
+        // The 64th of 128 samples is 63 ns
+        CHECK(::LatencyHistogram::getPercentile(counts, nSamples, 50) == 63);
+        CHECK(::LatencyHistogram::getPercentile(counts, nSamples, 100) == 127);
+        // Any percentile selects at least the first sample
+        CHECK(::LatencyHistogram::getPercentile(counts, nSamples, 0) == 0);
+    }
+
+    SECTION("Bin Boundaries")
+    {
+        // 128 and 129 ns share a bin which is represented by its midpoint
+        ::LatencyHistogram histogram;
+        histogram.record(std::chrono::nanoseconds {128});
+        histogram.record(std::chrono::nanoseconds {129});
+        uint64_t nSamples{0};
+        auto counts = ::getCounts(histogram, &nSamples);
+        CHECK(::countNonEmptyBins(counts) == 1);
+        CHECK(::LatencyHistogram::getPercentile(counts, nSamples, 50) == 128.5);
+        // 130 ns starts the next bin
+        histogram.record(std::chrono::nanoseconds {130});
+        counts = ::getCounts(histogram, &nSamples);
+        CHECK(::countNonEmptyBins(counts) == 2);
+        CHECK(::LatencyHistogram::getPercentile(counts, nSamples, 100) == 130.5);
+        // Likewise the last value of a power of two and the next one
+        ::LatencyHistogram powers;
+        powers.record(std::chrono::nanoseconds {1023});
+        powers.record(std::chrono::nanoseconds {1024});
+        counts = ::getCounts(powers, &nSamples);
+        CHECK(::countNonEmptyBins(counts) == 2);
+        CHECK(::LatencyHistogram::getPercentile(counts, nSamples, 50) == 1019.5);
+        CHECK(::LatencyHistogram::getPercentile(counts, nSamples, 100) == 1031.5);
+    }
+
+    SECTION("Relative Accuracy")
+    {
+        for (const int64_t value : {int64_t {200},
+                                    int64_t {12345},
+                                    int64_t {987654321},
+                                    int64_t {60'000'000'000}})
+        {
+            ::LatencyHistogram histogram;
+            histogram.record(std::chrono::nanoseconds {value});
+            uint64_t nSamples{0};
+            const auto counts = ::getCounts(histogram, &nSamples);
+            const auto estimate
+                = ::LatencyHistogram::getPercentile(counts, nSamples, 50);
+            CHECK_THAT(estimate,
+                       Catch::Matchers::WithinRel(static_cast<double> (value),
+                                                  1./64));
+        }
+    }
+
+    SECTION("Percentiles")
+    {
+        ::LatencyHistogram histogram;
+        for (int64_t value = 1; value <= 100000; ++value)
+        {
+            histogram.record(std::chrono::nanoseconds {value});
+        }
+        std::vector<uint64_t> counts;
+        uint64_t total{0};
+        uint64_t maximum{0};
+        histogram.addTo(counts, total, maximum);
+        CHECK(total == 100000ULL*100001ULL/2);
+        CHECK(maximum == 100000);
+        constexpr uint64_t nSamples{100000};
+        CHECK_THAT(::LatencyHistogram::getPercentile(counts, nSamples, 50),
+                   Catch::Matchers::WithinRel(50000., 0.02));
+        CHECK_THAT(::LatencyHistogram::getPercentile(counts, nSamples, 99),
+                   Catch::Matchers::WithinRel(99000., 0.02));
+        CHECK_THAT(::LatencyHistogram::getPercentile(counts, nSamples, 99.9),
+                   Catch::Matchers::WithinRel(99900., 0.02));
+        // Merging adds the counts
+        histogram.addTo(counts, total, maximum);
+        CHECK(std::accumulate(counts.begin(), counts.end(), uint64_t {0})
+              == 2*nSamples);
+    }
+
+    SECTION("Clamping")
+    {
+        ::LatencyHistogram histogram;
+        histogram.record(std::chrono::nanoseconds {-5});
+        histogram.record(std::chrono::hours {24});
+        std::vector<uint64_t> counts;
+        uint64_t total{0};
+        uint64_t maximum{0};
+        histogram.addTo(counts, total, maximum);
+        // Negative times are zero and long ones are capped at about 18 min
+        CHECK(counts.at(0) == 1);
+        CHECK(counts.back() == 1);
+        CHECK(maximum == (uint64_t {1} << 40U) - 1);
+        CHECK(total == maximum);
+    }
+}
+
+TEST_CASE("UMetadata::LatencyStatistics", "[latencyStatistics]")
+{
+    SECTION("Operation Names")
+    {
+        for (size_t i = 0; i < OPERATION_NAMES.size(); ++i)
+        {
+            const auto operation = ::toOperation(OPERATION_NAMES[i]);
+            REQUIRE(operation);
+            CHECK(static_cast<size_t> (*operation) == i);
+        }
+        CHECK(!::toOperation("NotAnRPC"));
+        CHECK(!::toOperation(""));
+    }
+
+    SECTION("Merges Threads")
+    {
+        // The statistics are process-wide so use an operation nothing else
+        // in the tests records
+        auto &statistics = ::LatencyStatistics::getInstance();
+        statistics.record(::Operation::ActiveChannelsSnapshot,
+                          ::Stage::Total,
+                          std::chrono::microseconds {100});
+        std::thread([&statistics]()
+        {
+            statistics.record(::Operation::ActiveChannelsSnapshot,
+                              ::Stage::Total,
+                              std::chrono::microseconds {300});
+            statistics.record(::Operation::ActiveChannelsSnapshot,
+                              ::Stage::Serialization,
+                              std::chrono::microseconds {10});
+        }).join();
+
+        UMetadataAPI::V1::ServerStatisticsResponse response;
+        statistics.fill(&response);
+        CHECK(response.start_time().seconds() > 0);
+        bool found{false};
+        for (const auto &operation : response.operations())
+        {
+            // Operations without samples are omitted
+            CHECK(operation.stages_size() > 0);
+            if (operation.operation() != "ActiveChannelsSnapshot"){continue;}
+            found = true;
+            REQUIRE(operation.stages_size() == 2);
+            const auto &total = operation.stages(0);
+            CHECK(total.stage() == "total");
+            CHECK(total.count() == 2);
+            CHECK_THAT(total.mean(), Catch::Matchers::WithinRel(200., 0.02));
+            CHECK_THAT(total.p50(), Catch::Matchers::WithinRel(100., 0.02));
+            CHECK_THAT(total.p99(), Catch::Matchers::WithinRel(300., 0.02));
+            CHECK(total.maximum() == 300);
+            CHECK(operation.stages(1).stage() == "serialization");
+            CHECK(operation.stages(1).count() == 1);
+        }
+        CHECK(found);
+    }
+}
@@ -0,0 +1,271 @@
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <tuple>
+#include <vector>
+#include <opentelemetry/sdk/common/exporter_utils.h>
+#include <opentelemetry/sdk/metrics/data/metric_data.h>
+#include <opentelemetry/sdk/metrics/export/metric_producer.h>
+#include <opentelemetry/sdk/metrics/instruments.h>
+#include "metrics.hpp"
+#include <catch2/catch_test_macros.hpp>
+
+namespace
+{
+
+/// Holds what the stand-in collector received.
+struct Received
+{
+    std::mutex mutex;
+    std::vector<opentelemetry::sdk::metrics::MetricData> metrics;
+};
+
+/// @brief Stands in for an OTLP collector by keeping what it is sent.
+class StandInCollector final :
+    public opentelemetry::sdk::metrics::PushMetricExporter
+{
+public:
+    explicit StandInCollector(std::shared_ptr<Received> received) :
+        mReceived(std::move(received))
+    {
+    }
+    opentelemetry::sdk::common::ExportResult
+        Export(const opentelemetry::sdk::metrics::ResourceMetrics &data) noexcept override
+    {
+        const std::lock_guard<std::mutex> lock(mReceived->mutex);
+        for (const auto &scope : data.scope_metric_data_)
+        {
+            for (const auto &metric : scope.metric_data_)
+            {
+                mReceived->metrics.push_back(metric);
+            }
+        }
+        return opentelemetry::sdk::common::ExportResult::kSuccess;
+    }
+    opentelemetry::sdk::metrics::AggregationTemporality
+        GetAggregationTemporality(
+            opentelemetry::sdk::metrics::InstrumentType) const noexcept override
+    {
+        return opentelemetry::sdk::metrics::AggregationTemporality::kCumulative;
+    }
+    bool ForceFlush(std::chrono::microseconds) noexcept override
+    {
+        return true;
+    }
+    bool Shutdown(std::chrono::microseconds) noexcept override
+    {
+        return true;
+    }
+private:
+    std::shared_ptr<Received> mReceived;
+};
+
+[[nodiscard]] const opentelemetry::sdk::metrics::MetricData *
+    findMetric(const std::vector<opentelemetry::sdk::metrics::MetricData> &metrics,
+               const std::string &name)
+{
+    // The collector gets cumulative values so the last export is current
+    const auto metric
+        = std::find_if(metrics.rbegin(), metrics.rend(),
+                       [&name](const auto &candidate)
+                       {
+                           return candidate.instrument_descriptor.name_
+                               == name;
+                       });
+    return metric == metrics.rend() ? nullptr : &*metric;
+}
+
+[[nodiscard]] std::string getString(
+    const opentelemetry::sdk::metrics::PointAttributes &attributes,
+    const std::string &key)
+{
+    const auto value = attributes.find(key);
+    if (value == attributes.end()){return "";}
+    return opentelemetry::nostd::get<std::string> (value->second);
+}
+
+[[nodiscard]] int64_t getSum(
+    const opentelemetry::sdk::metrics::PointDataAttributes &point)
+{
+    const auto &sum
+        = opentelemetry::nostd::get<opentelemetry::sdk::metrics::SumPointData>
+          (point.point_data);
+    return opentelemetry::nostd::holds_alternative<int64_t> (sum.value_) ?
+           opentelemetry::nostd::get<int64_t> (sum.value_) :
+           static_cast<int64_t> (opentelemetry::nostd::get<double> (sum.value_));
+}
+
+[[nodiscard]] uint64_t getCount(
+    const opentelemetry::sdk::metrics::PointDataAttributes &point)
+{
+    return opentelemetry::nostd::get<
+              opentelemetry::sdk::metrics::HistogramPointData>
+           (point.point_data).count_;
+}
+
+}
+
+TEST_CASE("UMetadata::Metrics", "[metrics]")
+{
+    SECTION("Method Names")
+    {
+        auto [service, method]
+            = ::splitMethodName("/UMetadataAPI.V1.StationInformation/GetActiveStation");
+        CHECK(service == "UMetadataAPI.V1.StationInformation");
+        CHECK(method == "GetActiveStation");
+        std::tie(service, method) = ::splitMethodName("NoMethod");
+        CHECK(service == "NoMethod");
+        CHECK(method.empty());
+    }
+
+    SECTION("Without An Exporter")
+    {
+        // Recording is a no-op
+        ::Metrics metrics{"uMetadataServer"};
+        ::CacheStatistics cache;
+        metrics.addCache("ActiveStations", &cache);
+        REQUIRE_NOTHROW(metrics.recordRPC("Service", "Method", 0, 1));
+        REQUIRE_NOTHROW(metrics.addRejectedRequest("Method", "concurrency"));
+        metrics.removeCache(&cache);
+    }
+
+    SECTION("Stand-In Collector")
+    {
+        auto received = std::make_shared<::Received> ();
+        // Export only when asked
+        ::MetricsExporter exporter{std::make_unique<::StandInCollector> (received),
+                                   std::chrono::hours {1},
+                                   std::chrono::seconds {5}};
+        ::Metrics metrics{"uMetadataServer"};
+        ::CacheStatistics cache;
+        cache.hits = 3;
+        cache.misses = 1;
+        metrics.addCache("ActiveStations", &cache);
+
+        const std::string service{"UMetadataAPI.V1.StationInformation"};
+        metrics.recordRPC(service, "GetActiveStation", 0, 1.5);
+        metrics.recordRPC(service, "GetActiveStation", 0, 2.5);
+        metrics.recordRPC(service, "GetActiveStation", 8, 0.5);
+        metrics.addActiveRequests("GetActiveStation", 2);
+        metrics.addActiveRequests("GetActiveStation", -1);
+        metrics.addResponseBytes("GetActiveStation", 100);
+        metrics.addResponseBytes("GetActiveStation", 28);
+        metrics.addRows("GetAllActiveStations", 55);
+        metrics.recordQuery("ActiveStationsSnapshot", 0.25);
+        metrics.recordSerialization("GetAllActiveStations", 0.01);
+        metrics.addRejectedRequest("GetAllActiveStations", "concurrency");
+        metrics.addRejectedRequest("GetAllActiveStations", "concurrency");
+        metrics.addRejectedRequest("GetActiveStation", "queue_time");
+        metrics.recordQueueTime("GetActiveStation", 2);
+        REQUIRE(exporter.forceFlush());
+
+        std::vector<opentelemetry::sdk::metrics::MetricData> exported;
+        {
+            const std::lock_guard<std::mutex> lock(received->mutex);
+            exported = received->metrics;
+        }
+        std::set<std::string> names;
+        for (const auto &metric : exported)
+        {
+            names.insert(metric.instrument_descriptor.name_);
+        }
+        const std::set<std::string> expectedNames{
+            "rpc.server.duration",
+            "umetadata.rpc.active_requests",
+            "umetadata.rpc.response.size",
+            "umetadata.rpc.rows",
+            "umetadata.db.query.duration",
+            "umetadata.serialization.duration",
+            "umetadata.rpc.rejected",
+            "umetadata.db.queue.duration",
+            "umetadata.cache.lookups"};
+        CHECK(names == expectedNames);
+
+        // RPC latency is split by service, method, and status code
+        auto metric = ::findMetric(exported, "rpc.server.duration");
+        REQUIRE(metric);
+        CHECK(metric->instrument_descriptor.unit_ == "ms");
+        REQUIRE(metric->point_data_attr_.size() == 2);
+        for (const auto &point : metric->point_data_attr_)
+        {
+            CHECK(::getString(point.attributes, "rpc.service") == service);
+            CHECK(::getString(point.attributes, "rpc.method")
+                  == "GetActiveStation");
+            const auto code
+                = opentelemetry::nostd::get<int64_t>
+                  (point.attributes.at("rpc.grpc.status_code"));
+            CHECK(::getCount(point) == (code == 0 ? 2 : 1));
+        }
+
+        metric = ::findMetric(exported, "umetadata.rpc.active_requests");
+        REQUIRE(metric);
+        REQUIRE(metric->point_data_attr_.size() == 1);
+        CHECK(::getSum(metric->point_data_attr_[0]) == 1);
+
+        metric = ::findMetric(exported, "umetadata.rpc.response.size");
+        REQUIRE(metric);
+        CHECK(metric->instrument_descriptor.unit_ == "By");
+        REQUIRE(metric->point_data_attr_.size() == 1);
+        CHECK(::getString(metric->point_data_attr_[0].attributes, "rpc.method")
+              == "GetActiveStation");
+        CHECK(::getSum(metric->point_data_attr_[0]) == 128);
+
+        metric = ::findMetric(exported, "umetadata.rpc.rows");
+        REQUIRE(metric);
+        REQUIRE(metric->point_data_attr_.size() == 1);
+        CHECK(::getSum(metric->point_data_attr_[0]) == 55);
+
+        metric = ::findMetric(exported, "umetadata.db.query.duration");
+        REQUIRE(metric);
+        REQUIRE(metric->point_data_attr_.size() == 1);
+        CHECK(::getString(metric->point_data_attr_[0].attributes, "operation")
+              == "ActiveStationsSnapshot");
+
+        metric = ::findMetric(exported, "umetadata.serialization.duration");
+        REQUIRE(metric);
+        REQUIRE(metric->point_data_attr_.size() == 1);
+        CHECK(::getString(metric->point_data_attr_[0].attributes, "operation")
+              == "GetAllActiveStations");
+
+        // Rejections are split by method and reason
+        metric = ::findMetric(exported, "umetadata.rpc.rejected");
+        REQUIRE(metric);
+        REQUIRE(metric->point_data_attr_.size() == 2);
+        for (const auto &point : metric->point_data_attr_)
+        {
+            const auto method = ::getString(point.attributes, "rpc.method");
+            const auto reason = ::getString(point.attributes, "reason");
+            if (method == "GetAllActiveStations")
+            {
+                CHECK(reason == "concurrency");
+                CHECK(::getSum(point) == 2);
+            }
+            else
+            {
+                CHECK(method == "GetActiveStation");
+                CHECK(reason == "queue_time");
+                CHECK(::getSum(point) == 1);
+            }
+        }
+
+        metric = ::findMetric(exported, "umetadata.db.queue.duration");
+        REQUIRE(metric);
+        REQUIRE(metric->point_data_attr_.size() == 1);
+        CHECK(::getCount(metric->point_data_attr_[0]) == 1);
+
+        // The caches are observed when the metrics are collected
+        metric = ::findMetric(exported, "umetadata.cache.lookups");
+        REQUIRE(metric);
+        REQUIRE(metric->point_data_attr_.size() == 2);
+        for (const auto &point : metric->point_data_attr_)
+        {
+            CHECK(::getString(point.attributes, "cache") == "ActiveStations");
+            const auto result = ::getString(point.attributes, "result");
+            CHECK(::getSum(point) == (result == "hit" ? 3 : 1));
+        }
+        metrics.removeCache(&cache);
+    }
+}
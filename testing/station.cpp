@@ -109,5 +109,15 @@ TEST_CASE("UMetadata::Station", "[station]")
         REQUIRE(sproto.getLastModified() ==
                 std::chrono::microseconds {lastModified});
     }
+
+    SECTION("Clear")
+    {
+        station.clear();
+        REQUIRE_THROWS(station.getNetwork());
+        REQUIRE_THROWS(station.getName());
+        REQUIRE(!station.getDescription());
+        REQUIRE_THROWS(station.getLatitude());
+        REQUIRE_THROWS(station.getStartAndEndTime());
+    }
 }
 
@@ -0,0 +1,161 @@
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <opentelemetry/nostd/span.h>
+#include <opentelemetry/sdk/common/exporter_utils.h>
+#include <opentelemetry/sdk/trace/exporter.h>
+#include <opentelemetry/sdk/trace/simple_processor_factory.h>
+#include <opentelemetry/sdk/trace/span_data.h>
+#include <opentelemetry/sdk/trace/tracer_provider_factory.h>
+#include <opentelemetry/trace/provider.h>
+#include "uMetadata/database.hpp"
+#include "uMetadata/station.hpp"
+#include "data/utah.hpp"
+#include <catch2/catch_test_macros.hpp>
+
+namespace
+{
+
+/// Holds the spans the stand-in collector received.
+struct Received
+{
+    std::mutex mutex;
+    std::vector<std::unique_ptr<opentelemetry::sdk::trace::SpanData>> spans;
+};
+
+/// @brief Stands in for an OTLP collector by keeping the spans it is sent.
+class StandInCollector final : public opentelemetry::sdk::trace::SpanExporter
+{
+public:
+    explicit StandInCollector(std::shared_ptr<Received> received) :
+        mReceived(std::move(received))
+    {
+    }
+    std::unique_ptr<opentelemetry::sdk::trace::Recordable>
+        MakeRecordable() noexcept override
+    {
+        return std::make_unique<opentelemetry::sdk::trace::SpanData> ();
+    }
+    opentelemetry::sdk::common::ExportResult Export(
+        const opentelemetry::nostd::span<
+           std::unique_ptr<opentelemetry::sdk::trace::Recordable>> &spans) noexcept override
+    {
+        const std::lock_guard<std::mutex> lock(mReceived->mutex);
+        for (auto &recordable : spans)
+        {
+            mReceived->spans.emplace_back(
+                static_cast<opentelemetry::sdk::trace::SpanData *>
+                (recordable.release()));
+        }
+        return opentelemetry::sdk::common::ExportResult::kSuccess;
+    }
+    bool ForceFlush(std::chrono::microseconds) noexcept override
+    {
+        return true;
+    }
+    bool Shutdown(std::chrono::microseconds) noexcept override
+    {
+        return true;
+    }
+private:
+    std::shared_ptr<Received> mReceived;
+};
+
+[[nodiscard]] std::string getString(
+    const opentelemetry::sdk::trace::SpanData &span,
+    const std::string &key)
+{
+    const auto &attributes = span.GetAttributes();
+    const auto value = attributes.find(key);
+    if (value == attributes.end()){return "";}
+    return opentelemetry::nostd::get<std::string> (value->second);
+}
+
+[[nodiscard]] int64_t getInteger(
+    const opentelemetry::sdk::trace::SpanData &span,
+    const std::string &key)
+{
+    return opentelemetry::nostd::get<int64_t> (span.GetAttributes().at(key));
+}
+
+}
+
+TEST_CASE("UMetadata::Database Tracing", "[tracing]")
+{
+    const std::filesystem::path databaseFile{"tracing.sqlite3"};
+    if (std::filesystem::exists(databaseFile))
+    {
+        std::filesystem::remove(databaseFile);
+    }
+    const auto stations = ::createStationsUtah();
+    {
+        UMetadata::Database writer{databaseFile, false};
+        writer.insert(stations);
+    }
+
+    // The database caches its tracer so install the provider first.  Every
+    // span is sampled and exported as soon as it ends.
+    auto received = std::make_shared<::Received> ();
+    std::shared_ptr<opentelemetry::trace::TracerProvider> provider
+        = opentelemetry::sdk::trace::TracerProviderFactory::Create(
+             opentelemetry::sdk::trace::SimpleSpanProcessorFactory::Create(
+                std::make_unique<::StandInCollector> (received)));
+    opentelemetry::trace::Provider::SetTracerProvider(provider);
+    {
+        constexpr bool readOnly{true};
+        const UMetadata::Database database{databaseFile, readOnly};
+        const auto active = database.getAllActiveStations();
+        REQUIRE(!active.empty());
+        const auto station
+            = database.getActiveStationInformation(active.at(0).getNetwork(),
+                                                   active.at(0).getName());
+        REQUIRE(station);
+
+        const std::lock_guard<std::mutex> lock(received->mutex);
+        const auto &spans = received->spans;
+        const auto findSpan = [&spans](const std::string &name)
+        {
+            return std::find_if(spans.begin(), spans.end(),
+                                [&name](const auto &span)
+                                {
+                                    return std::string {span->GetName()} == name;
+                                });
+        };
+        // Each query is a span with the rows it decoded
+        const auto query = findSpan("Database.getStationsActiveAt");
+        REQUIRE(query != spans.end());
+        CHECK(::getString(**query, "db.system") == "sqlite");
+        CHECK(::getString(**query, "db.operation") == "getStationsActiveAt");
+        CHECK(::getInteger(**query, "db.response.returned_rows")
+              == static_cast<int64_t> (active.size()));
+
+        const auto lookup = findSpan("Database.getActiveStationInformation");
+        REQUIRE(lookup != spans.end());
+        CHECK(::getString(**lookup, "db.operation")
+              == "getActiveStationInformation");
+        CHECK(::getInteger(**lookup, "db.response.returned_rows") == 1);
+
+        // The wait for a connection is a child of its query
+        const auto isChildOf = [](const auto &child, const auto &parent)
+        {
+            return child->GetParentSpanId() == parent->GetSpanId()
+                && child->GetTraceId() == parent->GetTraceId();
+        };
+        const auto acquires
+            = std::count_if(spans.begin(), spans.end(),
+                            [&](const auto &span)
+                            {
+                                return std::string {span->GetName()}
+                                       == "ConnectionPool.acquire"
+                                    && (isChildOf(span, *query)
+                                     || isChildOf(span, *lookup));
+                            });
+        CHECK(acquires == 2);
+    }
+    std::shared_ptr<opentelemetry::trace::TracerProvider> none;
+    opentelemetry::trace::Provider::SetTracerProvider(none);
+}